@@ -0,0 +1,68 @@
+// MIT License
+// Copyright (c) 2025 pezy
+
+// Wall time to reconnect a rack of devices serially with ble::ConnectDevice
+// versus pipelined with ble::ConnectDevices, against the in-process mock
+// BlueZ with simulated controller latency.
+//
+// Usage: batch_bench [devices] [latency_ms] [max_in_flight]   (defaults 50, 50, 16)
+
+#include <bluetooth/batch.hpp>
+#include <cstdio>
+#include <cstdlib>
+#include <iostream>
+#include <string>
+#include <vector>
+
+#include "bench_utils.hpp"
+#include "mock_bluez.hpp"
+
+int main(int argc, char* argv[]) {
+  const int devices = argc > 1 ? std::atoi(argv[1]) : 50;
+  const int latency_ms = argc > 2 ? std::atoi(argv[2]) : 50;
+  const size_t max_in_flight = argc > 3 ? static_cast<size_t>(std::atoi(argv[3])) : 16;
+
+  ble::bench::MockBluez mock;
+  mock.SetMethodLatency(std::chrono::milliseconds(latency_ms));
+  std::vector<std::string> macs;
+  for (int i = 0; i < devices; ++i) {
+    macs.push_back(ble::bench::SyntheticMac(static_cast<uint32_t>(i)));
+    mock.AddDevice({macs.back(), "bench-" + std::to_string(i)});
+  }
+
+  using ble::bench::Clock;
+  ble::Session session;
+  int failures = 0;
+
+  auto start = Clock::now();
+  for (const auto& mac : macs) {
+    failures += session.ConnectDevice(mac).hasError() ? 1 : 0;
+    failures += session.DisconnectDevice(mac).hasError() ? 1 : 0;
+  }
+  // Only the connect half of each pair counts towards the serial figure
+  const double serial_ms = std::chrono::duration<double, std::milli>(Clock::now() - start).count() / 2.0;
+
+  ble::BatchOptions options;
+  options.max_in_flight = max_in_flight;
+  start = Clock::now();
+  std::vector<ble::Result> results = ble::ConnectDevices(session, macs, options);
+  const double batch_ms = std::chrono::duration<double, std::milli>(Clock::now() - start).count();
+
+  ble::bench::LatencyStats per_device;
+  for (const auto& result : results) {
+    failures += result.hasError() ? 1 : 0;
+    per_device.Add(result.operation_time);
+  }
+
+  std::printf("%d devices, %d ms simulated controller latency, max_in_flight=%zu\n", devices, latency_ms,
+              max_in_flight);
+  std::printf("%-28s %.1f ms\n", "serial ConnectDevice", serial_ms);
+  std::printf("%-28s %.1f ms\n", "ConnectDevices", batch_ms);
+  per_device.Print("per-device operation_time");
+
+  if (failures != 0) {
+    std::cerr << "Error: " << failures << " operations failed\n";
+    return 1;
+  }
+  return 0;
+}
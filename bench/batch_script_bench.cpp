@@ -0,0 +1,93 @@
+// MIT License
+// Copyright (c) 2025 pezy
+
+// Startup amortization of ble --batch: a maintenance script of connects,
+// disconnects and listings, run once as one process per command (ble conn,
+// ble list) and once as a single ble --batch over the same script. The
+// difference is what process start, bus authentication and, for listings, the
+// tree download cost per command.
+//
+// Usage: batch_script_bench [devices] [commands] [latency_ms]   (defaults 100, 200, 5)
+
+#include <cstdio>
+#include <cstdlib>
+#include <fstream>
+#include <string>
+#include <vector>
+
+#include "bench_utils.hpp"
+#include "mock_bluez.hpp"
+
+namespace {
+
+using ble::bench::Clock;
+
+void Report(const char* name, Clock::duration elapsed, size_t commands, bool ok) {
+  const double millis = std::chrono::duration<double, std::milli>(elapsed).count();
+  std::printf("%-20s %9.1f ms total %7.2f ms/command%s\n", name, millis, millis / static_cast<double>(commands),
+              ok ? "" : "  (failures)");
+}
+
+}  // anonymous namespace
+
+int main(int argc, char* argv[]) {
+  const int devices = argc > 1 ? std::atoi(argv[1]) : 100;
+  const int commands = argc > 2 ? std::atoi(argv[2]) : 200;
+  const int latency_ms = argc > 3 ? std::atoi(argv[3]) : 5;
+
+  ble::bench::MockBluez mock;
+  std::vector<std::string> macs;
+  for (int i = 0; i < devices; ++i) {
+    macs.push_back(ble::bench::SyntheticMac(static_cast<uint32_t>(i)));
+    mock.AddDevice({macs.back(), "bench-" + std::to_string(i)});
+  }
+  mock.SetMethodLatency(std::chrono::milliseconds(latency_ms));
+
+  // Connect A, disconnect B, and a listing every tenth command
+  std::vector<std::vector<std::string>> script;
+  for (int i = 0; i < commands; ++i) {
+    const std::string& mac = macs[static_cast<size_t>(i / 2) % macs.size()];
+    if (i % 10 == 9) {
+      script.push_back({"list"});
+    } else if (i % 2 == 0) {
+      script.push_back({"conn", mac});
+    } else {
+      script.push_back({"conn", "-d", mac});
+    }
+  }
+
+  char script_path[] = "/tmp/batch-script-bench-XXXXXX";
+  const int fd = mkstemp(script_path);
+  if (fd < 0) {
+    std::perror("mkstemp");
+    return 1;
+  }
+  close(fd);
+  {
+    std::ofstream file(script_path);
+    for (const auto& command : script) {
+      for (size_t i = 0; i < command.size(); ++i) {
+        file << (i == 0 ? "" : " ") << command[i];
+      }
+      file << "\n";
+    }
+  }
+
+  std::printf("%zu commands over %d devices, %d ms per call\n", script.size(), devices, latency_ms);
+
+  bool ok = true;
+  auto start = Clock::now();
+  for (const auto& command : script) {
+    std::vector<std::string> argv{BLE_PATH};
+    argv.insert(argv.end(), command.begin(), command.end());
+    ok = ble::bench::RunCommand(argv) && ok;
+  }
+  Report("process per command", Clock::now() - start, script.size(), ok);
+
+  start = Clock::now();
+  ok = ble::bench::RunCommand({BLE_PATH, "--batch", script_path});
+  Report("ble --batch", Clock::now() - start, script.size(), ok);
+
+  unlink(script_path);
+  return 0;
+}
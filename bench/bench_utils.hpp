@@ -0,0 +1,90 @@
+// MIT License
+// Copyright (c) 2025 pezy
+
+#pragma once
+
+#include <algorithm>
+#include <chrono>
+#include <cstdio>
+#include <string>
+#include <vector>
+
+// sys
+#include <fcntl.h>
+#include <spawn.h>
+#include <sys/wait.h>
+#include <unistd.h>
+
+extern char** environ;
+
+namespace ble::bench {
+
+using Clock = std::chrono::steady_clock;
+
+// Collects per-operation latencies and prints a one-line summary
+class LatencyStats {
+ public:
+  void Add(Clock::duration latency) { samples_.push_back(latency); }
+
+  void Print(const std::string& label) {
+    if (samples_.empty()) {
+      std::printf("%-28s no samples\n", label.c_str());
+      return;
+    }
+
+    std::sort(samples_.begin(), samples_.end());
+    Clock::duration total{0};
+    for (const auto& sample : samples_) {
+      total += sample;
+    }
+
+    std::printf("%-28s n=%-6zu mean=%9.1fus p50=%9.1fus p99=%9.1fus max=%9.1fus\n", label.c_str(), samples_.size(),
+                Micros(total) / static_cast<double>(samples_.size()), Micros(Percentile(0.50)),
+                Micros(Percentile(0.99)), Micros(samples_.back()));
+  }
+
+  Clock::duration Percentile(double fraction) const {
+    const size_t index = static_cast<size_t>(fraction * static_cast<double>(samples_.size() - 1));
+    return samples_[index];
+  }
+
+ private:
+  static double Micros(Clock::duration duration) {
+    return std::chrono::duration<double, std::micro>(duration).count();
+  }
+
+  std::vector<Clock::duration> samples_;
+};
+
+// Formats a synthetic MAC address for the index-th mock device
+inline std::string SyntheticMac(uint32_t index) {
+  char mac[18];
+  std::snprintf(mac, sizeof(mac), "AA:BB:%02X:%02X:%02X:%02X", (index >> 24) & 0xFF, (index >> 16) & 0xFF,
+                (index >> 8) & 0xFF, index & 0xFF);
+  return mac;
+}
+
+// Runs the command with its output discarded and waits for it; false unless it exits with 0
+inline bool RunCommand(std::vector<std::string> args) {
+  std::vector<char*> argv;
+  for (auto& arg : args) {
+    argv.push_back(arg.data());
+  }
+  argv.push_back(nullptr);
+
+  posix_spawn_file_actions_t actions;
+  posix_spawn_file_actions_init(&actions);
+  posix_spawn_file_actions_addopen(&actions, STDOUT_FILENO, "/dev/null", O_WRONLY, 0);
+  posix_spawn_file_actions_addopen(&actions, STDERR_FILENO, "/dev/null", O_WRONLY, 0);
+  pid_t pid = 0;
+  const int spawned = posix_spawn(&pid, argv[0], &actions, nullptr, argv.data(), environ);
+  posix_spawn_file_actions_destroy(&actions);
+  if (spawned != 0) {
+    return false;
+  }
+  int status = 0;
+  waitpid(pid, &status, 0);
+  return WIFEXITED(status) && WEXITSTATUS(status) == 0;
+}
+
+}  // namespace ble::bench
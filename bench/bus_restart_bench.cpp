@@ -0,0 +1,126 @@
+// MIT License
+// Copyright (c) 2025 pezy
+
+// Bus restarts under load: chains of async connects and disconnects, each
+// issuing its next call from the completion callback on the session's
+// internal thread, run next to worker threads doing blocking listings. The
+// mock then restarts its dbus-daemon, so the session's connection closes
+// while calls are in flight and the next caller reopens it. A session that
+// waits on its internal thread while holding the connection lock stalls
+// here; the run reports how long each restart took to recover instead.
+//
+// Usage: bus_restart_bench [restarts] [chains] [workers]   (defaults 5, 32, 4)
+
+#include <bluetooth/session.hpp>
+#include <atomic>
+#include <chrono>
+#include <cstdio>
+#include <cstdlib>
+#include <memory>
+#include <string>
+#include <thread>
+#include <vector>
+
+#include "bench_utils.hpp"
+#include "mock_bluez.hpp"
+
+namespace {
+
+using ble::bench::Clock;
+
+struct Load {
+  std::atomic<bool> stop{false};
+  std::atomic<uint64_t> completed{0};
+  std::atomic<uint64_t> failed{0};
+  std::atomic<int> running_chains{0};
+};
+
+// Connect, disconnect, connect, ... until stopped; every step after the first is issued from the loop thread
+void Step(ble::Session& session, Load& load, const ble::DeviceAddress& device, bool connect) {
+  if (load.stop.load()) {
+    load.running_chains.fetch_sub(1);
+    return;
+  }
+  auto next = [&session, &load, device, connect](const ble::Result& result) {
+    load.completed.fetch_add(1);
+    if (result.hasError()) load.failed.fetch_add(1);
+    Step(session, load, device, !connect);
+  };
+  if (connect) {
+    session.ConnectDeviceAsync(device, next, 5);
+  } else {
+    session.DisconnectDeviceAsync(device, next, 5);
+  }
+}
+
+}  // anonymous namespace
+
+int main(int argc, char* argv[]) {
+  const int restarts = argc > 1 ? std::atoi(argv[1]) : 5;
+  const int chains = argc > 2 ? std::atoi(argv[2]) : 32;
+  const int workers = argc > 3 ? std::atoi(argv[3]) : 4;
+
+  ble::bench::MockBluez mock;
+  for (int i = 0; i < chains; ++i) {
+    mock.AddDevice({ble::bench::SyntheticMac(static_cast<uint32_t>(i)), "bench-" + std::to_string(i)});
+  }
+  mock.SetMethodLatency(std::chrono::milliseconds(5));
+
+  ble::Session session;
+  Load load;
+  load.running_chains = chains;
+  for (int i = 0; i < chains; ++i) {
+    Step(session, load, ble::DeviceAddress(ble::bench::SyntheticMac(static_cast<uint32_t>(i))), true);
+  }
+  std::vector<std::thread> threads;
+  for (int i = 0; i < workers; ++i) {
+    threads.emplace_back([&session, &load]() {
+      while (!load.stop.load()) {
+        load.completed.fetch_add(1);
+        if (session.GetPairedDevices().hasError()) load.failed.fetch_add(1);
+      }
+    });
+  }
+
+  std::printf("%d restarts, %d call chains, %d listing threads\n", restarts, chains, workers);
+  ble::bench::LatencyStats recovery;
+  for (int round = 0; round < restarts; ++round) {
+    std::this_thread::sleep_for(std::chrono::milliseconds(200));
+    const uint64_t before = load.completed.load();
+    const auto start = Clock::now();
+    mock.RestartBus();
+    // Recovered once a listing succeeds over the new connection
+    while (session.GetPairedDevices().hasError()) {
+      if (Clock::now() - start > std::chrono::seconds(10)) {
+        std::printf("restart %d: no recovery within 10 s, the session stalled\n", round + 1);
+        std::_Exit(1);
+      }
+      std::this_thread::sleep_for(std::chrono::milliseconds(1));
+    }
+    recovery.Add(Clock::now() - start);
+    std::this_thread::sleep_for(std::chrono::milliseconds(200));
+    if (load.completed.load() == before) {
+      std::printf("restart %d: no call completed afterwards, the session stalled\n", round + 1);
+      std::_Exit(1);
+    }
+  }
+
+  load.stop = true;
+  for (auto& thread : threads) {
+    thread.join();
+  }
+  const auto deadline = Clock::now() + std::chrono::seconds(10);
+  while (load.running_chains.load() > 0) {
+    if (Clock::now() > deadline) {
+      std::printf("%d call chains never finished, the session stalled\n", load.running_chains.load());
+      std::_Exit(1);
+    }
+    std::this_thread::sleep_for(std::chrono::milliseconds(1));
+  }
+
+  recovery.Print("recovery after restart");
+  std::printf("%llu calls, %llu failed (expected around each restart)\n",
+              static_cast<unsigned long long>(load.completed.load()),
+              static_cast<unsigned long long>(load.failed.load()));
+  return 0;
+}
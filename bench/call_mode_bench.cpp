@@ -0,0 +1,77 @@
+// MIT License
+// Copyright (c) 2025 pezy
+
+// Connect/Disconnect latency and bus round trips per operation for each
+// ble::CallMode, against the in-process mock BlueZ. Round trips are counted
+// as method calls received by the mock, so a proxy's GetAll shows up.
+//
+// Usage: call_mode_bench [cycles]   (default 10000)
+
+#include <bluetooth/session.hpp>
+#include <cstdio>
+#include <cstdlib>
+#include <iostream>
+
+#include "bench_utils.hpp"
+#include "mock_bluez.hpp"
+
+namespace {
+
+constexpr const char kDeviceMac[] = "AA:BB:CC:DD:EE:01";
+
+struct Mode {
+  const char* label;
+  ble::CallMode call_mode;
+  size_t device_proxy_cache_size;
+};
+
+}  // anonymous namespace
+
+int main(int argc, char* argv[]) {
+  const int cycles = argc > 1 ? std::atoi(argv[1]) : 10000;
+
+  ble::bench::MockBluez mock;
+  mock.AddDevice({kDeviceMac, "bench-device"});
+
+  const Mode modes[] = {
+      {"proxy, no cache", ble::CallMode::Proxy, 0},
+      {"proxy, cached", ble::CallMode::Proxy, 64},
+      {"direct", ble::CallMode::Direct, 0},
+  };
+
+  std::cout << cycles << " connect/disconnect cycles against mock BlueZ\n";
+  int failures = 0;
+  for (const Mode& mode : modes) {
+    ble::SessionOptions options;
+    options.call_mode = mode.call_mode;
+    options.device_proxy_cache_size = mode.device_proxy_cache_size;
+    ble::Session session(options);
+
+    // Warm the connection so only per-operation traffic is counted
+    failures += session.DisconnectDevice(kDeviceMac).hasError() ? 1 : 0;
+
+    using ble::bench::Clock;
+    ble::bench::LatencyStats stats;
+    const uint64_t calls_before = mock.method_calls();
+    for (int i = 0; i < cycles; ++i) {
+      auto start = Clock::now();
+      failures += session.ConnectDevice(kDeviceMac).hasError() ? 1 : 0;
+      stats.Add(Clock::now() - start);
+
+      start = Clock::now();
+      failures += session.DisconnectDevice(kDeviceMac).hasError() ? 1 : 0;
+      stats.Add(Clock::now() - start);
+    }
+    const double round_trips =
+        static_cast<double>(mock.method_calls() - calls_before) / static_cast<double>(2 * cycles);
+
+    stats.Print(mode.label);
+    std::printf("%-28s %.2f round trips/op\n", "", round_trips);
+  }
+
+  if (failures != 0) {
+    std::cerr << "Error: " << failures << " operations failed\n";
+    return 1;
+  }
+  return 0;
+}
@@ -0,0 +1,133 @@
+// MIT License
+// Copyright (c) 2025 pezy
+
+// Reconnect latency of a ConnectionKeeper: every kept device loses its link
+// in turn, and the time from the Connected false signal to connected again is
+// taken from the keeper's counters. A second pass makes a share of Connect
+// calls fail so that the backoff shows in the latency tail. The bus calls made
+// while all devices stay connected are compared with one GetPairedDevices poll.
+//
+// Usage: connection_keeper_bench [devices] [rounds] [latency_ms] [failure_rate]   (defaults 20, 10, 5, 0.3)
+
+#include <bluetooth/connection_keeper.hpp>
+#include <bluetooth/session.hpp>
+#include <chrono>
+#include <cstdint>
+#include <cstdio>
+#include <cstdlib>
+#include <string>
+#include <thread>
+#include <vector>
+
+#include "bench_utils.hpp"
+#include "mock_bluez.hpp"
+
+namespace {
+
+using ble::bench::Clock;
+
+// Waits until every kept device is connected with the given number of reconnects
+bool WaitForReconnects(const ble::ConnectionKeeper& keeper, uint64_t reconnects) {
+  const auto give_up = Clock::now() + std::chrono::seconds(30);
+  while (Clock::now() < give_up) {
+    bool done = true;
+    for (const auto& stats : keeper.Stats()) {
+      done = done && stats.connected && stats.reconnects >= reconnects;
+    }
+    if (done) {
+      return true;
+    }
+    std::this_thread::sleep_for(std::chrono::milliseconds(1));
+  }
+  std::printf("timed out waiting for reconnects\n");
+  return false;
+}
+
+struct Totals {
+  uint64_t drops{0};
+  uint64_t attempts{0};
+  std::chrono::milliseconds disconnected{0};
+};
+
+Totals Sum(const ble::ConnectionKeeper& keeper) {
+  Totals totals;
+  for (const auto& stats : keeper.Stats()) {
+    totals.drops += stats.drops;
+    totals.attempts += stats.reconnect_attempts;
+    totals.disconnected += stats.time_disconnected;
+  }
+  return totals;
+}
+
+void RunRounds(const char* name, ble::bench::MockBluez& mock, ble::ConnectionKeeper& keeper,
+               const std::vector<std::string>& macs, int rounds, uint64_t& reconnects) {
+  const Totals before = Sum(keeper);
+  ble::bench::LatencyStats latency;
+  for (int round = 0; round < rounds; ++round) {
+    for (const auto& mac : macs) {
+      mock.DropConnection(mac);
+    }
+    if (!WaitForReconnects(keeper, ++reconnects)) {
+      return;
+    }
+    for (const auto& stats : keeper.Stats()) {
+      latency.Add(stats.last_reconnect_latency);
+    }
+  }
+
+  const Totals after = Sum(keeper);
+  std::printf("%-16s drops=%llu attempts=%llu disconnected=%lldms\n", name,
+              static_cast<unsigned long long>(after.drops - before.drops),
+              static_cast<unsigned long long>(after.attempts - before.attempts),
+              static_cast<long long>((after.disconnected - before.disconnected).count()));
+  latency.Print("  reconnect latency");
+}
+
+}  // anonymous namespace
+
+int main(int argc, char* argv[]) {
+  const int devices = argc > 1 ? std::atoi(argv[1]) : 20;
+  const int rounds = argc > 2 ? std::atoi(argv[2]) : 10;
+  const int latency_ms = argc > 3 ? std::atoi(argv[3]) : 5;
+  const double failure_rate = argc > 4 ? std::atof(argv[4]) : 0.3;
+
+  ble::bench::MockBluez mock;
+  std::vector<std::string> macs;
+  for (int i = 0; i < devices; ++i) {
+    macs.push_back(ble::bench::SyntheticMac(static_cast<uint32_t>(i)));
+    mock.AddDevice({macs.back(), "bench-" + std::to_string(i)});
+  }
+  mock.SetMethodLatency(std::chrono::milliseconds(latency_ms));
+
+  std::printf("%d devices, %d drops each, %d ms per connect\n", devices, rounds, latency_ms);
+
+  ble::Session session;
+  ble::KeeperOptions options;
+  options.initial_backoff = std::chrono::milliseconds(20);
+  options.max_backoff = std::chrono::milliseconds(500);
+  ble::ConnectionKeeper keeper(session, options);
+  for (const auto& mac : macs) {
+    keeper.Add(ble::DeviceAddress(mac));
+  }
+  uint64_t reconnects = 0;
+  if (!WaitForReconnects(keeper, reconnects)) {
+    return 1;
+  }
+
+  // No drops, no calls: the keeper only listens
+  const uint64_t idle_before = mock.method_calls();
+  std::this_thread::sleep_for(std::chrono::seconds(1));
+  const uint64_t idle_calls = mock.method_calls() - idle_before;
+  const uint64_t poll_before = mock.method_calls();
+  session.GetPairedDevices();
+  std::printf("bus calls while idle for 1s: %llu (one GetPairedDevices poll: %llu)\n",
+              static_cast<unsigned long long>(idle_calls),
+              static_cast<unsigned long long>(mock.method_calls() - poll_before));
+
+  RunRounds("clean drops", mock, keeper, macs, rounds, reconnects);
+  mock.SetConnectFailureRate(failure_rate);
+  char name[32];
+  std::snprintf(name, sizeof(name), "%.0f%% failing", failure_rate * 100);
+  RunRounds(name, mock, keeper, macs, rounds, reconnects);
+  return 0;
+}
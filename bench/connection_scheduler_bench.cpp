@@ -0,0 +1,96 @@
+// MIT License
+// Copyright (c) 2025 pezy
+
+// Connect throughput of ble::ConnectionScheduler as adapters are added,
+// against the in-process mock BlueZ behaving like real controllers: one
+// Connect attempt at a time per adapter, each taking the simulated latency,
+// and a cap on connections per adapter. Every device is known to every
+// adapter, so the scheduler is free to spread them.
+//
+// Usage: connection_scheduler_bench [devices] [latency_ms] [max_adapters] [max_connections]
+//        (defaults 48, 50, 4, 64); runs with 1, 2, 4, ... adapters up to max_adapters
+
+#include <bluetooth/batch.hpp>
+#include <bluetooth/connection_scheduler.hpp>
+#include <cstdio>
+#include <cstdlib>
+#include <iostream>
+#include <string>
+#include <vector>
+
+#include "bench_utils.hpp"
+#include "mock_bluez.hpp"
+
+int main(int argc, char* argv[]) {
+  const int devices = argc > 1 ? std::atoi(argv[1]) : 48;
+  const int latency_ms = argc > 2 ? std::atoi(argv[2]) : 50;
+  const int max_adapters = argc > 3 ? std::atoi(argv[3]) : 4;
+  const uint32_t max_connections = argc > 4 ? static_cast<uint32_t>(std::atoi(argv[4])) : 64;
+
+  ble::bench::MockBluez mock;
+  std::vector<std::string> adapters{"hci0"};
+  for (int i = 1; i < max_adapters; ++i) {
+    char address[18];
+    std::snprintf(address, sizeof(address), "00:1A:7D:DA:71:%02X", i);
+    adapters.push_back("hci" + std::to_string(i));
+    mock.AddAdapter(adapters.back(), address);
+  }
+
+  std::vector<std::string> macs;
+  for (int i = 0; i < devices; ++i) {
+    macs.push_back(ble::bench::SyntheticMac(static_cast<uint32_t>(i)));
+    for (const auto& adapter : adapters) {
+      mock.AddDevice({macs.back(), "bench-" + std::to_string(i), adapter});
+    }
+  }
+  mock.SetMethodLatency(std::chrono::milliseconds(latency_ms));
+  mock.SetControllerLimits(max_connections);
+
+  std::printf("%d devices, %d ms per connect, at most %u connections per adapter\n", devices, latency_ms,
+              max_connections);
+
+  using ble::bench::Clock;
+  ble::Session session;
+  double single_rate = 0;
+  for (int count = 1; count <= max_adapters; count *= 2) {
+    ble::SchedulerOptions options;
+    options.adapters.assign(adapters.begin(), adapters.begin() + count);
+    options.max_connections_per_adapter = max_connections;
+
+    std::vector<ble::DeviceResult> results;
+    double elapsed_ms;
+    std::vector<ble::AdapterLoad> load;
+    {
+      ble::ConnectionScheduler scheduler(session, options);
+      const auto start = Clock::now();
+      results = scheduler.ConnectAll(macs);
+      elapsed_ms = std::chrono::duration<double, std::milli>(Clock::now() - start).count();
+      load = scheduler.Load();
+    }
+
+    int failures = 0;
+    ble::bench::LatencyStats per_device;
+    for (const auto& result : results) {
+      failures += result.result.hasError() ? 1 : 0;
+      per_device.Add(result.result.operation_time);
+    }
+    const double rate = (devices - failures) * 1000.0 / elapsed_ms;
+    if (count == 1) {
+      single_rate = rate;
+    }
+
+    std::printf("%d adapter(s) %10.1f ms %8.1f connects/s %5.2fx  failures %d  per adapter:", count, elapsed_ms, rate,
+                single_rate > 0 ? rate / single_rate : 0.0, failures);
+    for (const auto& adapter : load) {
+      std::printf(" %s=%zu", adapter.adapter.c_str(), adapter.connected);
+    }
+    std::printf("\n");
+    per_device.Print("  connect latency");
+
+    if (ble::DisconnectAll(session).hasError()) {
+      std::cerr << "Error: DisconnectAll failed\n";
+      return 1;
+    }
+  }
+  return 0;
+}
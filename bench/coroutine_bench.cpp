@@ -0,0 +1,110 @@
+// MIT License
+// Copyright (c) 2025 pezy
+
+// Pair -> trust -> connect for many devices as concurrent coroutines on one
+// ble::Executor, against the in-process mock BlueZ with simulated controller
+// latency. A short blocking run of the same sequence gives the serial cost.
+//
+// Usage: coroutine_bench [sequences] [latency_ms] [blocking_sequences]
+//        (defaults 1000, 5, 20)
+
+#include <bluetooth/coroutine.hpp>
+#include <atomic>
+#include <cstdio>
+#include <cstdlib>
+#include <future>
+#include <iostream>
+#include <string>
+#include <vector>
+
+#include "bench_utils.hpp"
+#include "mock_bluez.hpp"
+
+namespace {
+
+using ble::bench::Clock;
+
+std::atomic<int> g_failures{0};
+
+ble::Task<Clock::duration> Provision(ble::Session& session, std::string mac_address) {
+  const auto start = Clock::now();
+
+  ble::Result result = co_await ble::Pair(session, mac_address);
+  if (!result.hasError()) {
+    result = co_await ble::Trust(session, mac_address);
+  }
+  if (!result.hasError()) {
+    result = co_await ble::Connect(session, mac_address);
+  }
+
+  if (result.hasError()) {
+    g_failures.fetch_add(1);
+  }
+  co_return Clock::now() - start;
+}
+
+bool ProvisionBlocking(ble::Session& session, const std::string& mac_address) {
+  ble::Result result = session.PairDevice(mac_address);
+  if (!result.hasError()) {
+    result = session.TrustDevice(mac_address);
+  }
+  if (!result.hasError()) {
+    result = session.ConnectDevice(mac_address);
+  }
+  return !result.hasError();
+}
+
+}  // anonymous namespace
+
+int main(int argc, char* argv[]) {
+  const int sequences = argc > 1 ? std::atoi(argv[1]) : 1000;
+  const int latency_ms = argc > 2 ? std::atoi(argv[2]) : 5;
+  const int blocking_sequences = argc > 3 ? std::atoi(argv[3]) : 20;
+
+  ble::bench::MockBluez mock;
+  mock.SetMethodLatency(std::chrono::milliseconds(latency_ms));
+  for (int i = 0; i < sequences + blocking_sequences; ++i) {
+    ble::bench::MockDevice device;
+    device.mac_address = ble::bench::SyntheticMac(static_cast<uint32_t>(i));
+    device.name = "bench-" + std::to_string(i);
+    device.paired = false;
+    mock.AddDevice(device);
+  }
+
+  ble::Session session;
+  ble::Executor executor(session);
+
+  ble::bench::LatencyStats coroutine_stats;
+  const auto coroutine_start = Clock::now();
+  std::vector<std::future<Clock::duration>> done;
+  done.reserve(sequences);
+  for (int i = 0; i < sequences; ++i) {
+    done.push_back(executor.Spawn(Provision(session, ble::bench::SyntheticMac(static_cast<uint32_t>(i)))));
+  }
+  for (auto& future : done) {
+    coroutine_stats.Add(future.get());
+  }
+  const auto coroutine_wall = Clock::now() - coroutine_start;
+
+  ble::bench::LatencyStats blocking_stats;
+  int blocking_failures = 0;
+  for (int i = sequences; i < sequences + blocking_sequences; ++i) {
+    const auto start = Clock::now();
+    blocking_failures += ProvisionBlocking(session, ble::bench::SyntheticMac(static_cast<uint32_t>(i))) ? 0 : 1;
+    blocking_stats.Add(Clock::now() - start);
+  }
+
+  const double wall_ms = std::chrono::duration<double, std::milli>(coroutine_wall).count();
+  std::printf("pair->trust->connect, %d ms simulated controller latency\n", latency_ms);
+  coroutine_stats.Print("coroutine sequence");
+  std::printf("%-28s %d sequences in %.1f ms (%.0f sequences/s) on one thread\n", "", sequences, wall_ms,
+              sequences / (wall_ms / 1000.0));
+  blocking_stats.Print("blocking sequence");
+
+  const int failures = g_failures.load() + blocking_failures;
+  if (failures != 0) {
+    std::cerr << "Error: " << failures << " sequences failed\n";
+    return 1;
+  }
+  return 0;
+}
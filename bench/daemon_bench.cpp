@@ -0,0 +1,107 @@
+// MIT License
+// Copyright (c) 2025 pezy
+
+// End-to-end latency of the ble_pair listing and of ble_conn, each run as a
+// fresh process the way scripts run them: once talking to BlueZ directly
+// (BLED_SOCKET points nowhere, so the clients fall back) and once through a
+// DaemonServer served from this process with a warm session and device cache.
+// The process numbers include exec, dynamic linking and, in direct mode, bus
+// authentication and the object tree download. A request from a client that
+// stays connected shows what the protocol itself costs.
+//
+// Usage: daemon_bench [runs] [devices]   (defaults 50, 100)
+
+#include <bluetooth/daemon.hpp>
+#include <bluetooth/device_cache.hpp>
+#include <bluetooth/session.hpp>
+#include <cstdio>
+#include <cstdlib>
+#include <string>
+#include <thread>
+#include <vector>
+
+#include "bench_utils.hpp"
+#include "mock_bluez.hpp"
+
+// sys
+#include <unistd.h>
+
+namespace {
+
+using ble::bench::Clock;
+
+void RunMode(const char* name, const std::string& socket_path, const std::string& mac, int runs) {
+  setenv("BLED_SOCKET", socket_path.c_str(), 1);
+
+  ble::bench::LatencyStats listing;
+  ble::bench::LatencyStats connection;
+  int failures = 0;
+  for (int i = 0; i < runs; ++i) {
+    auto start = Clock::now();
+    failures += ble::bench::RunCommand({BLE_PAIR_PATH}) ? 0 : 1;
+    listing.Add(Clock::now() - start);
+
+    // Alternates so that every run changes the connection state
+    std::vector<std::string> command{BLE_CONN_PATH, mac};
+    if (i % 2 == 1) command.push_back("-d");
+    start = Clock::now();
+    failures += ble::bench::RunCommand(command) ? 0 : 1;
+    connection.Add(Clock::now() - start);
+  }
+
+  std::printf("%s%s\n", name, failures ? " (some runs failed)" : "");
+  listing.Print("  ble_pair (listing)");
+  connection.Print("  ble_conn");
+}
+
+}  // anonymous namespace
+
+int main(int argc, char* argv[]) {
+  const int runs = argc > 1 ? std::atoi(argv[1]) : 50;
+  const int devices = argc > 2 ? std::atoi(argv[2]) : 100;
+
+  // Created before any session, so that the clients spawned later inherit its bus address
+  ble::bench::MockBluez mock;
+  for (int i = 0; i < devices; ++i) {
+    mock.AddDevice({ble::bench::SyntheticMac(static_cast<uint32_t>(i)), "bench-" + std::to_string(i)});
+  }
+  const std::string mac = ble::bench::SyntheticMac(0);
+
+  char directory[] = "/tmp/bled-bench-XXXXXX";
+  if (!mkdtemp(directory)) {
+    std::perror("mkdtemp");
+    return 1;
+  }
+  const std::string socket_path = std::string(directory) + "/bled.sock";
+
+  std::printf("%d runs per command, %d paired devices\n", runs, devices);
+  RunMode("direct", std::string(directory) + "/absent.sock", mac, runs);
+
+  {
+    ble::Session session;
+    ble::DeviceCache cache(session);
+    ble::DaemonServer server(session);
+    if (ble::Result listening = server.Listen(socket_path); listening.hasError()) {
+      std::printf("%s\n", listening.error_message.c_str());
+      return 1;
+    }
+    std::thread serving([&server]() { server.Run(); });
+
+    RunMode("through bled", socket_path, mac, runs);
+
+    ble::DaemonClient client(socket_path);
+    ble::bench::LatencyStats round_trip;
+    for (int i = 0; i < runs * 10; ++i) {
+      const auto start = Clock::now();
+      client.GetPairedDevices();
+      round_trip.Add(Clock::now() - start);
+    }
+    std::printf("connected client\n");
+    round_trip.Print("  GetPairedDevices");
+
+    server.Stop();
+    serving.join();
+  }
+  rmdir(directory);
+  return 0;
+}
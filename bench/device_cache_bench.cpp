@@ -0,0 +1,79 @@
+// MIT License
+// Copyright (c) 2025 pezy
+
+// GetPairedDevices latency over the bus versus from an attached
+// ble::DeviceCache, and the time for a mock InterfacesAdded to show up in the
+// cache, against the in-process mock BlueZ.
+//
+// Usage: device_cache_bench [devices] [queries]   (defaults 200, 1000)
+
+#include <bluetooth/device_cache.hpp>
+#include <cstdio>
+#include <cstdlib>
+#include <iostream>
+#include <string>
+
+#include "bench_utils.hpp"
+#include "mock_bluez.hpp"
+
+namespace {
+
+using ble::bench::Clock;
+
+// Returns the number of queries that failed or missed devices
+int RunQueries(ble::Session& session, int queries, size_t expected, ble::bench::LatencyStats& stats) {
+  int failures = 0;
+  for (int i = 0; i < queries; ++i) {
+    const auto start = Clock::now();
+    ble::DeviceQueryResult result = session.GetPairedDevices();
+    stats.Add(Clock::now() - start);
+    failures += result.hasError() || result.devices.size() != expected ? 1 : 0;
+  }
+  return failures;
+}
+
+}  // anonymous namespace
+
+int main(int argc, char* argv[]) {
+  const int devices = argc > 1 ? std::atoi(argv[1]) : 200;
+  const int queries = argc > 2 ? std::atoi(argv[2]) : 1000;
+
+  ble::bench::MockBluez mock;
+  for (int i = 0; i < devices; ++i) {
+    mock.AddDevice({ble::bench::SyntheticMac(static_cast<uint32_t>(i)), "bench-" + std::to_string(i)});
+  }
+
+  ble::Session session;
+  ble::bench::LatencyStats bus_stats;
+  ble::bench::LatencyStats cache_stats;
+  int failures = RunQueries(session, queries, static_cast<size_t>(devices), bus_stats);
+
+  ble::DeviceCache cache(session);
+  if (!cache.synced()) {
+    std::cerr << "Error: device cache failed to load\n";
+    return 1;
+  }
+  failures += RunQueries(session, queries, static_cast<size_t>(devices), cache_stats);
+
+  // Delta path: a new device must appear without a reload
+  const auto start = Clock::now();
+  mock.AddDevice({ble::bench::SyntheticMac(static_cast<uint32_t>(devices)), "bench-late"});
+  while (cache.GetPairedDevices().devices.size() != static_cast<size_t>(devices) + 1) {
+    if (Clock::now() - start > std::chrono::seconds(5)) {
+      std::cerr << "Error: InterfacesAdded never reached the cache\n";
+      return 1;
+    }
+  }
+  const double delta_us = std::chrono::duration<double, std::micro>(Clock::now() - start).count();
+
+  std::printf("%d paired devices, %d queries each\n", devices, queries);
+  bus_stats.Print("GetPairedDevices bus");
+  cache_stats.Print("GetPairedDevices cache");
+  std::printf("%-28s %.1f us\n", "InterfacesAdded to cache", delta_us);
+
+  if (failures != 0) {
+    std::cerr << "Error: " << failures << " queries failed\n";
+    return 1;
+  }
+  return 0;
+}
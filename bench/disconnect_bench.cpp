@@ -0,0 +1,100 @@
+// MIT License
+// Copyright (c) 2025 pezy
+
+// Shutdown time for a gateway full of connected devices: serial
+// ble::DisconnectDevice versus ble::DisconnectAll, with and without replies,
+// against the in-process mock BlueZ with simulated controller latency.
+//
+// Usage: disconnect_bench [devices] [latency_ms]   (defaults 50, 50)
+
+#include <bluetooth/batch.hpp>
+#include <cstdio>
+#include <cstdlib>
+#include <iostream>
+#include <string>
+#include <thread>
+#include <vector>
+
+#include "bench_utils.hpp"
+#include "mock_bluez.hpp"
+
+namespace {
+
+using ble::bench::Clock;
+
+double MillisecondsSince(Clock::time_point start) {
+  return std::chrono::duration<double, std::milli>(Clock::now() - start).count();
+}
+
+size_t ConnectedCount(ble::Session& session) {
+  size_t connected = 0;
+  for (const auto& device : session.GetPairedDevices().devices) {
+    connected += device.connected ? 1 : 0;
+  }
+  return connected;
+}
+
+}  // anonymous namespace
+
+int main(int argc, char* argv[]) {
+  const int devices = argc > 1 ? std::atoi(argv[1]) : 50;
+  const int latency_ms = argc > 2 ? std::atoi(argv[2]) : 50;
+
+  ble::bench::MockBluez mock;
+  std::vector<std::string> macs;
+  for (int i = 0; i < devices; ++i) {
+    ble::bench::MockDevice device{ble::bench::SyntheticMac(static_cast<uint32_t>(i)), "bench-" + std::to_string(i)};
+    device.connected = true;
+    macs.push_back(device.mac_address);
+    mock.AddDevice(device);
+  }
+  mock.SetMethodLatency(std::chrono::milliseconds(latency_ms));
+
+  ble::Session session;
+  int failures = 0;
+
+  auto start = Clock::now();
+  for (const auto& mac : macs) {
+    failures += session.DisconnectDevice(mac).hasError() ? 1 : 0;
+  }
+  const double serial_ms = MillisecondsSince(start);
+
+  for (const auto& result : ble::ConnectDevices(session, macs)) {
+    failures += result.hasError() ? 1 : 0;
+  }
+  start = Clock::now();
+  ble::DisconnectAllResult all = ble::DisconnectAll(session);
+  const double all_ms = MillisecondsSince(start);
+  failures += all.hasError() || all.devices.size() != macs.size() ? 1 : 0;
+  for (const auto& device : all.devices) {
+    failures += device.result.hasError() ? 1 : 0;
+  }
+
+  for (const auto& result : ble::ConnectDevices(session, macs)) {
+    failures += result.hasError() ? 1 : 0;
+  }
+  ble::DisconnectOptions no_reply;
+  no_reply.no_reply = true;
+  start = Clock::now();
+  all = ble::DisconnectAll(session, no_reply);
+  const double no_reply_ms = MillisecondsSince(start);
+  failures += all.hasError() || all.devices.size() != macs.size() ? 1 : 0;
+
+  // The calls were only sent; wait until the mock has applied all of them
+  while (ConnectedCount(session) != 0) {
+    std::this_thread::sleep_for(std::chrono::milliseconds(1));
+  }
+  const double no_reply_settled_ms = MillisecondsSince(start);
+
+  std::printf("%d connected devices, %d ms simulated controller latency\n", devices, latency_ms);
+  std::printf("%-32s %.1f ms\n", "serial DisconnectDevice", serial_ms);
+  std::printf("%-32s %.1f ms\n", "DisconnectAll", all_ms);
+  std::printf("%-32s %.1f ms\n", "DisconnectAll no_reply", no_reply_ms);
+  std::printf("%-32s %.1f ms\n", "DisconnectAll no_reply, settled", no_reply_settled_ms);
+
+  if (failures != 0) {
+    std::cerr << "Error: " << failures << " operations failed\n";
+    return 1;
+  }
+  return 0;
+}
@@ -0,0 +1,81 @@
+// MIT License
+// Copyright (c) 2025 pezy
+
+// Provisioning a rack with ble_conn: one process per device, as scripts did
+// before the list mode, against a single ble_conn --file run at several -j
+// values. Both connect and then disconnect every device; the real binaries run
+// against the mock, which sets the bus address they inherit.
+//
+// Usage: fanout_bench [devices] [latency_ms]   (defaults 200, 20)
+
+#include <cstdio>
+#include <cstdlib>
+#include <fstream>
+#include <string>
+#include <vector>
+
+#include "bench_utils.hpp"
+#include "mock_bluez.hpp"
+
+namespace {
+
+using ble::bench::Clock;
+
+void Report(const char* name, Clock::duration elapsed, int devices, bool ok) {
+  const double seconds = std::chrono::duration<double>(elapsed).count();
+  std::printf("%-24s %8.3f s %9.1f devices/s%s\n", name, seconds, 2 * devices / seconds, ok ? "" : "  (failures)");
+}
+
+}  // anonymous namespace
+
+int main(int argc, char* argv[]) {
+  const int devices = argc > 1 ? std::atoi(argv[1]) : 200;
+  const int latency_ms = argc > 2 ? std::atoi(argv[2]) : 20;
+
+  ble::bench::MockBluez mock;
+  std::vector<std::string> macs;
+  for (int i = 0; i < devices; ++i) {
+    macs.push_back(ble::bench::SyntheticMac(static_cast<uint32_t>(i)));
+    mock.AddDevice({macs.back(), "bench-" + std::to_string(i)});
+  }
+  mock.SetMethodLatency(std::chrono::milliseconds(latency_ms));
+
+  char list_path[] = "/tmp/fanout-bench-XXXXXX";
+  const int fd = mkstemp(list_path);
+  if (fd < 0) {
+    std::perror("mkstemp");
+    return 1;
+  }
+  close(fd);
+  {
+    std::ofstream list(list_path);
+    for (const auto& mac : macs) {
+      list << mac << "\n";
+    }
+  }
+
+  // Keeps a running bled out of the comparison
+  setenv("BLED_SOCKET", "/nonexistent/bled.sock", 1);
+  std::printf("%d devices, %d ms per call, connect then disconnect\n", devices, latency_ms);
+
+  bool ok = true;
+  auto start = Clock::now();
+  for (const auto& mac : macs) {
+    ok = ble::bench::RunCommand({BLE_CONN_PATH, mac}) && ok;
+  }
+  for (const auto& mac : macs) {
+    ok = ble::bench::RunCommand({BLE_CONN_PATH, mac, "-d"}) && ok;
+  }
+  Report("process per device", Clock::now() - start, devices, ok);
+
+  for (const int jobs : {1, 8, 32, 0}) {
+    start = Clock::now();
+    ok = ble::bench::RunCommand({BLE_CONN_PATH, "--file", list_path, "-j", std::to_string(jobs)});
+    ok = ble::bench::RunCommand({BLE_CONN_PATH, "--file", list_path, "-j", std::to_string(jobs), "-d"}) && ok;
+    const std::string name = "--file -j " + (jobs == 0 ? std::string("unlimited") : std::to_string(jobs));
+    Report(name.c_str(), Clock::now() - start, devices, ok);
+  }
+
+  unlink(list_path);
+  return 0;
+}
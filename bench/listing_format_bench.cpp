@@ -0,0 +1,109 @@
+// MIT License
+// Copyright (c) 2025 pezy
+
+// Formatting throughput of the ble_pair listing on a large tree: the former
+// field-by-field std::ostream loop against DeviceWriter in each --format,
+// both writing to /dev/null from one GetPairedDevices result. Names contain
+// spaces, commas and quotes, which the machine formats must escape. The
+// end-to-end part runs the real ble_pair binary per format.
+//
+// Usage: listing_format_bench [devices] [rounds]   (defaults 10000, 20)
+
+#include <bluetooth/session.hpp>
+#include <cstdio>
+#include <cstdlib>
+#include <fstream>
+#include <string>
+#include <vector>
+
+#include "bench_utils.hpp"
+#include "device_writer.hpp"
+#include "mock_bluez.hpp"
+
+namespace {
+
+using ble::bench::Clock;
+
+// The listing loop ble_pair used before DeviceWriter
+void WriteLegacy(std::ostream& out, const std::vector<ble::BluetoothDevice>& devices) {
+  for (const auto& device : devices) {
+    out << device.mac_address << " ";
+    if (device.device_name && !device.device_name->empty()) {
+      out << *device.device_name << " ";
+    } else {
+      out << "N/A ";
+    }
+    if (device.rssi) {
+      out << *device.rssi << "dBm ";
+    } else {
+      out << "N/A ";
+    }
+    out << (device.connected ? "Connected" : "Disconnected") << "\n";
+  }
+  out.flush();
+}
+
+void Report(const char* name, Clock::duration elapsed, size_t devices, int rounds) {
+  const double seconds = std::chrono::duration<double>(elapsed).count();
+  std::printf("%-24s %8.2f ms/listing %12.0f devices/s\n", name, seconds * 1000 / rounds,
+              static_cast<double>(devices) * rounds / seconds);
+}
+
+}  // anonymous namespace
+
+int main(int argc, char* argv[]) {
+  const int devices = argc > 1 ? std::atoi(argv[1]) : 10000;
+  const int rounds = argc > 2 ? std::atoi(argv[2]) : 20;
+
+  ble::bench::MockBluez mock;
+  for (int i = 0; i < devices; ++i) {
+    ble::bench::MockDevice device{ble::bench::SyntheticMac(static_cast<uint32_t>(i)),
+                                  "Sensor \"" + std::to_string(i) + "\", rack " + std::to_string(i / 40)};
+    device.device_class = 0x240404;
+    device.rssi = static_cast<int16_t>(-40 - i % 50);
+    device.connected = i % 3 == 0;
+    mock.AddDevice(device);
+  }
+
+  ble::Session session;
+  const ble::DeviceQueryResult result = session.GetPairedDevices();
+  if (result.hasError()) {
+    std::printf("%s\n", result.error_message.c_str());
+    return 1;
+  }
+  std::printf("%zu devices, %d listings per format\n", result.deviceCount(), rounds);
+
+  {
+    std::ofstream null_stream("/dev/null");
+    const auto start = Clock::now();
+    for (int round = 0; round < rounds; ++round) {
+      WriteLegacy(null_stream, result.devices);
+    }
+    Report("ostream (before)", Clock::now() - start, result.deviceCount(), rounds);
+  }
+
+  std::FILE* null_file = std::fopen("/dev/null", "w");
+  for (const char* name : {"text", "json", "ndjson", "csv"}) {
+    ble::cli::OutputFormat format = ble::cli::OutputFormat::Text;
+    ble::cli::ParseOutputFormat(name, &format);
+    const auto start = Clock::now();
+    for (int round = 0; round < rounds; ++round) {
+      ble::cli::DeviceWriter writer(null_file, format);
+      for (const auto& device : result.devices) {
+        writer.Write(device);
+      }
+    }
+    Report((std::string("DeviceWriter ") + name).c_str(), Clock::now() - start, result.deviceCount(), rounds);
+  }
+  std::fclose(null_file);
+
+  // Keeps a running bled out of the comparison
+  setenv("BLED_SOCKET", "/nonexistent/bled.sock", 1);
+  for (const char* name : {"text", "json", "ndjson", "csv"}) {
+    const auto start = Clock::now();
+    const bool ok = ble::bench::RunCommand({BLE_PAIR_PATH, "--format", name});
+    Report((std::string("ble_pair --format ") + name).c_str(), Clock::now() - start, result.deviceCount(), 1);
+    if (!ok) std::printf("  (failed)\n");
+  }
+  return 0;
+}
@@ -0,0 +1,926 @@
+// MIT License
+// Copyright (c) 2025 pezy
+
+#include "mock_bluez.hpp"
+
+// std
+#include <algorithm>
+#include <atomic>
+#include <cctype>
+#include <cstdio>
+#include <cstdlib>
+#include <functional>
+#include <deque>
+#include <future>
+#include <map>
+#include <optional>
+#include <random>
+#include <stdexcept>
+#include <thread>
+#include <vector>
+
+// sys
+#include <gio/gio.h>
+#include <glib.h>
+
+namespace ble::bench {
+
+namespace {
+
+constexpr const char kIntrospectionXml[] =
+    "<node>"
+    "  <interface name='org.freedesktop.DBus.ObjectManager'>"
+    "    <method name='GetManagedObjects'>"
+    "      <arg name='objects' type='a{oa{sa{sv}}}' direction='out'/>"
+    "    </method>"
+    "    <signal name='InterfacesAdded'>"
+    "      <arg name='object' type='o'/>"
+    "      <arg name='interfaces' type='a{sa{sv}}'/>"
+    "    </signal>"
+    "    <signal name='InterfacesRemoved'>"
+    "      <arg name='object' type='o'/>"
+    "      <arg name='interfaces' type='as'/>"
+    "    </signal>"
+    "  </interface>"
+    "  <interface name='org.bluez.Adapter1'>"
+    "    <method name='StartDiscovery'/>"
+    "    <method name='StopDiscovery'/>"
+    "    <method name='SetDiscoveryFilter'>"
+    "      <arg name='filter' type='a{sv}' direction='in'/>"
+    "    </method>"
+    "    <property name='Address' type='s' access='read'/>"
+    "    <property name='Powered' type='b' access='read'/>"
+    "    <property name='Discovering' type='b' access='read'/>"
+    "  </interface>"
+    "  <interface name='org.bluez.Device1'>"
+    "    <method name='Connect'/>"
+    "    <method name='Disconnect'/>"
+    "    <method name='Pair'/>"
+    "    <method name='CancelPairing'/>"
+    "    <property name='Address' type='s' access='read'/>"
+    "    <property name='Name' type='s' access='read'/>"
+    "    <property name='Class' type='u' access='read'/>"
+    "    <property name='RSSI' type='n' access='read'/>"
+    "    <property name='Paired' type='b' access='read'/>"
+    "    <property name='Connected' type='b' access='read'/>"
+    "    <property name='Trusted' type='b' access='readwrite'/>"
+    "    <property name='Adapter' type='o' access='read'/>"
+    "    <property name='UUIDs' type='as' access='read'/>"
+    "  </interface>"
+    "</node>";
+
+std::string DevicePath(const std::string& adapter, const std::string& mac_address) {
+  std::string path = "/org/bluez/" + adapter + "/dev_";
+  for (char c : mac_address) {
+    path += c == ':' ? '_' : static_cast<char>(std::toupper(c));
+  }
+  return path;
+}
+
+// Returns a floating a{sv} with every Device1 property
+GVariant* DeviceProperties(const MockDevice& device) {
+  const std::string adapter_path = "/org/bluez/" + device.adapter;
+  GVariantBuilder builder;
+  g_variant_builder_init(&builder, G_VARIANT_TYPE_VARDICT);
+  g_variant_builder_add(&builder, "{sv}", "Address", g_variant_new_string(device.mac_address.c_str()));
+  g_variant_builder_add(&builder, "{sv}", "Name", g_variant_new_string(device.name.c_str()));
+  g_variant_builder_add(&builder, "{sv}", "Class", g_variant_new_uint32(device.device_class));
+  g_variant_builder_add(&builder, "{sv}", "RSSI", g_variant_new_int16(device.rssi));
+  g_variant_builder_add(&builder, "{sv}", "Paired", g_variant_new_boolean(device.paired));
+  g_variant_builder_add(&builder, "{sv}", "Connected", g_variant_new_boolean(device.connected));
+  g_variant_builder_add(&builder, "{sv}", "Trusted", g_variant_new_boolean(device.trusted));
+  g_variant_builder_add(&builder, "{sv}", "Adapter", g_variant_new_object_path(adapter_path.c_str()));
+  GVariantBuilder uuids;
+  g_variant_builder_init(&uuids, G_VARIANT_TYPE_STRING_ARRAY);
+  for (const auto& uuid : device.uuids) {
+    g_variant_builder_add(&uuids, "s", uuid.c_str());
+  }
+  g_variant_builder_add(&builder, "{sv}", "UUIDs", g_variant_builder_end(&uuids));
+  return g_variant_builder_end(&builder);
+}
+
+std::string AdapterPath(const std::string& adapter) { return "/org/bluez/" + adapter; }
+
+// Service UUID carried by every tenth flood device
+constexpr const char kFloodUuid[] = "0000180d-0000-1000-8000-00805f9b34fb";
+
+std::string FloodMac(uint32_t index) {
+  char mac[18];
+  std::snprintf(mac, sizeof(mac), "F0:0D:%02X:%02X:%02X:%02X", (index >> 24) & 0xFF, (index >> 16) & 0xFF,
+                (index >> 8) & 0xFF, index & 0xFF);
+  return mac;
+}
+
+// Subset of SetDiscoveryFilter the mock applies; Pathloss and Transport are accepted and ignored
+struct MockFilter {
+  std::optional<int16_t> rssi;
+  std::vector<std::string> uuids;
+  bool duplicate_data{true};
+  std::string pattern;
+
+  bool Matches(const MockDevice& device) const {
+    if (rssi && device.rssi < *rssi) {
+      return false;
+    }
+    if (!uuids.empty() && std::none_of(uuids.begin(), uuids.end(), [&device](const std::string& uuid) {
+          return std::find(device.uuids.begin(), device.uuids.end(), uuid) != device.uuids.end();
+        })) {
+      return false;
+    }
+    return pattern.empty() || device.mac_address.rfind(pattern, 0) == 0 || device.name.rfind(pattern, 0) == 0;
+  }
+};
+
+}  // anonymous namespace
+
+class MockBluez::Impl {
+ public:
+  Impl() {
+    bus_ = g_test_dbus_new(G_TEST_DBUS_NONE);
+    g_test_dbus_up(bus_);
+    // libble always talks to the system bus
+    g_setenv("DBUS_SYSTEM_BUS_ADDRESS", g_test_dbus_get_bus_address(bus_), TRUE);
+
+    GError* error = nullptr;
+    node_info_ = g_dbus_node_info_new_for_xml(kIntrospectionXml, &error);
+    if (!node_info_) {
+      std::string message = error ? error->message : "invalid introspection data";
+      if (error) g_error_free(error);
+      throw std::runtime_error(message);
+    }
+
+    context_ = g_main_context_new();
+    loop_ = g_main_loop_new(context_, FALSE);
+
+    std::promise<void> ready;
+    auto started = ready.get_future();
+    thread_ = std::thread([this, &ready]() { Run(&ready); });
+    try {
+      started.get();
+    } catch (...) {
+      thread_.join();
+      throw;
+    }
+  }
+
+  ~Impl() {
+    Invoke([this]() {
+      Unexport();
+      adapters_.clear();
+      devices_.clear();
+    });
+    g_main_loop_quit(loop_);
+    thread_.join();
+
+    g_object_unref(connection_);
+    g_main_loop_unref(loop_);
+    g_main_context_unref(context_);
+    g_dbus_node_info_unref(node_info_);
+    g_test_dbus_down(bus_);
+    g_object_unref(bus_);
+  }
+
+  void AddDevice(const MockDevice& device) {
+    Invoke([this, device]() { ExportDevice(device); });
+  }
+
+  void AddAdapter(const std::string& name, const std::string& address) {
+    Invoke([this, name, address]() {
+      const std::string path = AdapterPath(name);
+      if (adapters_.count(path) != 0) {
+        return;
+      }
+      RegisterAdapter(name, address);
+      auto it = adapters_.find(path);
+      if (it == adapters_.end()) {
+        return;
+      }
+
+      GVariantBuilder interfaces;
+      g_variant_builder_init(&interfaces, G_VARIANT_TYPE("a{sa{sv}}"));
+      g_variant_builder_add(&interfaces, "{s@a{sv}}", "org.bluez.Adapter1", AdapterProperties(it->second));
+      g_dbus_connection_emit_signal(connection_, nullptr, "/", "org.freedesktop.DBus.ObjectManager",
+                                    "InterfacesAdded", g_variant_new("(oa{sa{sv}})", path.c_str(), &interfaces),
+                                    nullptr);
+    });
+  }
+
+  void AddNearbyDevice(const MockDevice& device, std::chrono::milliseconds advertising_interval) {
+    Invoke([this, device, advertising_interval]() {
+      auto it = adapters_.find(AdapterPath(device.adapter));
+      if (it == adapters_.end()) {
+        return;
+      }
+      it->second.nearby.push_back({device, static_cast<guint>(advertising_interval.count())});
+      if (it->second.discovering) {
+        ScheduleAdvertisement(&it->second, it->second.nearby.back());
+      }
+    });
+  }
+
+  void StartAdvertisementFlood(uint32_t devices, uint32_t advertisements_per_second) {
+    Invoke([this, devices, advertisements_per_second]() {
+      StopFlood();
+      for (uint32_t i = 0; i < devices; ++i) {
+        MockDevice device{FloodMac(i), "flood-" + std::to_string(i)};
+        device.paired = false;
+        if (i % 10 == 0) {
+          device.uuids.push_back(kFloodUuid);
+        }
+        ExportDevice(device);
+      }
+
+      flood_.devices = devices;
+      flood_.per_tick = std::max<uint32_t>(1, advertisements_per_second / 1000);
+      flood_.next = 0;
+      flood_.last_reported.assign(devices, 0);
+      flood_.source = g_timeout_source_new(1);
+      g_source_set_callback(
+          flood_.source,
+          [](gpointer data) -> gboolean {
+            static_cast<Impl*>(data)->FloodTick();
+            return G_SOURCE_CONTINUE;
+          },
+          this, nullptr);
+      g_source_attach(flood_.source, context_);
+    });
+  }
+
+  void StopAdvertisementFlood() {
+    Invoke([this]() { StopFlood(); });
+  }
+
+  void RemoveDevice(const std::string& mac_address, const std::string& adapter) {
+    Invoke([this, path = DevicePath(adapter, mac_address)]() {
+      auto it = devices_.find(path);
+      if (it == devices_.end()) {
+        return;
+      }
+      g_dbus_connection_unregister_object(connection_, it->second.registration_id);
+      devices_.erase(it);
+
+      const char* removed[] = {"org.bluez.Device1", nullptr};
+      g_dbus_connection_emit_signal(connection_, nullptr, "/", "org.freedesktop.DBus.ObjectManager",
+                                    "InterfacesRemoved",
+                                    g_variant_new("(o^as)", path.c_str(), removed), nullptr);
+    });
+  }
+
+  void DropConnection(const std::string& mac_address, const std::string& adapter) {
+    Invoke([this, path = DevicePath(adapter, mac_address)]() {
+      auto it = devices_.find(path);
+      if (it == devices_.end() || !it->second.device.connected) {
+        return;
+      }
+      it->second.device.connected = false;
+      EmitDeviceChanged(path, "Connected", g_variant_new_boolean(FALSE));
+    });
+  }
+
+  void SetDeviceRssi(const std::string& mac_address, int16_t rssi, const std::string& adapter) {
+    Invoke([this, rssi, path = DevicePath(adapter, mac_address)]() {
+      auto it = devices_.find(path);
+      if (it == devices_.end()) {
+        return;
+      }
+      it->second.device.rssi = rssi;
+      EmitDeviceChanged(path, "RSSI", g_variant_new_int16(rssi));
+    });
+  }
+
+  void RestartBus() {
+    Invoke([this]() {
+      Unexport();
+      g_dbus_connection_close_sync(connection_, nullptr, nullptr);
+      g_object_unref(connection_);
+      // stop rather than down: down waits for the process's g_bus_get singleton to go away
+      g_test_dbus_stop(bus_);
+      g_test_dbus_up(bus_);
+      g_setenv("DBUS_SYSTEM_BUS_ADDRESS", g_test_dbus_get_bus_address(bus_), TRUE);
+      GError* error = nullptr;
+      if (!Connect(&error)) {
+        std::fprintf(stderr, "mock bus restart failed: %s\n", error ? error->message : "unknown error");
+        std::abort();
+      }
+    });
+  }
+
+  void SetMethodLatency(std::chrono::milliseconds latency) { latency_ms_ = static_cast<guint>(latency.count()); }
+
+  void SetControllerLimits(uint32_t max_connections) { max_connections_ = max_connections; }
+
+  void SetConnectFailureRate(double probability) { connect_failures_ = probability; }
+
+  uint64_t method_calls() const { return method_calls_.load(); }
+
+  uint64_t signals_emitted() const { return signals_emitted_.load(); }
+
+ private:
+  struct DeviceEntry {
+    MockDevice device;
+    guint registration_id{0};
+  };
+
+  // Device that only becomes a BlueZ object once discovery picks up its advertisement
+  struct NearbyDevice {
+    MockDevice device;
+    guint advertising_interval_ms;
+  };
+
+  // Method reply held back to simulate controller latency
+  struct PendingReply {
+    Impl* impl;
+    GDBusMethodInvocation* invocation;
+    std::string object_path;
+    std::string method_name;
+  };
+
+  struct AdapterEntry {
+    std::string name;
+    std::string address;
+    bool discovering{false};
+    std::vector<NearbyDevice> nearby;
+    std::vector<GSource*> advertisements;  // pending first sightings while discovering
+    guint registration_id{0};
+    MockFilter filter{};
+    std::deque<PendingReply*> connects{};  // Connect calls waiting for the controller, see SetControllerLimits
+    bool connecting{false};
+  };
+
+  // Advertisement flood on hci0, see StartAdvertisementFlood
+  struct Flood {
+    uint32_t devices{0};
+    uint32_t per_tick{0};
+    uint64_t next{0};
+    std::vector<int16_t> last_reported;  // per device, for DuplicateData=false
+    GSource* source{nullptr};
+  };
+
+  // First advertisement of a nearby device seen after discovery started
+  struct Advertisement {
+    Impl* impl;
+    MockDevice device;
+  };
+
+  void Run(std::promise<void>* ready) {
+    g_main_context_push_thread_default(context_);
+
+    GError* error = nullptr;
+    if (!Connect(&error)) {
+      ready->set_exception(std::make_exception_ptr(std::runtime_error(error->message)));
+      g_error_free(error);
+      g_main_context_pop_thread_default(context_);
+      return;
+    }
+
+    ready->set_value();
+    g_main_loop_run(loop_);
+    g_main_context_pop_thread_default(context_);
+  }
+
+  // Opens connection_ to the bus, exports the root, hci0 when new and every
+  // known object, and owns org.bluez. Mock thread only.
+  bool Connect(GError** error) {
+    connection_ = g_dbus_connection_new_for_address_sync(
+        g_test_dbus_get_bus_address(bus_),
+        static_cast<GDBusConnectionFlags>(G_DBUS_CONNECTION_FLAGS_AUTHENTICATION_CLIENT |
+                                          G_DBUS_CONNECTION_FLAGS_MESSAGE_BUS_CONNECTION),
+        nullptr, nullptr, error);
+    if (!connection_) {
+      return false;
+    }
+
+    g_dbus_connection_add_filter(connection_, &Impl::CountMethodCalls, this, nullptr);
+
+    static const GDBusInterfaceVTable root_vtable = {&Impl::OnRootMethodCall, nullptr, nullptr, {nullptr}};
+    root_registration_id_ = g_dbus_connection_register_object(
+        connection_, "/", g_dbus_node_info_lookup_interface(node_info_, "org.freedesktop.DBus.ObjectManager"),
+        &root_vtable, this, nullptr, nullptr);
+    if (adapters_.empty()) {
+      RegisterAdapter("hci0", "00:1A:7D:DA:71:00");
+    }
+    for (auto& [path, adapter] : adapters_) {
+      adapter.registration_id = RegisterAdapterObject(path);
+    }
+    for (auto& [path, entry] : devices_) {
+      entry.registration_id = RegisterDeviceObject(path, nullptr);
+    }
+
+    // Request the name synchronously so the mock is reachable once this returns
+    GVariant* reply = g_dbus_connection_call_sync(connection_, "org.freedesktop.DBus", "/org/freedesktop/DBus",
+                                                  "org.freedesktop.DBus", "RequestName",
+                                                  g_variant_new("(su)", "org.bluez", 0x4), G_VARIANT_TYPE("(u)"),
+                                                  G_DBUS_CALL_FLAGS_NONE, -1, nullptr, error);
+    if (!reply) {
+      return false;
+    }
+    g_variant_unref(reply);
+    return true;
+  }
+
+  // Mock thread only
+  void Unexport() {
+    StopFlood();
+    for (auto& entry : devices_) {
+      g_dbus_connection_unregister_object(connection_, entry.second.registration_id);
+    }
+    for (auto& entry : adapters_) {
+      if (entry.second.discovering) {
+        SetDiscovering(entry.first, &entry.second, false);
+      }
+      g_dbus_connection_unregister_object(connection_, entry.second.registration_id);
+    }
+    g_dbus_connection_unregister_object(connection_, root_registration_id_);
+  }
+
+  guint RegisterAdapterObject(const std::string& path) {
+    static const GDBusInterfaceVTable vtable = {&Impl::OnAdapterMethodCall, &Impl::OnGetAdapterProperty, nullptr,
+                                                {nullptr}};
+    return g_dbus_connection_register_object(connection_, path.c_str(),
+                                             g_dbus_node_info_lookup_interface(node_info_, "org.bluez.Adapter1"),
+                                             &vtable, this, nullptr, nullptr);
+  }
+
+  guint RegisterDeviceObject(const std::string& path, GError** error) {
+    static const GDBusInterfaceVTable vtable = {&Impl::OnDeviceMethodCall, &Impl::OnGetDeviceProperty,
+                                                &Impl::OnSetDeviceProperty, {nullptr}};
+    return g_dbus_connection_register_object(connection_, path.c_str(),
+                                             g_dbus_node_info_lookup_interface(node_info_, "org.bluez.Device1"),
+                                             &vtable, this, nullptr, error);
+  }
+
+  void RegisterAdapter(const std::string& name, const std::string& address) {
+    const std::string path = AdapterPath(name);
+    guint id = RegisterAdapterObject(path);
+    if (id) {
+      adapters_[path] = AdapterEntry{name, address, false, {}, {}, id};
+    }
+  }
+
+  void ExportDevice(const MockDevice& device) {
+    const std::string path = DevicePath(device.adapter, device.mac_address);
+    if (devices_.count(path) != 0) {
+      return;
+    }
+
+    GError* error = nullptr;
+    guint id = RegisterDeviceObject(path, &error);
+    if (!id) {
+      g_error_free(error);
+      return;
+    }
+    devices_[path] = DeviceEntry{device, id};
+
+    GVariantBuilder interfaces;
+    g_variant_builder_init(&interfaces, G_VARIANT_TYPE("a{sa{sv}}"));
+    g_variant_builder_add(&interfaces, "{s@a{sv}}", "org.bluez.Device1", DeviceProperties(device));
+    g_dbus_connection_emit_signal(connection_, nullptr, "/", "org.freedesktop.DBus.ObjectManager", "InterfacesAdded",
+                                  g_variant_new("(oa{sa{sv}})", path.c_str(), &interfaces), nullptr);
+  }
+
+  // The device shows up one advertising interval after discovery started
+  void ScheduleAdvertisement(AdapterEntry* adapter, const NearbyDevice& nearby) {
+    GSource* source = g_timeout_source_new(nearby.advertising_interval_ms);
+    g_source_set_callback(
+        source,
+        [](gpointer data) -> gboolean {
+          auto* advertisement = static_cast<Advertisement*>(data);
+          advertisement->impl->ExportDevice(advertisement->device);
+          return G_SOURCE_REMOVE;
+        },
+        new Advertisement{this, nearby.device}, [](gpointer data) { delete static_cast<Advertisement*>(data); });
+    g_source_attach(source, context_);
+    adapter->advertisements.push_back(source);
+  }
+
+  void SetDiscovering(const std::string& path, AdapterEntry* adapter, bool discovering) {
+    adapter->discovering = discovering;
+    if (discovering) {
+      for (const auto& nearby : adapter->nearby) {
+        ScheduleAdvertisement(adapter, nearby);
+      }
+    } else {
+      for (GSource* source : adapter->advertisements) {
+        g_source_destroy(source);
+        g_source_unref(source);
+      }
+      adapter->advertisements.clear();
+    }
+
+    GVariantBuilder changed;
+    g_variant_builder_init(&changed, G_VARIANT_TYPE_VARDICT);
+    g_variant_builder_add(&changed, "{sv}", "Discovering", g_variant_new_boolean(discovering));
+    g_dbus_connection_emit_signal(connection_, nullptr, path.c_str(), "org.freedesktop.DBus.Properties",
+                                  "PropertiesChanged",
+                                  g_variant_new("(sa{sv}@as)", "org.bluez.Adapter1", &changed,
+                                                g_variant_new_strv(nullptr, 0)),
+                                  nullptr);
+  }
+
+  void StopFlood() {
+    if (flood_.source) {
+      g_source_destroy(flood_.source);
+      g_source_unref(flood_.source);
+      flood_.source = nullptr;
+    }
+  }
+
+  // One millisecond worth of advertisements, reported the way BlueZ would under the hci0 filter
+  void FloodTick() {
+    auto adapter = adapters_.find(AdapterPath("hci0"));
+    if (adapter == adapters_.end() || !adapter->second.discovering || flood_.devices == 0) {
+      return;
+    }
+
+    const MockFilter& filter = adapter->second.filter;
+    for (uint32_t i = 0; i < flood_.per_tick; ++i, ++flood_.next) {
+      const uint32_t index = static_cast<uint32_t>(flood_.next % flood_.devices);
+      const uint64_t round = flood_.next / flood_.devices;
+      // Each device's RSSI moves every fourth advertisement, so duplicates occur
+      const int16_t rssi = static_cast<int16_t>(-30 - static_cast<int>((index * 37 + (round / 4) * 5) % 70));
+
+      const std::string path = DevicePath("hci0", FloodMac(index));
+      auto it = devices_.find(path);
+      if (it == devices_.end()) {
+        continue;
+      }
+      MockDevice& device = it->second.device;
+      device.rssi = rssi;
+      if (!filter.Matches(device) || (!filter.duplicate_data && flood_.last_reported[index] == rssi)) {
+        continue;
+      }
+      flood_.last_reported[index] = rssi;
+      EmitDeviceChanged(path, "RSSI", g_variant_new_int16(rssi));
+    }
+  }
+
+  // Runs fn on the mock thread and waits for it
+  void Invoke(std::function<void()> fn) {
+    struct Call {
+      std::function<void()> fn;
+      std::promise<void> done;
+    } call{std::move(fn), {}};
+    auto done = call.done.get_future();
+    g_main_context_invoke(
+        context_,
+        [](gpointer data) -> gboolean {
+          auto* call = static_cast<Call*>(data);
+          call->fn();
+          call->done.set_value();
+          return G_SOURCE_REMOVE;
+        },
+        &call);
+    done.get();
+  }
+
+  void EmitDeviceChanged(const std::string& path, const char* property, GVariant* value) {
+    signals_emitted_.fetch_add(1, std::memory_order_relaxed);
+    GVariantBuilder changed;
+    g_variant_builder_init(&changed, G_VARIANT_TYPE_VARDICT);
+    g_variant_builder_add(&changed, "{sv}", property, value);
+    g_dbus_connection_emit_signal(connection_, nullptr, path.c_str(), "org.freedesktop.DBus.Properties",
+                                  "PropertiesChanged",
+                                  g_variant_new("(sa{sv}@as)", "org.bluez.Device1", &changed,
+                                                g_variant_new_strv(nullptr, 0)),
+                                  nullptr);
+  }
+
+  void CompleteDeviceMethod(const std::string& path, const std::string& method, GDBusMethodInvocation* invocation) {
+    auto it = devices_.find(path);
+    if (it == devices_.end()) {
+      g_dbus_method_invocation_return_dbus_error(invocation, "org.freedesktop.DBus.Error.UnknownObject",
+                                                 "Device removed");
+      return;
+    }
+
+    // Transient controller failure, as seen on busy radios
+    if (method == "Connect" && connect_failures_.load() > 0 &&
+        std::uniform_real_distribution<double>(0, 1)(random_) < connect_failures_.load()) {
+      g_dbus_method_invocation_return_dbus_error(invocation, "org.bluez.Error.Failed", "le-connection-abort-by-local");
+      return;
+    }
+
+    MockDevice& device = it->second.device;
+    if (method == "Connect" || method == "Disconnect") {
+      const bool connected = method == "Connect";
+      if (device.connected != connected) {
+        device.connected = connected;
+        EmitDeviceChanged(path, "Connected", g_variant_new_boolean(connected));
+      }
+    } else if (method == "Pair") {
+      if (device.paired) {
+        g_dbus_method_invocation_return_dbus_error(invocation, "org.bluez.Error.AlreadyExists", "Already Exists");
+        return;
+      }
+      device.paired = true;
+      EmitDeviceChanged(path, "Paired", g_variant_new_boolean(TRUE));
+    }
+    g_dbus_method_invocation_return_value(invocation, nullptr);
+  }
+
+  // Controllers carry out one connection attempt at a time
+  void QueueConnect(PendingReply* pending) {
+    const std::string adapter_path = pending->object_path.substr(0, pending->object_path.rfind('/'));
+    auto it = adapters_.find(adapter_path);
+    if (it == adapters_.end()) {
+      CompleteDeviceMethod(pending->object_path, pending->method_name, pending->invocation);
+      delete pending;
+      return;
+    }
+    it->second.connects.push_back(pending);
+    if (!it->second.connecting) {
+      StartNextConnect(adapter_path);
+    }
+  }
+
+  void StartNextConnect(const std::string& adapter_path) {
+    AdapterEntry& adapter = adapters_[adapter_path];
+    adapter.connecting = !adapter.connects.empty();
+    if (!adapter.connecting) {
+      return;
+    }
+
+    struct ConnectStep {
+      Impl* impl;
+      std::string adapter_path;
+    };
+    GSource* source = g_timeout_source_new(latency_ms_.load());
+    g_source_set_callback(
+        source,
+        [](gpointer data) -> gboolean {
+          auto* step = static_cast<ConnectStep*>(data);
+          AdapterEntry& adapter = step->impl->adapters_[step->adapter_path];
+          PendingReply* pending = adapter.connects.front();
+          adapter.connects.pop_front();
+          step->impl->CompleteConnect(step->adapter_path, pending);
+          delete pending;
+          step->impl->StartNextConnect(step->adapter_path);
+          delete step;
+          return G_SOURCE_REMOVE;
+        },
+        new ConnectStep{this, adapter_path}, nullptr);
+    g_source_attach(source, context_);
+    g_source_unref(source);
+  }
+
+  // Fails like a controller out of connection slots once max_connections devices are connected on the adapter
+  void CompleteConnect(const std::string& adapter_path, PendingReply* pending) {
+    auto device = devices_.find(pending->object_path);
+    if (device != devices_.end() && !device->second.device.connected) {
+      const std::string prefix = adapter_path + "/";
+      uint32_t connected = 0;
+      for (const auto& entry : devices_) {
+        if (entry.second.device.connected && entry.first.compare(0, prefix.size(), prefix) == 0) {
+          ++connected;
+        }
+      }
+      if (connected >= max_connections_.load()) {
+        g_dbus_method_invocation_return_dbus_error(pending->invocation, "org.bluez.Error.Failed",
+                                                   "le-connection-abort-by-local");
+        return;
+      }
+    }
+    CompleteDeviceMethod(pending->object_path, pending->method_name, pending->invocation);
+  }
+
+  // Runs on the GDBus worker thread for every message, before dispatch
+  static GDBusMessage* CountMethodCalls(GDBusConnection*, GDBusMessage* message, gboolean incoming,
+                                        gpointer user_data) {
+    if (incoming && g_dbus_message_get_message_type(message) == G_DBUS_MESSAGE_TYPE_METHOD_CALL) {
+      static_cast<Impl*>(user_data)->method_calls_.fetch_add(1, std::memory_order_relaxed);
+    }
+    return message;
+  }
+
+  static void OnRootMethodCall(GDBusConnection*, const gchar*, const gchar*, const gchar*, const gchar* method_name,
+                               GVariant*, GDBusMethodInvocation* invocation, gpointer user_data) {
+    auto* impl = static_cast<Impl*>(user_data);
+    if (g_strcmp0(method_name, "GetManagedObjects") != 0) {
+      g_dbus_method_invocation_return_dbus_error(invocation, "org.freedesktop.DBus.Error.UnknownMethod",
+                                                 "Unknown method");
+      return;
+    }
+
+    GVariantBuilder objects;
+    g_variant_builder_init(&objects, G_VARIANT_TYPE("a{oa{sa{sv}}}"));
+    for (const auto& entry : impl->adapters_) {
+      GVariantBuilder interfaces;
+      g_variant_builder_init(&interfaces, G_VARIANT_TYPE("a{sa{sv}}"));
+      g_variant_builder_add(&interfaces, "{s@a{sv}}", "org.bluez.Adapter1", AdapterProperties(entry.second));
+      g_variant_builder_add(&objects, "{oa{sa{sv}}}", entry.first.c_str(), &interfaces);
+    }
+    for (const auto& entry : impl->devices_) {
+      GVariantBuilder interfaces;
+      g_variant_builder_init(&interfaces, G_VARIANT_TYPE("a{sa{sv}}"));
+      g_variant_builder_add(&interfaces, "{s@a{sv}}", "org.bluez.Device1", DeviceProperties(entry.second.device));
+      g_variant_builder_add(&objects, "{oa{sa{sv}}}", entry.first.c_str(), &interfaces);
+    }
+    g_dbus_method_invocation_return_value(invocation, g_variant_new("(a{oa{sa{sv}}})", &objects));
+  }
+
+  // Returns a floating a{sv} with every Adapter1 property
+  static GVariant* AdapterProperties(const AdapterEntry& adapter) {
+    GVariantBuilder builder;
+    g_variant_builder_init(&builder, G_VARIANT_TYPE_VARDICT);
+    g_variant_builder_add(&builder, "{sv}", "Address", g_variant_new_string(adapter.address.c_str()));
+    g_variant_builder_add(&builder, "{sv}", "Powered", g_variant_new_boolean(TRUE));
+    g_variant_builder_add(&builder, "{sv}", "Discovering", g_variant_new_boolean(adapter.discovering));
+    return g_variant_builder_end(&builder);
+  }
+
+  static MockFilter ParseFilter(GVariant* parameters) {
+    MockFilter filter{};
+    GVariant* dict = g_variant_get_child_value(parameters, 0);
+    int16_t rssi;
+    if (g_variant_lookup(dict, "RSSI", "n", &rssi)) {
+      filter.rssi = rssi;
+    }
+    GVariantIter* uuids;
+    if (g_variant_lookup(dict, "UUIDs", "as", &uuids)) {
+      const char* uuid;
+      while (g_variant_iter_loop(uuids, "&s", &uuid)) {
+        filter.uuids.push_back(uuid);
+      }
+      g_variant_iter_free(uuids);
+    }
+    gboolean duplicate_data;
+    if (g_variant_lookup(dict, "DuplicateData", "b", &duplicate_data)) {
+      filter.duplicate_data = duplicate_data;
+    }
+    const char* pattern;
+    if (g_variant_lookup(dict, "Pattern", "&s", &pattern)) {
+      filter.pattern = pattern;
+    }
+    g_variant_unref(dict);
+    return filter;
+  }
+
+  // Single-client discovery semantics, as BlueZ applies them per bus client
+  static void OnAdapterMethodCall(GDBusConnection*, const gchar*, const gchar* object_path, const gchar*,
+                                  const gchar* method_name, GVariant* parameters, GDBusMethodInvocation* invocation,
+                                  gpointer user_data) {
+    auto* impl = static_cast<Impl*>(user_data);
+    auto it = impl->adapters_.find(object_path);
+    if (it == impl->adapters_.end()) {
+      g_dbus_method_invocation_return_dbus_error(invocation, "org.freedesktop.DBus.Error.UnknownObject",
+                                                 "Adapter removed");
+      return;
+    }
+
+    AdapterEntry& adapter = it->second;
+    if (g_strcmp0(method_name, "StartDiscovery") == 0) {
+      if (adapter.discovering) {
+        g_dbus_method_invocation_return_dbus_error(invocation, "org.bluez.Error.InProgress",
+                                                   "Operation already in progress");
+        return;
+      }
+      impl->SetDiscovering(it->first, &adapter, true);
+    } else if (g_strcmp0(method_name, "StopDiscovery") == 0) {
+      if (!adapter.discovering) {
+        g_dbus_method_invocation_return_dbus_error(invocation, "org.bluez.Error.Failed", "No discovery started");
+        return;
+      }
+      impl->SetDiscovering(it->first, &adapter, false);
+    } else if (g_strcmp0(method_name, "SetDiscoveryFilter") == 0) {
+      adapter.filter = ParseFilter(parameters);
+    }
+    g_dbus_method_invocation_return_value(invocation, nullptr);
+  }
+
+  static GVariant* OnGetAdapterProperty(GDBusConnection*, const gchar*, const gchar* object_path, const gchar*,
+                                        const gchar* property_name, GError** error, gpointer user_data) {
+    auto* impl = static_cast<Impl*>(user_data);
+    auto it = impl->adapters_.find(object_path);
+    if (it == impl->adapters_.end()) {
+      g_set_error(error, G_DBUS_ERROR, G_DBUS_ERROR_UNKNOWN_OBJECT, "Adapter removed");
+      return nullptr;
+    }
+
+    GVariant* properties = g_variant_ref_sink(AdapterProperties(it->second));
+    GVariant* value = g_variant_lookup_value(properties, property_name, nullptr);
+    g_variant_unref(properties);
+    return value;
+  }
+
+  static void OnDeviceMethodCall(GDBusConnection*, const gchar*, const gchar* object_path, const gchar*,
+                                 const gchar* method_name, GVariant*, GDBusMethodInvocation* invocation,
+                                 gpointer user_data) {
+    auto* impl = static_cast<Impl*>(user_data);
+    if (impl->max_connections_.load() != 0 && g_strcmp0(method_name, "Connect") == 0) {
+      impl->QueueConnect(new PendingReply{impl, invocation, object_path, method_name});
+      return;
+    }
+
+    const guint latency_ms = impl->latency_ms_.load();
+    if (latency_ms == 0) {
+      impl->CompleteDeviceMethod(object_path, method_name, invocation);
+      return;
+    }
+
+    // Reply later without blocking the mock loop, so concurrent callers overlap
+    auto* pending = new PendingReply{impl, invocation, object_path, method_name};
+    GSource* source = g_timeout_source_new(latency_ms);
+    g_source_set_callback(
+        source,
+        [](gpointer data) -> gboolean {
+          auto* pending = static_cast<PendingReply*>(data);
+          pending->impl->CompleteDeviceMethod(pending->object_path, pending->method_name, pending->invocation);
+          delete pending;
+          return G_SOURCE_REMOVE;
+        },
+        pending, nullptr);
+    g_source_attach(source, impl->context_);
+    g_source_unref(source);
+  }
+
+  static GVariant* OnGetDeviceProperty(GDBusConnection*, const gchar*, const gchar* object_path, const gchar*,
+                                       const gchar* property_name, GError** error, gpointer user_data) {
+    auto* impl = static_cast<Impl*>(user_data);
+    auto it = impl->devices_.find(object_path);
+    if (it == impl->devices_.end()) {
+      g_set_error(error, G_DBUS_ERROR, G_DBUS_ERROR_UNKNOWN_OBJECT, "Device removed");
+      return nullptr;
+    }
+
+    GVariant* properties = g_variant_ref_sink(DeviceProperties(it->second.device));
+    GVariant* value = g_variant_lookup_value(properties, property_name, nullptr);
+    g_variant_unref(properties);
+    return value;
+  }
+
+  static gboolean OnSetDeviceProperty(GDBusConnection*, const gchar*, const gchar* object_path, const gchar*,
+                                      const gchar* property_name, GVariant* value, GError** error,
+                                      gpointer user_data) {
+    auto* impl = static_cast<Impl*>(user_data);
+    auto it = impl->devices_.find(object_path);
+    if (it == impl->devices_.end() || g_strcmp0(property_name, "Trusted") != 0) {
+      g_set_error(error, G_DBUS_ERROR, G_DBUS_ERROR_ACCESS_DENIED, "Property is read-only");
+      return FALSE;
+    }
+
+    it->second.device.trusted = g_variant_get_boolean(value);
+    impl->EmitDeviceChanged(object_path, "Trusted", g_variant_new_boolean(it->second.device.trusted));
+    return TRUE;
+  }
+
+  GTestDBus* bus_{nullptr};
+  GDBusNodeInfo* node_info_{nullptr};
+  GMainContext* context_{nullptr};
+  GMainLoop* loop_{nullptr};
+  GDBusConnection* connection_{nullptr};
+  guint root_registration_id_{0};
+  std::thread thread_;
+  std::atomic<guint> latency_ms_{0};
+  std::atomic<uint32_t> max_connections_{0};
+  std::atomic<double> connect_failures_{0};
+  std::minstd_rand random_{42};  // touched only on the mock thread
+  std::atomic<uint64_t> method_calls_{0};
+  std::atomic<uint64_t> signals_emitted_{0};
+  Flood flood_;  // touched only on the mock thread
+  std::map<std::string, DeviceEntry> devices_;  // keyed by object path, touched only on the mock thread
+  std::map<std::string, AdapterEntry> adapters_;  // keyed by object path, touched only on the mock thread
+};
+
+MockBluez::MockBluez() : impl_(std::make_unique<Impl>()) {}
+
+MockBluez::~MockBluez() = default;
+
+void MockBluez::AddDevice(const MockDevice& device) { impl_->AddDevice(device); }
+
+void MockBluez::AddAdapter(const std::string& name, const std::string& address) { impl_->AddAdapter(name, address); }
+
+void MockBluez::AddNearbyDevice(const MockDevice& device, std::chrono::milliseconds advertising_interval) {
+  impl_->AddNearbyDevice(device, advertising_interval);
+}
+
+void MockBluez::StartAdvertisementFlood(uint32_t devices, uint32_t advertisements_per_second) {
+  impl_->StartAdvertisementFlood(devices, advertisements_per_second);
+}
+
+void MockBluez::StopAdvertisementFlood() { impl_->StopAdvertisementFlood(); }
+
+void MockBluez::RemoveDevice(const std::string& mac_address, const std::string& adapter) {
+  impl_->RemoveDevice(mac_address, adapter);
+}
+
+void MockBluez::DropConnection(const std::string& mac_address, const std::string& adapter) {
+  impl_->DropConnection(mac_address, adapter);
+}
+
+void MockBluez::SetDeviceRssi(const std::string& mac_address, int16_t rssi, const std::string& adapter) {
+  impl_->SetDeviceRssi(mac_address, rssi, adapter);
+}
+
+void MockBluez::RestartBus() { impl_->RestartBus(); }
+
+void MockBluez::SetMethodLatency(std::chrono::milliseconds latency) { impl_->SetMethodLatency(latency); }
+
+void MockBluez::SetControllerLimits(uint32_t max_connections) { impl_->SetControllerLimits(max_connections); }
+
+void MockBluez::SetConnectFailureRate(double probability) { impl_->SetConnectFailureRate(probability); }
+
+uint64_t MockBluez::method_calls() const { return impl_->method_calls(); }
+
+uint64_t MockBluez::signals_emitted() const { return impl_->signals_emitted(); }
+
+}  // namespace ble::bench
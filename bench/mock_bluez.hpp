@@ -0,0 +1,100 @@
+// MIT License
+// Copyright (c) 2025 pezy
+
+#pragma once
+
+#include <chrono>
+#include <cstdint>
+#include <memory>
+#include <string>
+#include <vector>
+
+namespace ble::bench {
+
+// Device exported by the mock
+struct MockDevice {
+  std::string mac_address;
+  std::string name;
+  std::string adapter{"hci0"};
+  uint32_t device_class{0};
+  int16_t rssi{-60};
+  bool paired{true};
+  bool connected{false};
+  bool trusted{false};
+  std::vector<std::string> uuids{};
+};
+
+// In-process stand-in for bluetoothd
+//
+// Starts a private dbus-daemon, points DBUS_SYSTEM_BUS_ADDRESS at it and owns
+// org.bluez there, so libble talks to the mock exactly as it would to BlueZ.
+// The service runs on its own thread and GMainContext. Create the mock before
+// the first libble call of the process.
+class MockBluez {
+ public:
+  MockBluez();
+  ~MockBluez();
+
+  MockBluez(const MockBluez&) = delete;
+  MockBluez& operator=(const MockBluez&) = delete;
+
+  // Exports another org.bluez.Adapter1, e.g. "hci1", and emits InterfacesAdded.
+  // hci0 (00:1A:7D:DA:71:00) always exists.
+  void AddAdapter(const std::string& name, const std::string& address);
+
+  // Exports the device below its adapter and emits InterfacesAdded
+  void AddDevice(const MockDevice& device);
+
+  // Device in radio range but unknown to BlueZ: it is exported, with
+  // InterfacesAdded, one advertising interval after discovery starts on its
+  // adapter.
+  void AddNearbyDevice(const MockDevice& device, std::chrono::milliseconds advertising_interval);
+
+  // Exports the given number of unpaired devices on hci0 (every tenth
+  // advertising the heart rate service) and, while hci0 discovers, emits RSSI
+  // PropertiesChanged for them at the given rate, filtered by the adapter's
+  // discovery filter as BlueZ would
+  void StartAdvertisementFlood(uint32_t devices, uint32_t advertisements_per_second);
+  void StopAdvertisementFlood();
+
+  // Removes the device and emits InterfacesRemoved
+  void RemoveDevice(const std::string& mac_address, const std::string& adapter = "hci0");
+
+  // Link loss: marks the connected device disconnected and emits Connected
+  // false, as bluetoothd does on a supervision timeout
+  void DropConnection(const std::string& mac_address, const std::string& adapter = "hci0");
+
+  // A new advertisement: updates RSSI and emits it, as bluetoothd does for
+  // devices it sees while discovering
+  void SetDeviceRssi(const std::string& mac_address, int16_t rssi, const std::string& adapter = "hci0");
+
+  // Replaces the private dbus-daemon with a new one at a new address and
+  // re-exports everything there: every client connection closes, and clients
+  // that reconnect through DBUS_SYSTEM_BUS_ADDRESS find the same objects
+  void RestartBus();
+
+  // Simulated controller latency applied to Device1 method replies
+  void SetMethodLatency(std::chrono::milliseconds latency);
+
+  // Makes every adapter behave like a controller: Connect attempts run one at
+  // a time per adapter, each taking the method latency, and fail with
+  // org.bluez.Error.Failed while max_connections devices are connected on it.
+  // 0, the default, restores overlapping and unlimited connects.
+  void SetControllerLimits(uint32_t max_connections);
+
+  // Fraction of Connect calls, 0 to 1, that fail with org.bluez.Error.Failed
+  // le-connection-abort-by-local before touching the device
+  void SetConnectFailureRate(double probability);
+
+  // Method calls received so far, including Properties.GetAll issued by proxies
+  uint64_t method_calls() const;
+
+  // Device PropertiesChanged signals emitted so far
+  uint64_t signals_emitted() const;
+
+ private:
+  class Impl;
+  std::unique_ptr<Impl> impl_;
+};
+
+}  // namespace ble::bench
@@ -0,0 +1,113 @@
+// MIT License
+// Copyright (c) 2025 pezy
+
+// PairDevice latency with the old pre-check (bus connection and full
+// GetManagedObjects, then a second connection for Pair) versus the
+// single-call path, for fresh and already-paired devices, against the
+// in-process mock BlueZ with a populated object tree.
+//
+// Usage: pair_bench [pairs] [background_devices]   (defaults 500, 200)
+
+#include <bluetooth/session.hpp>
+#include <cstdlib>
+#include <iostream>
+#include <string>
+
+// sys
+#include <gio/gio.h>
+
+#include "bench_utils.hpp"
+#include "mock_bluez.hpp"
+
+namespace {
+
+using ble::bench::Clock;
+
+std::string DevicePath(const std::string& mac_address) {
+  std::string path = "/org/bluez/hci0/dev_" + mac_address;
+  for (char& c : path) {
+    if (c == ':') c = '_';
+  }
+  return path;
+}
+
+// The pre-rework path: one connection to list every object, another to call Pair
+bool LegacyPairDevice(const std::string& mac_address) {
+  GError* error = nullptr;
+  for (int round = 0; round < 2; ++round) {
+    GDBusConnection* connection = g_bus_get_sync(G_BUS_TYPE_SYSTEM, nullptr, &error);
+    if (!connection) {
+      g_error_free(error);
+      return false;
+    }
+    GVariant* reply =
+        round == 0 ? g_dbus_connection_call_sync(connection, "org.bluez", "/", "org.freedesktop.DBus.ObjectManager",
+                                                 "GetManagedObjects", nullptr, nullptr, G_DBUS_CALL_FLAGS_NONE, -1,
+                                                 nullptr, &error)
+                   : g_dbus_connection_call_sync(connection, "org.bluez", DevicePath(mac_address).c_str(),
+                                                 "org.bluez.Device1", "Pair", nullptr, nullptr, G_DBUS_CALL_FLAGS_NONE,
+                                                 30000, nullptr, &error);
+    g_object_unref(connection);
+    if (!reply) {
+      g_error_free(error);
+      return false;
+    }
+    g_variant_unref(reply);
+  }
+  return true;
+}
+
+}  // anonymous namespace
+
+int main(int argc, char* argv[]) {
+  const int pairs = argc > 1 ? std::atoi(argv[1]) : 500;
+  const int background = argc > 2 ? std::atoi(argv[2]) : 200;
+
+  ble::bench::MockBluez mock;
+  uint32_t next = 0;
+  for (int i = 0; i < background; ++i, ++next) {
+    mock.AddDevice({ble::bench::SyntheticMac(next), "paired-" + std::to_string(i)});
+  }
+  auto add_unpaired = [&mock, &next]() {
+    ble::bench::MockDevice device{ble::bench::SyntheticMac(next++), "fresh"};
+    device.paired = false;
+    mock.AddDevice(device);
+    return device.mac_address;
+  };
+
+  ble::bench::LatencyStats legacy_stats;
+  ble::bench::LatencyStats fresh_stats;
+  ble::bench::LatencyStats already_stats;
+  int failures = 0;
+
+  // Legacy path first: once a session holds the bus singleton, g_bus_get_sync stops reconnecting
+  for (int i = 0; i < pairs; ++i) {
+    const std::string mac = add_unpaired();
+    const auto start = Clock::now();
+    failures += LegacyPairDevice(mac) ? 0 : 1;
+    legacy_stats.Add(Clock::now() - start);
+  }
+
+  ble::Session session;
+  for (int i = 0; i < pairs; ++i) {
+    const std::string mac = add_unpaired();
+    auto start = Clock::now();
+    failures += session.PairDevice(mac).hasError() ? 1 : 0;
+    fresh_stats.Add(Clock::now() - start);
+
+    // Second attempt hits AlreadyExists, which must still report success
+    start = Clock::now();
+    failures += session.PairDevice(mac).hasError() ? 1 : 0;
+    already_stats.Add(Clock::now() - start);
+  }
+
+  std::cout << pairs << " pairings, " << background << " other devices in the tree\n";
+  legacy_stats.Print("pre-check + Pair");
+  fresh_stats.Print("PairDevice");
+  already_stats.Print("PairDevice, already paired");
+  if (failures != 0) {
+    std::cerr << "Error: " << failures << " operations failed\n";
+    return 1;
+  }
+  return 0;
+}
@@ -0,0 +1,84 @@
+// MIT License
+// Copyright (c) 2025 pezy
+
+// IsDevicePaired latency as the number of devices BlueZ knows grows: the old
+// tree download plus linear scan, the single-object Paired read, and the
+// DeviceCache hash lookup, against the in-process mock BlueZ.
+//
+// Usage: paired_lookup_bench [queries]   (default 1000)
+
+#include <algorithm>
+#include <bluetooth/device_cache.hpp>
+#include <cstdio>
+#include <cstdlib>
+#include <iostream>
+#include <string>
+
+#include "bench_utils.hpp"
+#include "mock_bluez.hpp"
+
+namespace {
+
+using ble::bench::Clock;
+
+// The pre-index lookup: full GetManagedObjects and a string compare per device
+bool ScanIsDevicePaired(ble::Session& session, const std::string& mac_address) {
+  auto result = session.GetPairedDevices();
+  return std::find_if(result.devices.begin(), result.devices.end(), [&mac_address](const ble::BluetoothDevice& device) {
+           return device.mac_address == mac_address;
+         }) != result.devices.end();
+}
+
+template <typename Lookup>
+int Measure(int queries, const std::string& mac_address, Lookup lookup, ble::bench::LatencyStats& stats) {
+  int failures = 0;
+  for (int i = 0; i < queries; ++i) {
+    const auto start = Clock::now();
+    failures += lookup(mac_address) ? 0 : 1;
+    stats.Add(Clock::now() - start);
+  }
+  return failures;
+}
+
+}  // anonymous namespace
+
+int main(int argc, char* argv[]) {
+  const int queries = argc > 1 ? std::atoi(argv[1]) : 1000;
+
+  ble::bench::MockBluez mock;
+  ble::Session session;
+  int failures = 0;
+  uint32_t added = 0;
+
+  for (uint32_t devices : {10u, 100u, 1000u}) {
+    for (; added < devices; ++added) {
+      mock.AddDevice({ble::bench::SyntheticMac(added), "bench-" + std::to_string(added)});
+    }
+    // Look up the last device so the scan walks as far as it can
+    const std::string target = ble::bench::SyntheticMac(devices - 1);
+
+    ble::bench::LatencyStats scan_stats;
+    ble::bench::LatencyStats property_stats;
+    ble::bench::LatencyStats cache_stats;
+    failures += Measure(
+        queries, target, [&session](const std::string& mac) { return ScanIsDevicePaired(session, mac); }, scan_stats);
+    failures += Measure(
+        queries, target, [&session](const std::string& mac) { return session.IsDevicePaired(mac); }, property_stats);
+    {
+      ble::DeviceCache cache(session);
+      failures += Measure(
+          queries, target, [&cache](const std::string& mac) { return cache.IsDevicePaired(mac); }, cache_stats);
+    }
+
+    std::printf("%u devices\n", devices);
+    scan_stats.Print("  tree scan");
+    property_stats.Print("  Paired property");
+    cache_stats.Print("  DeviceCache index");
+  }
+
+  if (failures != 0) {
+    std::cerr << "Error: " << failures << " lookups failed\n";
+    return 1;
+  }
+  return 0;
+}
@@ -0,0 +1,79 @@
+// MIT License
+// Copyright (c) 2025 pezy
+
+// Success rate and latency of connecting a rack of devices when a share of
+// Connect calls fails transiently with le-connection-abort-by-local, without
+// and with a RetryPolicy. All devices start at once through ConnectDevices, so
+// the retries of devices that failed together show how far jitter spreads them.
+//
+// Usage: retry_bench [devices] [failure_rate] [latency_ms] [max_attempts]   (defaults 100, 0.3, 20, 5)
+
+#include <bluetooth/batch.hpp>
+#include <bluetooth/retry.hpp>
+#include <cstdio>
+#include <cstdlib>
+#include <iostream>
+#include <map>
+#include <string>
+#include <vector>
+
+#include "bench_utils.hpp"
+#include "mock_bluez.hpp"
+
+namespace {
+
+void Report(const char* name, const std::vector<ble::Result>& results) {
+  int failures = 0;
+  std::map<size_t, int> attempts;
+  ble::bench::LatencyStats total;
+  for (const auto& result : results) {
+    failures += result.hasError() ? 1 : 0;
+    ++attempts[result.attempts()];
+    total.Add(result.operation_time);
+  }
+
+  std::printf("%-16s %4d/%zu connected, attempts:", name, static_cast<int>(results.size()) - failures, results.size());
+  for (const auto& [count, devices] : attempts) {
+    std::printf(" %zux%d", count, devices);
+  }
+  std::printf("\n");
+  total.Print("  connect latency");
+}
+
+}  // anonymous namespace
+
+int main(int argc, char* argv[]) {
+  const int devices = argc > 1 ? std::atoi(argv[1]) : 100;
+  const double failure_rate = argc > 2 ? std::atof(argv[2]) : 0.3;
+  const int latency_ms = argc > 3 ? std::atoi(argv[3]) : 20;
+  const int max_attempts = argc > 4 ? std::atoi(argv[4]) : 5;
+
+  ble::bench::MockBluez mock;
+  std::vector<std::string> macs;
+  for (int i = 0; i < devices; ++i) {
+    macs.push_back(ble::bench::SyntheticMac(static_cast<uint32_t>(i)));
+    mock.AddDevice({macs.back(), "bench-" + std::to_string(i)});
+  }
+  mock.SetMethodLatency(std::chrono::milliseconds(latency_ms));
+  mock.SetConnectFailureRate(failure_rate);
+
+  std::printf("%d devices, %.0f%% of connects abort, %d ms per connect\n", devices, failure_rate * 100, latency_ms);
+
+  ble::BatchOptions batch;
+  batch.max_in_flight = 0;
+  {
+    ble::Session session;
+    Report("no retry", ble::ConnectDevices(session, macs, batch));
+    ble::DisconnectAll(session);
+  }
+  {
+    ble::SessionOptions options;
+    options.retry.max_attempts = max_attempts;
+    options.retry.initial_backoff = std::chrono::milliseconds(50);
+    options.retry.max_backoff = std::chrono::milliseconds(800);
+    ble::Session session(options);
+    Report("retry", ble::ConnectDevices(session, macs, batch));
+    ble::DisconnectAll(session);
+  }
+  return 0;
+}
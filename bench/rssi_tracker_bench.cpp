@@ -0,0 +1,89 @@
+// MIT License
+// Copyright (c) 2025 pezy
+
+// Update and query cost of ble::RssiTracker with synthetic advertisement
+// events, first with the writer alone, then with reader threads querying
+// random devices the whole time. No bus is involved.
+//
+// Usage: rssi_tracker_bench [devices] [updates] [readers]   (defaults 4096, 5000000, 2)
+
+#include <array>
+#include <atomic>
+#include <bluetooth/rssi_tracker.hpp>
+#include <cstdio>
+#include <cstdlib>
+#include <random>
+#include <thread>
+#include <vector>
+
+#include "bench_utils.hpp"
+
+namespace {
+
+// Writes updates events round-robin over devices, 10 ms apart per device, and returns the updates per second
+double RunWriter(ble::RssiTracker& tracker, uint32_t devices, uint64_t updates) {
+  std::mt19937 random(1);
+  std::normal_distribution<float> noise(0.0f, 4.0f);
+  std::vector<ble::AdvertisementEvent> batch(devices);
+
+  const auto start = ble::bench::Clock::now();
+  for (uint64_t done = 0; done < updates; done += devices) {
+    const int64_t timestamp_ns = static_cast<int64_t>(done / devices) * 10'000'000;
+    for (uint32_t i = 0; i < devices; ++i) {
+      batch[i] = ble::AdvertisementEvent{0xAABB00000000ull | i, timestamp_ns,
+                                         static_cast<int16_t>(-70 + noise(random)), ble::AdvertisementEvent::kRssi};
+    }
+    tracker.Update(batch);
+  }
+  const double seconds = std::chrono::duration<double>(ble::bench::Clock::now() - start).count();
+  return static_cast<double>(updates) / seconds;
+}
+
+}  // anonymous namespace
+
+int main(int argc, char* argv[]) {
+  const uint32_t devices = argc > 1 ? static_cast<uint32_t>(std::atoi(argv[1])) : 4096;
+  const uint64_t updates = argc > 2 ? static_cast<uint64_t>(std::atoll(argv[2])) : 5'000'000;
+  const int readers = argc > 3 ? std::atoi(argv[3]) : 2;
+
+  ble::RssiTrackerOptions options;
+  options.max_devices = devices;
+
+  {
+    ble::RssiTracker tracker(options);
+    std::printf("%-28s %12.0f updates/s\n", "writer alone", RunWriter(tracker, devices, updates));
+  }
+
+  ble::RssiTracker tracker(options);
+  std::atomic<bool> stop{false};
+  std::atomic<uint64_t> queries{0};
+  std::vector<std::thread> threads;
+  for (int r = 0; r < readers; ++r) {
+    threads.emplace_back([&, r]() {
+      std::mt19937 random(r);
+      std::array<ble::RssiSample, ble::kRssiHistoryLength> history;
+      uint64_t local = 0;
+      while (!stop.load(std::memory_order_relaxed)) {
+        const uint64_t mac = 0xAABB00000000ull | (random() % devices);
+        tracker.Stats(mac);
+        tracker.History(mac, history);
+        ++local;
+      }
+      queries.fetch_add(local);
+    });
+  }
+
+  const auto start = ble::bench::Clock::now();
+  const double rate = RunWriter(tracker, devices, updates);
+  stop = true;
+  for (auto& thread : threads) {
+    thread.join();
+  }
+  const double seconds = std::chrono::duration<double>(ble::bench::Clock::now() - start).count();
+
+  std::printf("%-28s %12.0f updates/s %12.0f queries/s (%d readers)\n", "writer with readers", rate,
+              static_cast<double>(queries.load()) / seconds, readers);
+  std::printf("%-28s %12zu devices %12llu untracked\n", "tracked", tracker.size(),
+              static_cast<unsigned long long>(tracker.untracked()));
+  return 0;
+}
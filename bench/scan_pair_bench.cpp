@@ -0,0 +1,68 @@
+// MIT License
+// Copyright (c) 2025 pezy
+
+// Time-to-pair for devices BlueZ has not seen yet: a fixed scan window
+// followed by PairDevice (the bluetoothctl "scan on" routine) versus
+// ble::ScanAndPair, against the in-process mock BlueZ whose nearby devices
+// appear one advertising interval into discovery.
+//
+// Usage: scan_pair_bench [devices] [advertising_interval_ms] [scan_window_ms]   (defaults 10, 100, 2000)
+
+#include <bluetooth/discovery.hpp>
+#include <cstdlib>
+#include <iostream>
+#include <string>
+#include <thread>
+
+#include "bench_utils.hpp"
+#include "mock_bluez.hpp"
+
+int main(int argc, char* argv[]) {
+  const int devices = argc > 1 ? std::atoi(argv[1]) : 10;
+  const auto advertising_interval = std::chrono::milliseconds(argc > 2 ? std::atoi(argv[2]) : 100);
+  const auto scan_window = std::chrono::milliseconds(argc > 3 ? std::atoi(argv[3]) : 2000);
+
+  ble::bench::MockBluez mock;
+  ble::Session session;
+  uint32_t next = 0;
+  auto add_nearby = [&mock, &next, advertising_interval]() {
+    ble::bench::MockDevice device{ble::bench::SyntheticMac(next++), "nearby"};
+    device.paired = false;
+    mock.AddNearbyDevice(device, advertising_interval);
+    return device.mac_address;
+  };
+
+  using ble::bench::Clock;
+  ble::bench::LatencyStats window_stats;
+  ble::bench::LatencyStats scan_and_pair_stats;
+  int failures = 0;
+
+  for (int i = 0; i < devices; ++i) {
+    const std::string mac = add_nearby();
+    const auto start = Clock::now();
+    {
+      ble::Discovery discovery(session);
+      failures += discovery.Start().hasError() ? 1 : 0;
+      std::this_thread::sleep_for(scan_window);
+      failures += discovery.Stop().hasError() ? 1 : 0;
+    }
+    failures += session.PairDevice(mac).hasError() ? 1 : 0;
+    window_stats.Add(Clock::now() - start);
+  }
+
+  for (int i = 0; i < devices; ++i) {
+    const std::string mac = add_nearby();
+    const auto start = Clock::now();
+    failures += ble::ScanAndPair(session, mac, start + std::chrono::seconds(30)).hasError() ? 1 : 0;
+    scan_and_pair_stats.Add(Clock::now() - start);
+  }
+
+  std::cout << devices << " devices, " << advertising_interval.count() << " ms advertising interval\n";
+  window_stats.Print("scan window + PairDevice");
+  scan_and_pair_stats.Print("ScanAndPair");
+  if (failures != 0) {
+    std::cerr << "Error: " << failures << " operations failed\n";
+    return 1;
+  }
+  return 0;
+}
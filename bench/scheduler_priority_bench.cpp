@@ -0,0 +1,116 @@
+// MIT License
+// Copyright (c) 2025 pezy
+
+// Latency of a few critical connects submitted behind a burst of bulk ones,
+// with and without a higher priority, and how deadlines shed bulk requests
+// that cannot make it instead of letting them occupy the adapter. Runs
+// against the in-process mock BlueZ with controller limits, so one Connect at
+// a time per adapter.
+//
+// Usage: scheduler_priority_bench [bulk_devices] [critical_devices] [latency_ms] [deadline_ms]
+//        (defaults 200, 10, 10, 500)
+
+#include <bluetooth/batch.hpp>
+#include <bluetooth/connection_scheduler.hpp>
+#include <cstdio>
+#include <cstdlib>
+#include <future>
+#include <iostream>
+#include <string>
+#include <vector>
+
+#include "bench_utils.hpp"
+#include "mock_bluez.hpp"
+
+namespace {
+
+struct Outcome {
+  ble::bench::LatencyStats critical;
+  int bulk_connected{0};
+  int bulk_timed_out{0};
+};
+
+// Submits the bulk devices, then the critical ones, and waits for everything
+Outcome Run(ble::Session& session, const std::vector<std::string>& bulk, const std::vector<std::string>& critical,
+            int critical_priority, std::chrono::milliseconds bulk_deadline) {
+  using ble::bench::Clock;
+  Outcome outcome;
+  ble::ConnectionScheduler scheduler(session);
+
+  ble::RequestOptions bulk_options;
+  if (bulk_deadline.count() > 0) {
+    bulk_options.deadline = Clock::now() + bulk_deadline;
+  }
+  std::vector<std::future<ble::DeviceResult>> bulk_results;
+  for (const auto& mac : bulk) {
+    bulk_results.push_back(scheduler.Connect(mac, bulk_options));
+  }
+
+  ble::RequestOptions critical_options;
+  critical_options.priority = critical_priority;
+  const auto start = Clock::now();
+  std::vector<std::future<ble::DeviceResult>> critical_results;
+  for (const auto& mac : critical) {
+    critical_results.push_back(scheduler.Connect(mac, critical_options));
+  }
+  for (auto& result : critical_results) {
+    result.get();
+    outcome.critical.Add(Clock::now() - start);
+  }
+
+  for (auto& future : bulk_results) {
+    const ble::DeviceResult result = future.get();
+    if (!result.result.hasError()) {
+      ++outcome.bulk_connected;
+    } else if (result.result.error_code == static_cast<int>(ble::ErrorCode::ConnectionTimeout)) {
+      ++outcome.bulk_timed_out;
+    }
+  }
+  return outcome;
+}
+
+}  // anonymous namespace
+
+int main(int argc, char* argv[]) {
+  const int bulk_devices = argc > 1 ? std::atoi(argv[1]) : 200;
+  const int critical_devices = argc > 2 ? std::atoi(argv[2]) : 10;
+  const int latency_ms = argc > 3 ? std::atoi(argv[3]) : 10;
+  const auto deadline = std::chrono::milliseconds(argc > 4 ? std::atoi(argv[4]) : 500);
+
+  ble::bench::MockBluez mock;
+  std::vector<std::string> bulk;
+  std::vector<std::string> critical;
+  for (int i = 0; i < bulk_devices + critical_devices; ++i) {
+    auto& group = i < bulk_devices ? bulk : critical;
+    group.push_back(ble::bench::SyntheticMac(static_cast<uint32_t>(i)));
+    mock.AddDevice({group.back(), "bench-" + std::to_string(i)});
+  }
+  mock.SetMethodLatency(std::chrono::milliseconds(latency_ms));
+  mock.SetControllerLimits(static_cast<uint32_t>(bulk_devices + critical_devices));
+
+  std::printf("%d bulk and %d critical devices on one adapter, %d ms per connect\n", bulk_devices, critical_devices,
+              latency_ms);
+
+  ble::Session session;
+  const struct {
+    const char* name;
+    int priority;
+    std::chrono::milliseconds deadline;
+  } cases[] = {
+      {"same priority", 0, std::chrono::milliseconds(0)},
+      {"critical priority 10", 10, std::chrono::milliseconds(0)},
+      {"priority + bulk deadline", 10, deadline},
+  };
+  for (const auto& c : cases) {
+    Outcome outcome = Run(session, bulk, critical, c.priority, c.deadline);
+    std::printf("%-28s bulk connected %4d, failed fast on deadline %4d\n", c.name, outcome.bulk_connected,
+                outcome.bulk_timed_out);
+    outcome.critical.Print("  critical connect latency");
+
+    if (ble::DisconnectAll(session).hasError()) {
+      std::cerr << "Error: DisconnectAll failed\n";
+      return 1;
+    }
+  }
+  return 0;
+}
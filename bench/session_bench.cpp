@@ -0,0 +1,115 @@
+// MIT License
+// Copyright (c) 2025 pezy
+
+// Per-operation latency of connect/disconnect cycles with and without a
+// persistent ble::Session, and with the session's device proxy cache turned
+// off and on, against the in-process mock BlueZ.
+//
+// Usage: session_bench [cycles]   (default 10000)
+
+#include <bluetooth/session.hpp>
+#include <cstdlib>
+#include <iostream>
+#include <string>
+
+// sys
+#include <gio/gio.h>
+
+#include "bench_utils.hpp"
+#include "mock_bluez.hpp"
+
+namespace {
+
+constexpr const char kDeviceMac[] = "AA:BB:CC:DD:EE:01";
+constexpr const char kDevicePath[] = "/org/bluez/hci0/dev_AA_BB_CC_DD_EE_01";
+
+// The pre-session code path: bus connection and device proxy built per call
+bool LegacyDeviceCall(const char* method) {
+  GError* error = nullptr;
+  GDBusConnection* connection = g_bus_get_sync(G_BUS_TYPE_SYSTEM, nullptr, &error);
+  if (!connection) {
+    g_error_free(error);
+    return false;
+  }
+
+  GDBusProxy* proxy = g_dbus_proxy_new_sync(connection, G_DBUS_PROXY_FLAGS_NONE, nullptr, "org.bluez", kDevicePath,
+                                            "org.bluez.Device1", nullptr, &error);
+  if (!proxy) {
+    g_error_free(error);
+    g_object_unref(connection);
+    return false;
+  }
+
+  GVariant* reply =
+      g_dbus_proxy_call_sync(proxy, method, g_variant_new("()"), G_DBUS_CALL_FLAGS_NONE, 10000, nullptr, &error);
+  const bool ok = reply != nullptr;
+  if (reply) g_variant_unref(reply);
+  if (error) g_error_free(error);
+  g_object_unref(proxy);
+  g_object_unref(connection);
+  return ok;
+}
+
+// Runs connect/disconnect cycles through session, returns the number of failed operations
+int RunSessionCycles(ble::Session& session, int cycles, ble::bench::LatencyStats& stats) {
+  using ble::bench::Clock;
+  int failures = 0;
+  for (int i = 0; i < cycles; ++i) {
+    auto start = Clock::now();
+    failures += session.ConnectDevice(kDeviceMac).hasError() ? 1 : 0;
+    stats.Add(Clock::now() - start);
+
+    start = Clock::now();
+    failures += session.DisconnectDevice(kDeviceMac).hasError() ? 1 : 0;
+    stats.Add(Clock::now() - start);
+  }
+  return failures;
+}
+
+}  // anonymous namespace
+
+int main(int argc, char* argv[]) {
+  const int cycles = argc > 1 ? std::atoi(argv[1]) : 10000;
+
+  ble::bench::MockBluez mock;
+  mock.AddDevice({kDeviceMac, "bench-device"});
+
+  using ble::bench::Clock;
+  ble::bench::LatencyStats legacy_stats;
+  ble::bench::LatencyStats uncached_stats;
+  ble::bench::LatencyStats cached_stats;
+  int failures = 0;
+
+  // Legacy path first: once a session holds the bus singleton, g_bus_get_sync stops reconnecting
+  for (int i = 0; i < cycles; ++i) {
+    for (const char* method : {"Connect", "Disconnect"}) {
+      const auto start = Clock::now();
+      failures += LegacyDeviceCall(method) ? 0 : 1;
+      legacy_stats.Add(Clock::now() - start);
+    }
+  }
+
+  ble::SessionOptions options;
+  options.call_mode = ble::CallMode::Proxy;
+  {
+    options.device_proxy_cache_size = 0;
+    ble::Session session(options);
+    failures += RunSessionCycles(session, cycles, uncached_stats);
+  }
+
+  {
+    options.device_proxy_cache_size = 64;
+    ble::Session session(options);
+    failures += RunSessionCycles(session, cycles, cached_stats);
+  }
+
+  std::cout << cycles << " connect/disconnect cycles against mock BlueZ\n";
+  legacy_stats.Print("per-call bus setup");
+  uncached_stats.Print("ble::Session, no proxy cache");
+  cached_stats.Print("ble::Session, proxy cache");
+  if (failures != 0) {
+    std::cerr << "Error: " << failures << " operations failed\n";
+    return 1;
+  }
+  return 0;
+}
@@ -0,0 +1,134 @@
+// MIT License
+// Copyright (c) 2025 pezy
+
+// Following the paired listing: re-downloading it every interval and diffing,
+// as watch -n1 ble_pair does, against DeviceCache::TakeChanges as used by
+// ble_pair --watch. Each interval a fixed number of devices change, every one
+// with several RSSI updates and some losing their link, so the per-interval
+// cost of polling should grow with the device count and that of the cache
+// only with the changes. Run it at 100, 1000 and 10000 devices to compare.
+// CPU is the whole process, mock included, as both pay the same to emit.
+//
+// Usage: watch_bench [devices] [changes] [rounds] [interval_ms]   (defaults 1000, 50, 20, 100)
+
+#include <sys/resource.h>
+
+#include <bluetooth/device_cache.hpp>
+#include <bluetooth/session.hpp>
+#include <cstdio>
+#include <cstdlib>
+#include <string>
+#include <thread>
+#include <unordered_map>
+#include <vector>
+
+#include "bench_utils.hpp"
+#include "mock_bluez.hpp"
+
+namespace {
+
+double ProcessCpuMs() {
+  rusage usage{};
+  getrusage(RUSAGE_SELF, &usage);
+  return (usage.ru_utime.tv_sec + usage.ru_stime.tv_sec) * 1000.0 +
+         (usage.ru_utime.tv_usec + usage.ru_stime.tv_usec) / 1000.0;
+}
+
+// One interval of churn: four RSSI updates per changed device, every fifth one also dropped
+void Churn(ble::bench::MockBluez& mock, const std::vector<std::string>& macs, int changes, int round) {
+  for (int k = 0; k < changes; ++k) {
+    const std::string& mac = macs[static_cast<size_t>(round * changes + k) % macs.size()];
+    for (int update = 0; update < 4; ++update) {
+      mock.SetDeviceRssi(mac, static_cast<int16_t>(-40 - (round * 7 + k + update * 3) % 50));
+    }
+    if (k % 5 == 0) {
+      mock.DropConnection(mac);
+    }
+  }
+}
+
+// Devices whose listing entry differs between two snapshots
+size_t Diff(const std::unordered_map<std::string, ble::BluetoothDevice>& before,
+            const std::unordered_map<std::string, ble::BluetoothDevice>& after) {
+  size_t deltas = 0;
+  for (const auto& [mac, device] : after) {
+    auto it = before.find(mac);
+    if (it == before.end() || it->second.rssi != device.rssi || it->second.connected != device.connected ||
+        it->second.device_name != device.device_name) {
+      ++deltas;
+    }
+  }
+  for (const auto& [mac, device] : before) {
+    deltas += after.count(mac) == 0 ? 1 : 0;
+  }
+  return deltas;
+}
+
+std::unordered_map<std::string, ble::BluetoothDevice> ByMac(const ble::DeviceQueryResult& result) {
+  std::unordered_map<std::string, ble::BluetoothDevice> devices;
+  for (const auto& device : result.devices) {
+    devices.emplace(device.mac_address, device);
+  }
+  return devices;
+}
+
+void Report(const char* name, int rounds, double cpu_ms, uint64_t calls, size_t deltas) {
+  std::printf("%-24s %9.2f ms CPU/interval %9.1f calls/interval %7.1f deltas/interval\n", name, cpu_ms / rounds,
+              static_cast<double>(calls) / rounds, static_cast<double>(deltas) / rounds);
+}
+
+}  // anonymous namespace
+
+int main(int argc, char* argv[]) {
+  const int devices = argc > 1 ? std::atoi(argv[1]) : 1000;
+  const int changes = argc > 2 ? std::atoi(argv[2]) : 50;
+  const int rounds = argc > 3 ? std::atoi(argv[3]) : 20;
+  const std::chrono::milliseconds interval(argc > 4 ? std::atoi(argv[4]) : 100);
+
+  ble::bench::MockBluez mock;
+  std::vector<std::string> macs;
+  for (int i = 0; i < devices; ++i) {
+    ble::bench::MockDevice device{ble::bench::SyntheticMac(static_cast<uint32_t>(i)), "bench-" + std::to_string(i)};
+    device.connected = true;
+    macs.push_back(device.mac_address);
+    mock.AddDevice(device);
+  }
+  std::printf("%d devices, %d changed per %lld ms interval, %d intervals\n", devices, changes,
+              static_cast<long long>(interval.count()), rounds);
+
+  ble::Session session;
+  int round = 0;
+  {
+    auto previous = ByMac(session.GetPairedDevices());
+    size_t deltas = 0;
+    const uint64_t calls = mock.method_calls();
+    const double cpu = ProcessCpuMs();
+    for (int i = 0; i < rounds; ++i, ++round) {
+      Churn(mock, macs, changes, round);
+      std::this_thread::sleep_for(interval);
+      auto current = ByMac(session.GetPairedDevices());
+      deltas += Diff(previous, current);
+      previous = std::move(current);
+    }
+    Report("poll and diff", rounds, ProcessCpuMs() - cpu, mock.method_calls() - calls, deltas);
+  }
+
+  {
+    ble::DeviceCache cache(session);
+    if (!cache.synced()) {
+      std::printf("device cache failed to load\n");
+      return 1;
+    }
+    cache.TakeChanges();
+    size_t deltas = 0;
+    const uint64_t calls = mock.method_calls();
+    const double cpu = ProcessCpuMs();
+    for (int i = 0; i < rounds; ++i, ++round) {
+      Churn(mock, macs, changes, round);
+      std::this_thread::sleep_for(interval);
+      deltas += cache.TakeChanges().size();
+    }
+    Report("DeviceCache::TakeChanges", rounds, ProcessCpuMs() - cpu, mock.method_calls() - calls, deltas);
+  }
+  return 0;
+}
@@ -0,0 +1,289 @@
+// MIT License
+// Copyright (c) 2025 pezy
+
+#include <bluetooth/device_cache.hpp>
+#include <bluetooth/device_discovery.hpp>
+#include <bluetooth/discovery.hpp>
+#include <bluetooth/session.hpp>
+#include <algorithm>
+#include <chrono>
+#include <cstdio>
+#include <fstream>
+#include <iostream>
+#include <memory>
+#include <sstream>
+#include <string>
+#include <utility>
+#include <vector>
+
+#include "argparse.hpp"
+
+namespace {
+
+void PrintErrorMessage(const std::string& message) { std::cerr << "Error: " << message << "\n"; }
+
+// One script line; args[0] is the subcommand
+struct Command {
+  size_t line{0};
+  bool keep_going{false};  // line starts with '-': its failure never stops the script
+  std::vector<std::string> args;
+};
+
+// Checks the arguments of a subcommand without running it
+bool Validate(const std::vector<std::string>& args, std::string* error) {
+  const std::string& name = args[0];
+  size_t positional = 0;
+  for (size_t i = 1; i < args.size(); ++i) {
+    if (name == "conn" && args[i] == "-d") continue;
+    ++positional;
+  }
+  if (name == "list") {
+    *error = "usage: list";
+    return positional == 0;
+  }
+  if (name == "pair" || name == "conn") {
+    *error = name == "pair" ? "usage: pair MAC [ADAPTER]" : "usage: conn [-d] MAC [ADAPTER]";
+    return positional >= 1 && positional <= 2;
+  }
+  *error = "unknown command " + name;
+  return false;
+}
+
+// Parses the whole script up front, so a typo on the last line fails before the first command runs
+bool ParseScript(std::istream& input, std::vector<Command>* commands) {
+  size_t number = 0;
+  bool valid = true;
+  for (std::string line; std::getline(input, line);) {
+    ++number;
+    std::istringstream fields(line.substr(0, line.find('#')));
+    Command command;
+    command.line = number;
+    for (std::string field; fields >> field;) {
+      command.args.push_back(std::move(field));
+    }
+    if (command.args.empty()) {
+      continue;
+    }
+    if (command.args[0].size() > 1 && command.args[0][0] == '-') {
+      command.keep_going = true;
+      command.args[0].erase(0, 1);
+    }
+    std::string error;
+    if (!Validate(command.args, &error)) {
+      std::cerr << "Error: line " << number << ": " << error << "\n";
+      valid = false;
+    }
+    commands->push_back(std::move(command));
+  }
+  return valid;
+}
+
+// Runs subcommands on one session. With cache_listings the device tree is
+// mirrored in memory once the first list needs it, which pays off only for a
+// script with several lists; otherwise each list is one GetManagedObjects.
+class Runner {
+ public:
+  explicit Runner(bool cache_listings = false) : cache_listings_(cache_listings) {}
+
+  // Prints the outcome; returns the ble::ErrorCode of a failure, 0 on success
+  int Run(const std::vector<std::string>& args) {
+    if (args[0] == "list") {
+      return List();
+    }
+
+    bool disconnect = false;
+    std::vector<std::string> positional;
+    for (size_t i = 1; i < args.size(); ++i) {
+      if (args[i] == "-d") {
+        disconnect = true;
+      } else {
+        positional.push_back(args[i]);
+      }
+    }
+    const ble::DeviceAddress device(positional[0], positional.size() > 1 ? positional[1] : "");
+
+    ble::Result result;
+    std::string done;
+    if (args[0] == "pair") {
+      result = ble::ScanAndPair(session_, device, std::chrono::steady_clock::now() + std::chrono::seconds(30));
+      done = "Paired";
+    } else if (disconnect) {
+      result = session_.DisconnectDevice(device);
+      done = "Disconnected from";
+    } else {
+      result = session_.ConnectDevice(device);
+      done = "Connected to";
+    }
+
+    if (result.hasError()) {
+      PrintErrorMessage(result.error_message);
+      return result.error_code != 0 ? result.error_code : static_cast<int>(ble::ErrorCode::UnknownError);
+    }
+    if (!result.error_message.empty()) {
+      std::cout << result.error_message << ": " << device.mac_address;
+    } else {
+      std::cout << done << " " << device.mac_address;
+    }
+    std::cout << " (" << result.operation_time.count() << " ms)\n";
+    return 0;
+  }
+
+ private:
+  int List() {
+    if (cache_listings_ && !cache_) {
+      cache_ = std::make_unique<ble::DeviceCache>(session_);
+    }
+    ble::DeviceQueryResult result = cache_ ? cache_->GetPairedDevices() : session_.GetPairedDevices();
+    if (result.hasError()) {
+      PrintErrorMessage(result.error_message);
+      return result.error_code != 0 ? result.error_code : static_cast<int>(ble::ErrorCode::UnknownError);
+    }
+    if (result.deviceCount() == 0) {
+      std::cout << "No paired Bluetooth devices found\n";
+      return 0;
+    }
+    std::string output;
+    for (const auto& device : result.devices) {
+      output += device.mac_address;
+      output += ' ';
+      output += device.device_name && !device.device_name->empty() ? *device.device_name : "N/A";
+      output += ' ';
+      output += device.rssi ? std::to_string(*device.rssi) + "dBm" : "N/A";
+      output += device.connected ? " Connected\n" : " Disconnected\n";
+    }
+    std::cout << output;
+    return 0;
+  }
+
+  const bool cache_listings_;
+  ble::Session session_;
+  std::unique_ptr<ble::DeviceCache> cache_;  // declared after session_, so destroyed before it
+};
+
+int RunBatch(const std::string& path, bool keep_going) {
+  std::ifstream script(path);
+  if (!script) {
+    PrintErrorMessage("Cannot open " + path);
+    return 1;
+  }
+  std::vector<Command> commands;
+  if (!ParseScript(script, &commands)) {
+    return 1;
+  }
+
+  const auto lists = std::count_if(commands.begin(), commands.end(),
+                                   [](const Command& command) { return command.args[0] == "list"; });
+  Runner runner(lists > 1);
+  const auto start = std::chrono::steady_clock::now();
+  size_t failures = 0;
+  size_t ran = 0;
+  int status = 0;
+  for (const auto& command : commands) {
+    ++ran;
+    std::cout << "[" << command.line << "]";
+    for (const auto& arg : command.args) {
+      std::cout << " " << arg;
+    }
+    std::cout << "\n";
+
+    if (const int error = runner.Run(command.args); error != 0) {
+      ++failures;
+      if (!command.keep_going) {
+        status = error;
+        if (!keep_going) {
+          std::cerr << "Stopped at line " << command.line << "\n";
+          break;
+        }
+      }
+    }
+  }
+
+  const auto elapsed = std::chrono::duration_cast<std::chrono::milliseconds>(std::chrono::steady_clock::now() - start);
+  std::cout << ran << " of " << commands.size() << " commands run, " << failures << " failed, " << elapsed.count()
+            << " ms\n";
+  return status;
+}
+
+}  // anonymous namespace
+
+int main(int argc, char* argv[]) {
+  argparse::ArgumentParser parser("ble", "1.0");
+
+  parser.add_description("Multi-call Bluetooth tool: pair, conn and list in one binary, or a script of them");
+  parser.add_epilog(
+      "Usage:\n"
+      "  ble list                           # List paired devices\n"
+      "  ble pair <MAC_ADDRESS> [-a hci1]   # Pair with a device\n"
+      "  ble conn <MAC_ADDRESS> [-d]        # Connect to or disconnect from a device\n"
+      "  ble --batch <SCRIPT>               # Run a script of these commands\n\n"
+      "A script holds one command per line, written without the leading ble and with the adapter\n"
+      "as an optional last word: \"pair MAC [ADAPTER]\", \"conn [-d] MAC [ADAPTER]\", \"list\".\n"
+      "Blank lines and # comments are skipped. The whole script is checked before anything runs,\n"
+      "then the commands run in order over one session and one bus connection. A failure stops\n"
+      "the script unless --on-error continue is given or the line starts with '-', as in\n"
+      "\"-conn -d AA:BB:CC:DD:EE:FF\". The exit status is the error code of the last failure that\n"
+      "was not ignored, 0 if there was none.");
+
+  parser.add_argument("--batch").default_value(std::string("")).help("Run the commands in this script file");
+
+  parser.add_argument("--on-error")
+      .default_value(std::string("stop"))
+      .choices("stop", "continue")
+      .help("Whether a failed script line stops the script");
+
+  argparse::ArgumentParser list_command("list");
+  list_command.add_description("List paired devices");
+
+  argparse::ArgumentParser pair_command("pair");
+  pair_command.add_description("Pair with a device, scanning first when BlueZ has not seen it");
+  pair_command.add_argument("mac_address").help("MAC address of device to pair with");
+  pair_command.add_argument("-a", "--adapter").default_value(std::string("")).help("Adapter to pair through");
+
+  argparse::ArgumentParser conn_command("conn");
+  conn_command.add_description("Connect to or disconnect from a device");
+  conn_command.add_argument("mac_address").help("MAC address of device to connect to or disconnect from");
+  conn_command.add_argument("-d", "--disconnect").flag().help("Disconnect from device instead of connecting");
+  conn_command.add_argument("-a", "--adapter").default_value(std::string("")).help("Adapter to connect through");
+
+  parser.add_subparser(list_command);
+  parser.add_subparser(pair_command);
+  parser.add_subparser(conn_command);
+
+  try {
+    parser.parse_args(argc, argv);
+  } catch (const std::runtime_error& e) {
+    std::cerr << "Error: " << e.what() << "\n";
+    std::cerr << parser;
+    return 1;
+  }
+
+  try {
+    const std::string script = parser.get<std::string>("--batch");
+    if (!script.empty()) {
+      return RunBatch(script, parser.get<std::string>("--on-error") == "continue");
+    }
+
+    // A single subcommand is a one-line script
+    std::vector<std::string> args;
+    if (parser.is_subcommand_used(list_command)) {
+      args = {"list"};
+    } else if (parser.is_subcommand_used(pair_command)) {
+      args = {"pair", pair_command.get<std::string>("mac_address"), pair_command.get<std::string>("--adapter")};
+    } else if (parser.is_subcommand_used(conn_command)) {
+      args = {"conn", conn_command.get<std::string>("mac_address"), conn_command.get<std::string>("--adapter")};
+      if (conn_command.get<bool>("-d")) args.push_back("-d");
+    } else {
+      std::cerr << parser;
+      return 1;
+    }
+    Runner runner;
+    return runner.Run(args);
+  } catch (const ble::BluetoothException& e) {
+    PrintErrorMessage(e.what());
+    PrintErrorMessage(ble::ErrorCodeToMessage(e.errorCode()));
+    return static_cast<int>(e.errorCode());
+  } catch (const std::exception& e) {
+    PrintErrorMessage("Program exception: " + std::string(e.what()));
+    return 1;
+  }
+}
@@ -1,10 +1,19 @@
 // MIT License
 // Copyright (c) 2025 pezy
 
+#include <bluetooth/batch.hpp>
+#include <bluetooth/daemon.hpp>
 #include <bluetooth/device_discovery.hpp>
+#include <algorithm>
 #include <chrono>
+#include <cstdio>
+#include <fstream>
 #include <iostream>
+#include <memory>
+#include <sstream>
 #include <string>
+#include <utility>
+#include <vector>
 
 #include "argparse.hpp"
 
@@ -12,6 +21,81 @@ namespace {
 
 void PrintErrorMessage(const std::string& message) { std::cerr << "Error: " << message << "\n"; }
 
+// Connection to bled, or nullptr to talk to BlueZ directly
+std::unique_ptr<ble::DaemonClient> ConnectDaemon(bool direct) {
+  if (direct) {
+    return nullptr;
+  }
+  auto daemon = std::make_unique<ble::DaemonClient>();
+  return daemon->connected() ? std::move(daemon) : nullptr;
+}
+
+// One device per line, "MAC_ADDRESS [ADAPTER]"; blank lines and # comments are skipped
+std::vector<ble::DeviceAddress> ReadDevices(std::istream& input, const std::string& default_adapter) {
+  std::vector<ble::DeviceAddress> devices;
+  for (std::string line; std::getline(input, line);) {
+    std::istringstream fields(line.substr(0, line.find('#')));
+    std::string mac_address;
+    std::string adapter;
+    if (fields >> mac_address) {
+      fields >> adapter;
+      devices.emplace_back(std::move(mac_address), adapter.empty() ? default_adapter : std::move(adapter));
+    }
+  }
+  return devices;
+}
+
+double Percentile(const std::vector<std::chrono::milliseconds>& sorted, double fraction) {
+  const size_t index = static_cast<size_t>(fraction * static_cast<double>(sorted.size() - 1));
+  return static_cast<double>(sorted[index].count());
+}
+
+// Drives every device from one process over one bus connection. Prints a line
+// per device in input order, then the totals; returns 1 when any device failed.
+int RunFanOut(const std::vector<ble::DeviceAddress>& devices, bool disconnect, size_t jobs) {
+  const auto start = std::chrono::steady_clock::now();
+  std::vector<ble::Result> results;
+  if (disconnect) {
+    ble::DisconnectOptions options;
+    options.max_in_flight = jobs;
+    results = ble::DisconnectDevices(devices, options);
+  } else {
+    ble::BatchOptions options;
+    options.max_in_flight = jobs;
+    results = ble::ConnectDevices(devices, options);
+  }
+  const auto elapsed = std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count();
+
+  // Formatted into one buffer so thousands of devices cost one write
+  std::string output;
+  char line[512];
+  size_t failures = 0;
+  std::vector<std::chrono::milliseconds> latencies;
+  latencies.reserve(results.size());
+  for (size_t i = 0; i < results.size(); ++i) {
+    const ble::Result& result = results[i];
+    const bool failed = result.hasError();
+    failures += failed ? 1 : 0;
+    latencies.push_back(result.operation_time);
+    std::snprintf(line, sizeof(line), "%s %s %s %lld ms%s%s\n", devices[i].mac_address.c_str(),
+                  devices[i].adapter.empty() ? "-" : devices[i].adapter.c_str(), failed ? "FAILED" : "OK",
+                  static_cast<long long>(result.operation_time.count()), failed ? " " : "",
+                  failed ? result.error_message.c_str() : "");
+    output += line;
+  }
+  std::fwrite(output.data(), 1, output.size(), stdout);
+
+  std::sort(latencies.begin(), latencies.end());
+  std::printf("%zu devices, %zu failed, %.3f s, %.1f devices/s\n", devices.size(), failures, elapsed,
+              elapsed > 0 ? static_cast<double>(devices.size()) / elapsed : 0.0);
+  if (!latencies.empty()) {
+    std::printf("latency p50 %.0f ms, p95 %.0f ms, p99 %.0f ms, max %lld ms\n", Percentile(latencies, 0.50),
+                Percentile(latencies, 0.95), Percentile(latencies, 0.99),
+                static_cast<long long>(latencies.back().count()));
+  }
+  return failures > 0 ? 1 : 0;
+}
+
 }  // anonymous namespace
 
 int main(int argc, char* argv[]) {
@@ -19,20 +103,45 @@ int main(int argc, char* argv[]) {
   argparse::ArgumentParser parser("ble_conn", "1.0");
 
   // Add description and epilog
-  parser.add_description("Connect to or disconnect from a paired Bluetooth device");
+  parser.add_description("Connect to or disconnect from paired Bluetooth devices, one or a whole list");
   parser.add_epilog(
       "Usage:\n"
       "  ble_conn <MAC_ADDRESS>             # Connect to specified device\n"
-      "  ble_conn <MAC_ADDRESS> -d          # Disconnect from specified device\n\n"
+      "  ble_conn <MAC_ADDRESS> -d          # Disconnect from specified device\n"
+      "  ble_conn --file <FILE> [-j N]      # Connect to every device listed in FILE\n"
+      "  ble_conn --stdin [-j N] [-d]       # Same, reading the list from standard input\n\n"
+      "Lists hold one \"MAC_ADDRESS [ADAPTER]\" per line. A list is driven from one process over one\n"
+      "bus connection; each device gets a result line, followed by the throughput and p50/p95/p99\n"
+      "latency. The exit status is 1 when any device failed, 0 otherwise.\n\n"
       "Examples:\n"
       "  ble_conn AA:BB:CC:DD:EE:FF         # Connect to device\n"
-      "  ble_conn AA:BB:CC:DD:EE:FF -d      # Disconnect from device");
+      "  ble_conn AA:BB:CC:DD:EE:FF -d      # Disconnect from device\n"
+      "  ble_conn AA:BB:CC:DD:EE:FF -a hci1 # Connect through the second controller\n"
+      "  ble_conn --file macs.txt -j 32     # Connect a rack, 32 at a time\n\n"
+      "Requests go through bled when it is running, see bled --help.");
 
   // Add arguments
-  parser.add_argument("mac_address").help("MAC address of device to connect to or disconnect from");
+  parser.add_argument("mac_address")
+      .nargs(argparse::nargs_pattern::optional)
+      .help("MAC address of device to connect to or disconnect from");
 
   parser.add_argument("-d", "--disconnect").flag().help("Disconnect from device instead of connecting");
 
+  parser.add_argument("-a", "--adapter")
+      .default_value(std::string(""))
+      .help("Adapter to connect through, e.g. hci1 (default hci0)");
+
+  parser.add_argument("--direct").flag().help("Talk to BlueZ directly even when bled is running");
+
+  parser.add_argument("--file").default_value(std::string("")).help("Read the devices from a file, one per line");
+
+  parser.add_argument("--stdin").flag().help("Read the devices from standard input, one per line");
+
+  parser.add_argument("-j", "--jobs")
+      .default_value(16)
+      .scan<'i', int>()
+      .help("Calls in flight at once for a list, 0 for no limit");
+
   // Parse arguments
   try {
     parser.parse_args(argc, argv);
@@ -43,8 +152,37 @@ int main(int argc, char* argv[]) {
   }
 
   // Get parsed values
-  std::string mac_address = parser.get<std::string>("mac_address");
   bool disconnect = parser.get<bool>("-d");
+  const std::string adapter = parser.get<std::string>("--adapter");
+  const std::string file = parser.get<std::string>("--file");
+  const bool from_stdin = parser.get<bool>("--stdin");
+  const int selected = (parser.is_used("mac_address") ? 1 : 0) + (file.empty() ? 0 : 1) + (from_stdin ? 1 : 0);
+  if (selected != 1) {
+    std::cerr << "Error: give exactly one of a MAC address, --file or --stdin\n";
+    std::cerr << parser;
+    return 1;
+  }
+
+  if (!file.empty() || from_stdin) {
+    std::ifstream list;
+    if (!file.empty()) {
+      list.open(file);
+      if (!list) {
+        PrintErrorMessage("Cannot open " + file);
+        return 1;
+      }
+    }
+    try {
+      const auto devices = ReadDevices(file.empty() ? std::cin : list, adapter);
+      return RunFanOut(devices, disconnect, static_cast<size_t>(std::max(parser.get<int>("--jobs"), 0)));
+    } catch (const std::exception& e) {
+      PrintErrorMessage("Program exception: " + std::string(e.what()));
+      return 1;
+    }
+  }
+
+  std::string mac_address = parser.get<std::string>("mac_address");
+  const ble::DeviceAddress device(mac_address, adapter);
 
   try {
     const bool is_disconnect = disconnect;
@@ -53,7 +191,12 @@ int main(int argc, char* argv[]) {
     const auto time_label = is_disconnect ? "Disconnect time" : "Connection time";
 
     std::cout << "Attempting to " << action_str << " device: " << mac_address << "\n";
-    ble::Result result = is_disconnect ? ble::DisconnectDevice(mac_address) : ble::ConnectDevice(mac_address);
+    ble::Result result;
+    if (const auto daemon = ConnectDaemon(parser.get<bool>("--direct"))) {
+      result = is_disconnect ? daemon->DisconnectDevice(device) : daemon->ConnectDevice(device);
+    } else {
+      result = is_disconnect ? ble::DisconnectDevice(device) : ble::ConnectDevice(device);
+    }
 
     if (result.hasError()) {
       PrintErrorMessage(result.error_message);
@@ -1,17 +1,74 @@
 // MIT License
 // Copyright (c) 2025 pezy
 
+#include <bluetooth/daemon.hpp>
+#include <bluetooth/device_cache.hpp>
 #include <bluetooth/device_discovery.hpp>
+#include <bluetooth/discovery.hpp>
 #include <chrono>
 #include <iostream>
+#include <memory>
 #include <string>
+#include <thread>
+#include <utility>
 
 #include "argparse.hpp"
+#include "device_writer.hpp"
 
 namespace {
 
 void PrintErrorMessage(const std::string& message) { std::cerr << "Error: " << message << "\n"; }
 
+// Connection to bled, or nullptr to talk to BlueZ directly
+std::unique_ptr<ble::DaemonClient> ConnectDaemon(bool direct) {
+  if (direct) {
+    return nullptr;
+  }
+  auto daemon = std::make_unique<ble::DaemonClient>();
+  return daemon->connected() ? std::move(daemon) : nullptr;
+}
+
+void PrintQueryError(const ble::DeviceQueryResult& result) {
+  PrintErrorMessage(result.error_message);
+  if (result.error_code != 0) {
+    PrintErrorMessage(ble::ErrorCodeToMessage(static_cast<ble::ErrorCode>(result.error_code)));
+  }
+}
+
+// Prints the listing, then every interval the net changes since the last one.
+// The cache follows the bus signals, so an interval costs no bus calls and
+// only the devices that changed are looked at, however many are paired.
+int Watch(ble::cli::OutputFormat format, std::chrono::milliseconds interval) {
+  ble::DeviceCache cache;
+  // Without the tree in memory there is nothing for the signals to update
+  if (!cache.synced()) {
+    const ble::ErrorCode error_code = ble::ErrorCode::BluetoothServiceUnavailable;
+    PrintErrorMessage("Cannot watch: the device tree could not be loaded");
+    PrintErrorMessage(ble::ErrorCodeToMessage(error_code));
+    return static_cast<int>(error_code);
+  }
+  cache.TakeChanges();
+  const ble::DeviceQueryResult result = cache.GetPairedDevices();
+  if (result.hasError()) {
+    PrintQueryError(result);
+    return result.error_code;
+  }
+
+  ble::cli::DeviceWriter writer(stdout, format, true);
+  for (const auto& device : result.devices) {
+    writer.Write(device);
+  }
+  writer.Flush();
+
+  for (;;) {
+    std::this_thread::sleep_for(interval);
+    for (const auto& change : cache.TakeChanges()) {
+      writer.WriteChange(change);
+    }
+    writer.Flush();
+  }
+}
+
 }  // anonymous namespace
 
 int main(int argc, char* argv[]) {
@@ -23,18 +80,48 @@ int main(int argc, char* argv[]) {
   parser.add_epilog(
       "Usage:\n"
       "  ble_pair                           # List all paired devices\n"
-      "  ble_pair <MAC_ADDRESS>             # Pair with specified device\n\n"
+      "  ble_pair <MAC_ADDRESS>             # Pair with specified device\n"
+      "  ble_pair --watch                   # List paired devices, then follow changes\n\n"
       "Output format for listing:\n"
-      "  MAC_ADDRESS DEVICE_NAME RSSI CONNECTION_STATUS\n\n"
+      "  MAC_ADDRESS DEVICE_NAME RSSI CONNECTION_STATUS\n"
+      "  or, with --format json|ndjson|csv, records with mac_address, name, rssi, device_class,\n"
+      "  adapter, paired and connected; names are quoted, so spaces and commas are safe\n\n"
+      "With --watch the listing is followed by one line per device that changed during each\n"
+      "--interval, however often it changed: \"+ <listing line>\" when it is paired, \"- <listing\n"
+      "line>\" when it goes away and \"~ MAC_ADDRESS <new values>\" otherwise. json is written as\n"
+      "ndjson, and json and csv records gain an event of listed, added, removed or changed;\n"
+      "removed records have paired false. RSSI only changes while some program is scanning.\n\n"
       "Examples:\n"
       "  ble_pair                           # List paired devices\n"
-      "  ble_pair AA:BB:CC:DD:EE:FF         # Pair with device");
+      "  ble_pair --format ndjson           # List paired devices as one JSON object per line\n"
+      "  ble_pair --watch --interval 250    # Follow changes, four updates a second at most\n"
+      "  ble_pair AA:BB:CC:DD:EE:FF         # Pair with device\n"
+      "  ble_pair AA:BB:CC:DD:EE:FF -a hci1 # Pair through the second controller\n\n"
+      "Requests other than --watch go through bled when it is running, see bled --help.");
 
   // Add arguments
   parser.add_argument("mac_address")
       .nargs(argparse::nargs_pattern::optional)
       .help("MAC address of device to pair with (optional)");
 
+  parser.add_argument("-a", "--adapter")
+      .default_value(std::string(""))
+      .help("Adapter to pair through, e.g. hci1 (default hci0)");
+
+  parser.add_argument("-f", "--format")
+      .default_value(std::string("text"))
+      .choices("text", "json", "ndjson", "csv")
+      .help("Listing format: text, json, ndjson or csv");
+
+  parser.add_argument("-w", "--watch").flag().help("Keep running and print changes to the listing");
+
+  parser.add_argument("--interval")
+      .default_value(1000)
+      .scan<'i', int>()
+      .help("Milliseconds over which --watch coalesces changes");
+
+  parser.add_argument("--direct").flag().help("Talk to BlueZ directly even when bled is running");
+
   // Parse arguments
   try {
     parser.parse_args(argc, argv);
@@ -52,50 +139,54 @@ int main(int argc, char* argv[]) {
     mac_address = "";
   }
 
+  ble::cli::OutputFormat format = ble::cli::OutputFormat::Text;
+  ble::cli::ParseOutputFormat(parser.get<std::string>("--format"), &format);
+  const bool watch = parser.get<bool>("--watch");
+  const int interval_ms = parser.get<int>("--interval");
+  if (watch && !mac_address.empty()) {
+    PrintErrorMessage("--watch lists devices and takes no MAC address");
+    return 1;
+  }
+  if (interval_ms <= 0) {
+    PrintErrorMessage("--interval must be positive");
+    return 1;
+  }
+
   try {
+    if (watch) {
+      // The daemon answers requests but does not forward changes
+      return Watch(format, std::chrono::milliseconds(interval_ms));
+    }
+
+    const auto daemon = ConnectDaemon(parser.get<bool>("--direct"));
+
     if (mac_address.empty()) {
       // List paired devices mode
-      ble::DeviceQueryResult result = ble::GetPairedDevices();
+      ble::DeviceQueryResult result = daemon ? daemon->GetPairedDevices() : ble::GetPairedDevices();
 
       if (result.hasError()) {
-        PrintErrorMessage(result.error_message);
-        if (result.error_code != 0) {
-          ble::ErrorCode error_code = static_cast<ble::ErrorCode>(result.error_code);
-          PrintErrorMessage(ble::ErrorCodeToMessage(error_code));
-        }
+        PrintQueryError(result);
         return result.error_code;
       }
 
-      if (result.deviceCount() == 0) {
+      if (format == ble::cli::OutputFormat::Text && result.deviceCount() == 0) {
         std::cout << "No paired Bluetooth devices found\n";
         return 0;
       }
 
-      // Print results in the new format: MAC_ADDRESS DEVICE_NAME RSSI CONNECTION_STATUS
+      ble::cli::DeviceWriter writer(stdout, format);
       for (const auto& device : result.devices) {
-        std::cout << device.mac_address << " ";
-
-        // Device name
-        if (device.device_name && !device.device_name->empty()) {
-          std::cout << *device.device_name << " ";
-        } else {
-          std::cout << "N/A ";
-        }
-
-        // RSSI
-        if (device.rssi) {
-          std::cout << *device.rssi << "dBm ";
-        } else {
-          std::cout << "N/A ";
-        }
-
-        std::cout << (device.connected ? "Connected" : "Disconnected") << "\n";
+        writer.Write(device);
       }
+      writer.Finish();
     } else {
       // Pair device mode
       std::cout << "Attempting to pair with device: " << mac_address << "\n";
 
-      ble::Result result = ble::PairDevice(mac_address);
+      // Scans first when BlueZ has not seen the device yet
+      const ble::DeviceAddress device(mac_address, parser.get<std::string>("--adapter"));
+      const auto deadline = std::chrono::steady_clock::now() + std::chrono::seconds(30);
+      ble::Result result = daemon ? daemon->ScanAndPair(device, deadline) : ble::ScanAndPair(device, deadline);
 
       if (result.hasError()) {
         PrintErrorMessage(result.error_message);
@@ -106,7 +197,11 @@ int main(int argc, char* argv[]) {
         return result.error_code;
       }
 
-      std::cout << "Successfully paired with device: " << mac_address << "\n";
+      if (!result.error_message.empty()) {
+        std::cout << result.error_message << ": " << mac_address << "\n";
+      } else {
+        std::cout << "Successfully paired with device: " << mac_address << "\n";
+      }
       std::cout << "Pairing time: " << result.operation_time.count() << " ms\n";
     }
   } catch (const ble::BluetoothException& e) {
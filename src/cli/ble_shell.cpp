@@ -0,0 +1,334 @@
+// MIT License
+// Copyright (c) 2025 pezy
+
+#include <bluetooth/device_cache.hpp>
+#include <bluetooth/device_discovery.hpp>
+#include <bluetooth/discovery.hpp>
+#include <bluetooth/session.hpp>
+#include <atomic>
+#include <charconv>
+#include <chrono>
+#include <cstdio>
+#include <iostream>
+#include <memory>
+#include <sstream>
+#include <string>
+#include <thread>
+#include <utility>
+#include <vector>
+
+#include "argparse.hpp"
+
+// sys
+#include <readline/history.h>
+#include <readline/readline.h>
+
+namespace {
+
+using Clock = std::chrono::steady_clock;
+
+double Millis(Clock::duration duration) { return std::chrono::duration<double, std::milli>(duration).count(); }
+
+// Wall time of the phases of one command, printed as one line once it is done
+class PhaseTimer {
+ public:
+  PhaseTimer() : start_(Clock::now()), mark_(start_) {}
+
+  // Ends the current phase; detail is printed next to its time
+  void Mark(const std::string& name, const std::string& detail = "") {
+    const auto now = Clock::now();
+    phases_.push_back({name, detail, now - mark_});
+    mark_ = now;
+  }
+
+  void Print() const {
+    std::printf("  latency %.2f ms:", Millis(mark_ - start_));
+    for (size_t i = 0; i < phases_.size(); ++i) {
+      const auto& phase = phases_[i];
+      std::printf("%s %s %.2f", i == 0 ? "" : ",", phase.name.c_str(), Millis(phase.duration));
+      if (!phase.detail.empty()) std::printf(" (%s)", phase.detail.c_str());
+    }
+    std::printf("\n");
+  }
+
+ private:
+  struct Phase {
+    std::string name;
+    std::string detail;
+    Clock::duration duration;
+  };
+
+  Clock::time_point start_;
+  Clock::time_point mark_;
+  std::vector<Phase> phases_;
+};
+
+std::string FormatMac(uint64_t mac) {
+  char text[18];
+  std::snprintf(text, sizeof(text), "%02X:%02X:%02X:%02X:%02X:%02X", static_cast<unsigned>((mac >> 40) & 0xFF),
+                static_cast<unsigned>((mac >> 32) & 0xFF), static_cast<unsigned>((mac >> 24) & 0xFF),
+                static_cast<unsigned>((mac >> 16) & 0xFF), static_cast<unsigned>((mac >> 8) & 0xFF),
+                static_cast<unsigned>(mac & 0xFF));
+  return text;
+}
+
+// Library time of a call and, under a RetryPolicy, its attempts
+std::string CallDetail(const ble::Result& result) {
+  std::ostringstream detail;
+  detail << "bluez " << result.operation_time.count() << " ms";
+  if (result.attempts() > 1) detail << ", " << result.attempts() << " attempts";
+  return detail.str();
+}
+
+void PrintResult(const ble::Result& result, const std::string& success) {
+  if (result.hasError()) {
+    std::printf("Error: %s\n", result.error_message.c_str());
+  } else if (!result.error_message.empty()) {
+    std::printf("%s\n", result.error_message.c_str());
+  } else {
+    std::printf("%s\n", success.c_str());
+  }
+}
+
+// The optional SECONDS argument; false when it is not a whole number of seconds
+bool Seconds(const std::vector<std::string>& args, int fallback, int* seconds) {
+  if (args.size() < 2) {
+    *seconds = fallback;
+    return true;
+  }
+  const std::string& text = args[1];
+  const auto [end, error] = std::from_chars(text.data(), text.data() + text.size(), *seconds);
+  return error == std::errc() && end == text.data() + text.size() && *seconds >= 0;
+}
+
+class Shell {
+ public:
+  Shell(ble::Session& session, ble::DeviceCache* cache) : session_(session), cache_(cache) {}
+
+  // False once the user asked to leave
+  bool Execute(const std::string& line) {
+    std::istringstream stream(line);
+    std::vector<std::string> args;
+    for (std::string arg; stream >> arg;) {
+      args.push_back(std::move(arg));
+    }
+    if (args.empty()) {
+      return true;
+    }
+
+    const std::string& command = args[0];
+    if (command == "quit" || command == "exit") {
+      return false;
+    } else if (command == "help") {
+      PrintHelp();
+    } else if (command == "list") {
+      List();
+    } else if (command == "pair" || command == "connect" || command == "disconnect") {
+      if (args.size() < 2) {
+        std::printf("Usage: %s <MAC_ADDRESS> [ADAPTER]\n", command.c_str());
+      } else {
+        DeviceCommand(command, ble::DeviceAddress(args[1], args.size() > 2 ? args[2] : ""));
+      }
+    } else if (command == "scan") {
+      int seconds = 0;
+      if (!Seconds(args, 5, &seconds)) {
+        std::printf("Usage: scan [SECONDS] [ADAPTER]\n");
+      } else {
+        Scan(seconds, args.size() > 2 ? args[2] : "");
+      }
+    } else if (command == "watch") {
+      int seconds = 0;
+      if (!Seconds(args, 10, &seconds)) {
+        std::printf("Usage: watch [SECONDS]\n");
+      } else {
+        Watch(seconds);
+      }
+    } else {
+      std::printf("Unknown command: %s (try help)\n", command.c_str());
+    }
+    return true;
+  }
+
+ private:
+  static void PrintHelp() {
+    std::printf(
+        "  list                             List paired devices\n"
+        "  pair <MAC> [ADAPTER]             Pair, scanning first when BlueZ has not seen the device\n"
+        "  connect <MAC> [ADAPTER]          Connect to a paired device\n"
+        "  disconnect <MAC> [ADAPTER]       Disconnect from a device\n"
+        "  scan [SECONDS] [ADAPTER]         Scan and count the devices found (default 5 s)\n"
+        "  watch [SECONDS]                  Print advertisements and RSSI changes as they arrive (default 10 s)\n"
+        "  quit                             Leave the shell\n"
+        "Every command ends with its latency split into phases.\n");
+  }
+
+  void List() {
+    PhaseTimer timer;
+    const bool from_cache = cache_ && cache_->synced();
+    ble::DeviceQueryResult result = cache_ ? cache_->GetPairedDevices() : session_.GetPairedDevices();
+    timer.Mark("query", from_cache ? "cache" : "bus");
+    if (result.hasError()) {
+      std::printf("Error: %s\n", result.error_message.c_str());
+      timer.Print();
+      return;
+    }
+
+    std::string output;
+    char line[256];
+    for (const auto& device : result.devices) {
+      const std::string rssi = device.rssi ? std::to_string(*device.rssi) + "dBm" : "N/A";
+      std::snprintf(line, sizeof(line), "%s %-5s %-7s %-12s %s\n", device.mac_address.c_str(),
+                    device.adapter.c_str(), rssi.c_str(), device.connected ? "Connected" : "Disconnected",
+                    device.device_name ? device.device_name->c_str() : "N/A");
+      output += line;
+    }
+    output += std::to_string(result.deviceCount()) + " paired devices\n";
+    timer.Mark("format");
+    std::fwrite(output.data(), 1, output.size(), stdout);
+    std::fflush(stdout);
+    timer.Mark("print");
+    timer.Print();
+  }
+
+  void DeviceCommand(const std::string& command, const ble::DeviceAddress& device) {
+    PhaseTimer timer;
+    ble::Result result;
+    if (command == "pair") {
+      // The cache answers at once for a device that needs no pairing
+      const bool paired = cache_ ? cache_->IsDevicePaired(device) : session_.IsDevicePaired(device);
+      timer.Mark("lookup", cache_ && cache_->synced() ? "cache" : "bus");
+      if (paired) {
+        std::printf("Already paired: %s\n", device.mac_address.c_str());
+        timer.Print();
+        return;
+      }
+      result = ble::ScanAndPair(session_, device, Clock::now() + std::chrono::seconds(30));
+      timer.Mark("scan+pair", CallDetail(result));
+      PrintResult(result, "Paired: " + device.mac_address);
+    } else {
+      const bool connect = command == "connect";
+      result = connect ? session_.ConnectDevice(device) : session_.DisconnectDevice(device);
+      timer.Mark("call", CallDetail(result));
+      PrintResult(result, (connect ? "Connected: " : "Disconnected: ") + device.mac_address);
+    }
+    timer.Mark("print");
+    timer.Print();
+  }
+
+  void Scan(int seconds, const std::string& adapter) {
+    PhaseTimer timer;
+    ble::Discovery discovery(session_, adapter);
+    std::atomic<uint32_t> found{0};
+    std::atomic<int64_t> first_ns{0};
+    auto subscription = discovery.Subscribe([&found, &first_ns](const ble::AdvertisementEvent& event) {
+      if (event.flags & ble::AdvertisementEvent::kDeviceFound) {
+        int64_t none = 0;
+        first_ns.compare_exchange_strong(none, event.timestamp_ns);
+        found.fetch_add(1);
+      }
+    });
+    timer.Mark("subscribe");
+
+    const auto started = Clock::now();
+    ble::Result result = discovery.Start();
+    timer.Mark("start");
+    if (result.hasError()) {
+      std::printf("Error: %s\n", result.error_message.c_str());
+      timer.Print();
+      return;
+    }
+    std::this_thread::sleep_for(std::chrono::seconds(seconds));
+    timer.Mark("window");
+    discovery.Stop();
+    timer.Mark("stop");
+
+    std::printf("%u new devices", found.load());
+    if (first_ns.load() != 0) {
+      const auto first = Clock::time_point(std::chrono::nanoseconds(first_ns.load()));
+      std::printf(", first after %.1f ms", Millis(first - started));
+    }
+    std::printf("\n");
+    timer.Print();
+  }
+
+  void Watch(int seconds) {
+    PhaseTimer timer;
+    // Not scanning here: shows what reaches this session while others scan or devices advertise
+    ble::Discovery discovery(session_);
+    std::atomic<uint32_t> events{0};
+    auto subscription = discovery.Subscribe([&events](const ble::AdvertisementEvent& event) {
+      events.fetch_add(1);
+      if (event.flags & ble::AdvertisementEvent::kDeviceFound) {
+        std::printf("  %s found\n", FormatMac(event.mac).c_str());
+      } else if (event.flags & ble::AdvertisementEvent::kRssi) {
+        std::printf("  %s rssi %d dBm\n", FormatMac(event.mac).c_str(), event.rssi);
+      } else {
+        std::printf("  %s advertising data\n", FormatMac(event.mac).c_str());
+      }
+    });
+    if (!subscription) {
+      std::printf("Error: failed to subscribe\n");
+      return;
+    }
+    timer.Mark("subscribe");
+    std::this_thread::sleep_for(std::chrono::seconds(seconds));
+    timer.Mark("watch", std::to_string(events.load()) + " events");
+    subscription = ble::AdvertisementSubscription();
+    timer.Mark("unsubscribe");
+    timer.Print();
+  }
+
+  ble::Session& session_;
+  ble::DeviceCache* cache_;
+};
+
+}  // anonymous namespace
+
+int main(int argc, char* argv[]) {
+  argparse::ArgumentParser parser("ble_shell", "1.0");
+
+  parser.add_description("Interactive Bluetooth shell keeping one BlueZ session and device cache across commands");
+  parser.add_epilog(
+      "Commands: list, pair, connect, disconnect, scan, watch, help, quit.\n"
+      "Every command prints its latency split into phases.\n\n"
+      "Examples:\n"
+      "  ble_shell                          # Start with the device cache\n"
+      "  ble_shell --no-cache               # Query BlueZ for every listing");
+
+  parser.add_argument("--no-cache").flag().help("Do not mirror the BlueZ device tree in memory");
+
+  try {
+    parser.parse_args(argc, argv);
+  } catch (const std::runtime_error& e) {
+    std::cerr << "Error: " << e.what() << "\n";
+    std::cerr << parser;
+    return 1;
+  }
+
+  // Startup pays bus setup and the tree download once
+  PhaseTimer startup;
+  ble::Session session;
+  ble::AdapterQueryResult adapters = session.GetAdapters();
+  startup.Mark("bus", adapters.hasError() ? adapters.error_message
+                                          : std::to_string(adapters.adapters.size()) + " adapters");
+  std::unique_ptr<ble::DeviceCache> cache;
+  if (!parser.get<bool>("--no-cache")) {
+    cache = std::make_unique<ble::DeviceCache>(session);
+    startup.Mark("cache load", cache->synced() ? "synced" : "not synced, using the bus");
+  }
+  std::printf("ble_shell: type help for commands\n");
+  startup.Print();
+
+  Shell shell(session, cache.get());
+  while (char* line = readline("ble> ")) {
+    const std::string command(line);
+    std::free(line);
+    if (command.find_first_not_of(" \t") != std::string::npos) {
+      add_history(command.c_str());
+    }
+    if (!shell.Execute(command)) {
+      break;
+    }
+  }
+  return 0;
+}
@@ -0,0 +1,73 @@
+// MIT License
+// Copyright (c) 2025 pezy
+
+#include <bluetooth/daemon.hpp>
+#include <bluetooth/device_cache.hpp>
+#include <bluetooth/session.hpp>
+#include <csignal>
+#include <iostream>
+#include <memory>
+#include <string>
+
+#include "argparse.hpp"
+
+namespace {
+
+ble::DaemonServer* g_server = nullptr;
+
+void HandleSignal(int) {
+  if (g_server) g_server->Stop();
+}
+
+}  // anonymous namespace
+
+int main(int argc, char* argv[]) {
+  argparse::ArgumentParser parser("bled", "1.0");
+
+  parser.add_description(
+      "Resident Bluetooth daemon: keeps one warm BlueZ session and device cache and serves ble_pair and ble_conn "
+      "over a Unix socket");
+  parser.add_epilog(
+      "ble_pair and ble_conn use the daemon whenever it answers on their socket and talk to BlueZ directly "
+      "otherwise.\n"
+      "The socket is $BLED_SOCKET, else $XDG_RUNTIME_DIR/bled.sock, else /tmp/bled.sock.\n\n"
+      "Examples:\n"
+      "  bled                               # Serve on the default socket\n"
+      "  bled -s /run/bled.sock             # Serve on a given socket\n"
+      "  bled --no-cache                    # Query BlueZ for every listing");
+
+  parser.add_argument("-s", "--socket").default_value(ble::DaemonSocketPath()).help("Unix socket to listen on");
+
+  parser.add_argument("--no-cache").flag().help("Do not mirror the BlueZ device tree in memory");
+
+  try {
+    parser.parse_args(argc, argv);
+  } catch (const std::runtime_error& e) {
+    std::cerr << "Error: " << e.what() << "\n";
+    std::cerr << parser;
+    return 1;
+  }
+
+  ble::Session session;
+  std::unique_ptr<ble::DeviceCache> cache;
+  if (!parser.get<bool>("--no-cache")) {
+    cache = std::make_unique<ble::DeviceCache>(session);
+  }
+
+  ble::DaemonServer server(session);
+  const std::string socket_path = parser.get<std::string>("--socket");
+  ble::Result result = server.Listen(socket_path);
+  if (result.hasError()) {
+    std::cerr << "Error: " << result.error_message << "\n";
+    return result.error_code;
+  }
+
+  g_server = &server;
+  std::signal(SIGINT, HandleSignal);
+  std::signal(SIGTERM, HandleSignal);
+
+  std::cout << "bled listening on " << socket_path << std::endl;
+  server.Run();
+  g_server = nullptr;
+  return 0;
+}
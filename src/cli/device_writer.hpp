@@ -0,0 +1,323 @@
+// MIT License
+// Copyright (c) 2025 pezy
+
+#pragma once
+
+#include <bluetooth/device_cache.hpp>
+#include <bluetooth/device_discovery.hpp>
+#include <charconv>
+#include <cstdio>
+#include <string>
+#include <string_view>
+#include <vector>
+
+namespace ble::cli {
+
+enum class OutputFormat {
+  Text = 0,    // MAC_ADDRESS DEVICE_NAME RSSI CONNECTION_STATUS, for people
+  Json = 1,    // one array of objects
+  Ndjson = 2,  // one object per line
+  Csv = 3      // RFC 4180 with a header row
+};
+
+// "text", "json", "ndjson" or "csv"
+inline bool ParseOutputFormat(const std::string& name, OutputFormat* format) {
+  if (name == "text") {
+    *format = OutputFormat::Text;
+  } else if (name == "json") {
+    *format = OutputFormat::Json;
+  } else if (name == "ndjson") {
+    *format = OutputFormat::Ndjson;
+  } else if (name == "csv") {
+    *format = OutputFormat::Csv;
+  } else {
+    return false;
+  }
+  return true;
+}
+
+// Streams a device listing to a FILE
+//
+// Every device is formatted into one buffer that is reused for the whole
+// listing and handed to the FILE in chunks of about 64 KiB, so a large listing
+// costs a handful of writes instead of several stream insertions per field.
+// The machine formats quote names, so spaces, commas and quotes survive.
+//
+// With events set the output is an unending stream of the listing followed by
+// changes: JSON is written as NDJSON, since an array would never close, and the
+// records of the machine formats gain an event field, "listed" for the listing.
+class DeviceWriter {
+ public:
+  DeviceWriter(std::FILE* out, OutputFormat format, bool events = false)
+      : out_(out), format_(events && format == OutputFormat::Json ? OutputFormat::Ndjson : format), events_(events) {
+    buffer_.reserve(kChunkSize + 512);
+    if (format_ == OutputFormat::Json) {
+      buffer_ += '[';
+    } else if (format_ == OutputFormat::Csv) {
+      buffer_ += events_ ? "event," : "";
+      buffer_ += "mac_address,name,rssi,device_class,adapter,paired,connected\r\n";
+    }
+  }
+
+  ~DeviceWriter() { Finish(); }
+
+  DeviceWriter(const DeviceWriter&) = delete;
+  DeviceWriter& operator=(const DeviceWriter&) = delete;
+
+  // Devices of a GetPairedDevices listing, so paired is always true
+  void Write(const BluetoothDevice& device) {
+    switch (format_) {
+      case OutputFormat::Text:
+        WriteText(device);
+        break;
+      case OutputFormat::Json:
+        if (count_ > 0) buffer_ += ',';
+        buffer_ += "\n  ";
+        WriteObject(device, true, events_ ? "listed" : nullptr, {});
+        break;
+      case OutputFormat::Ndjson:
+        WriteObject(device, true, events_ ? "listed" : nullptr, {});
+        buffer_ += '\n';
+        break;
+      case OutputFormat::Csv:
+        WriteCsv(device, true, events_ ? "listed" : nullptr);
+        break;
+    }
+    ++count_;
+    if (buffer_.size() >= kChunkSize) {
+      Flush();
+    }
+  }
+
+  // One delta of DeviceCache::TakeChanges. Text lines start with +, - or ~,
+  // and a ~ line names only what changed; the machine formats carry the whole
+  // record plus the event and, for "changed", the fields that differ. A
+  // removed device is reported unpaired: it left the listing, mostly because
+  // it was unpaired, and the record shows its last listed state otherwise.
+  void WriteChange(const DeviceChange& change) {
+    static constexpr const char* kEvents[] = {"added", "removed", "changed"};
+    const char* event = kEvents[static_cast<int>(change.kind)];
+    const bool paired = change.kind != DeviceChange::Kind::Removed;
+    const std::vector<std::string_view> fields = ChangedFields(change);
+    switch (format_) {
+      case OutputFormat::Text:
+        if (change.kind == DeviceChange::Kind::Changed) {
+          WriteTextChange(change.device, fields);
+        } else {
+          buffer_ += change.kind == DeviceChange::Kind::Added ? "+ " : "- ";
+          WriteText(change.device);
+        }
+        break;
+      case OutputFormat::Json:
+      case OutputFormat::Ndjson:
+        WriteObject(change.device, paired, event, fields);
+        buffer_ += '\n';
+        break;
+      case OutputFormat::Csv:
+        WriteCsv(change.device, paired, event);
+        break;
+    }
+    ++count_;
+    if (buffer_.size() >= kChunkSize) {
+      Flush();
+    }
+  }
+
+  // Hands buffered output to the FILE without finishing, for streams
+  void Flush() {
+    std::fwrite(buffer_.data(), 1, buffer_.size(), out_);
+    buffer_.clear();
+    std::fflush(out_);
+  }
+
+  // Closes the JSON array and flushes; later calls do nothing
+  void Finish() {
+    if (finished_) {
+      return;
+    }
+    finished_ = true;
+    if (format_ == OutputFormat::Json) {
+      buffer_ += count_ > 0 ? "\n]\n" : "]\n";
+    }
+    Flush();
+  }
+
+  size_t count() const { return count_; }
+
+ private:
+  static constexpr size_t kChunkSize = 64 * 1024;
+
+  template <typename T>
+  void AppendNumber(T value, int base = 10) {
+    char digits[24];
+    const auto end = std::to_chars(digits, digits + sizeof(digits), value, base).ptr;
+    buffer_.append(digits, static_cast<size_t>(end - digits));
+  }
+
+  // JSON names of the fields that differ from the previous state
+  static std::vector<std::string_view> ChangedFields(const DeviceChange& change) {
+    std::vector<std::string_view> fields;
+    if (!change.previous) {
+      return fields;
+    }
+    const BluetoothDevice& before = *change.previous;
+    const BluetoothDevice& now = change.device;
+    if (before.device_name != now.device_name) fields.push_back("name");
+    if (before.rssi != now.rssi) fields.push_back("rssi");
+    if (before.device_class != now.device_class) fields.push_back("device_class");
+    if (before.adapter != now.adapter) fields.push_back("adapter");
+    if (before.connected != now.connected) fields.push_back("connected");
+    return fields;
+  }
+
+  // ~ MAC followed by the new value of each changed field
+  void WriteTextChange(const BluetoothDevice& device, const std::vector<std::string_view>& fields) {
+    buffer_ += "~ ";
+    buffer_ += device.mac_address;
+    for (const std::string_view field : fields) {
+      buffer_ += ' ';
+      if (field == "connected") {
+        buffer_ += device.connected ? "Connected" : "Disconnected";
+      } else if (field == "rssi") {
+        if (device.rssi) {
+          AppendNumber(*device.rssi);
+          buffer_ += "dBm";
+        } else {
+          buffer_ += "RSSI N/A";
+        }
+      } else if (field == "name") {
+        buffer_ += "name ";
+        buffer_ += device.device_name && !device.device_name->empty() ? *device.device_name : "N/A";
+      } else if (field == "device_class") {
+        buffer_ += "class ";
+        if (device.device_class) {
+          buffer_ += "0x";
+          AppendNumber(*device.device_class, 16);
+        } else {
+          buffer_ += "N/A";
+        }
+      } else {
+        buffer_ += "adapter ";
+        buffer_ += device.adapter;
+      }
+    }
+    buffer_ += '\n';
+  }
+
+  void WriteText(const BluetoothDevice& device) {
+    buffer_ += device.mac_address;
+    buffer_ += ' ';
+    buffer_ += device.device_name && !device.device_name->empty() ? *device.device_name : "N/A";
+    buffer_ += ' ';
+    if (device.rssi) {
+      AppendNumber(*device.rssi);
+      buffer_ += "dBm ";
+    } else {
+      buffer_ += "N/A ";
+    }
+    buffer_ += device.connected ? "Connected\n" : "Disconnected\n";
+  }
+
+  void AppendJsonString(std::string_view value) {
+    static constexpr char kHex[] = "0123456789abcdef";
+    buffer_ += '"';
+    for (const char c : value) {
+      const auto byte = static_cast<unsigned char>(c);
+      if (c == '"' || c == '\\') {
+        buffer_ += '\\';
+        buffer_ += c;
+      } else if (byte < 0x20) {
+        buffer_ += "\\u00";
+        buffer_ += kHex[byte >> 4];
+        buffer_ += kHex[byte & 0xF];
+      } else {
+        buffer_ += c;
+      }
+    }
+    buffer_ += '"';
+  }
+
+  // event and changed are left out when null and empty
+  void WriteObject(const BluetoothDevice& device, bool paired, const char* event,
+                   const std::vector<std::string_view>& changed) {
+    buffer_ += '{';
+    if (event) {
+      buffer_ += "\"event\":\"";
+      buffer_ += event;
+      buffer_ += "\",";
+    }
+    if (!changed.empty()) {
+      buffer_ += "\"changed\":[";
+      for (size_t i = 0; i < changed.size(); ++i) {
+        if (i > 0) buffer_ += ',';
+        AppendJsonString(changed[i]);
+      }
+      buffer_ += "],";
+    }
+    buffer_ += "\"mac_address\":";
+    AppendJsonString(device.mac_address);
+    buffer_ += ",\"name\":";
+    if (device.device_name) {
+      AppendJsonString(*device.device_name);
+    } else {
+      buffer_ += "null";
+    }
+    buffer_ += ",\"rssi\":";
+    if (device.rssi) {
+      AppendNumber(*device.rssi);
+    } else {
+      buffer_ += "null";
+    }
+    buffer_ += ",\"device_class\":";
+    if (device.device_class) {
+      AppendNumber(*device.device_class);
+    } else {
+      buffer_ += "null";
+    }
+    buffer_ += ",\"adapter\":";
+    AppendJsonString(device.adapter);
+    buffer_ += paired ? ",\"paired\":true,\"connected\":" : ",\"paired\":false,\"connected\":";
+    buffer_ += device.connected ? "true}" : "false}";
+  }
+
+  // Quoted only when the field needs it
+  void AppendCsvField(std::string_view value) {
+    if (value.find_first_of(",\"\r\n") == std::string_view::npos) {
+      buffer_ += value;
+      return;
+    }
+    buffer_ += '"';
+    for (const char c : value) {
+      if (c == '"') buffer_ += '"';
+      buffer_ += c;
+    }
+    buffer_ += '"';
+  }
+
+  void WriteCsv(const BluetoothDevice& device, bool paired, const char* event) {
+    if (event) {
+      buffer_ += event;
+      buffer_ += ',';
+    }
+    AppendCsvField(device.mac_address);
+    buffer_ += ',';
+    if (device.device_name) AppendCsvField(*device.device_name);
+    buffer_ += ',';
+    if (device.rssi) AppendNumber(*device.rssi);
+    buffer_ += ',';
+    if (device.device_class) AppendNumber(*device.device_class);
+    buffer_ += ',';
+    AppendCsvField(device.adapter);
+    buffer_ += paired ? ",true," : ",false,";
+    buffer_ += device.connected ? "true\r\n" : "false\r\n";
+  }
+
+  std::FILE* out_;
+  const OutputFormat format_;
+  const bool events_;
+  std::string buffer_;
+  size_t count_{0};
+  bool finished_{false};
+};
+
+}  // namespace ble::cli
@@ -0,0 +1,89 @@
+// MIT License
+// Copyright (c) 2025 pezy
+
+#pragma once
+
+#include <bluetooth/device_discovery.hpp>
+#include <bluetooth/session.hpp>
+#include <chrono>
+#include <cstddef>
+#include <span>
+#include <string>
+#include <vector>
+
+namespace ble {
+
+struct BatchOptions {
+  // Calls kept in flight at once, 0 issues every call immediately
+  size_t max_in_flight{16};
+  int timeout_seconds{30};
+};
+
+// Connects every device with concurrent D-Bus calls and blocks until all have
+// completed. results[i] belongs to mac_addresses[i] and carries its own
+// operation_time, so total wall time tracks the slowest device rather than the
+// sum. Must not be called from a completion callback.
+std::vector<Result> ConnectDevices(std::span<const std::string> mac_addresses,
+                                   const BatchOptions& options = BatchOptions());
+
+std::vector<Result> ConnectDevices(Session& session, std::span<const std::string> mac_addresses,
+                                   const BatchOptions& options = BatchOptions());
+
+// Same, with each device on the adapter its address names
+std::vector<Result> ConnectDevices(std::span<const DeviceAddress> devices,
+                                   const BatchOptions& options = BatchOptions());
+
+std::vector<Result> ConnectDevices(Session& session, std::span<const DeviceAddress> devices,
+                                   const BatchOptions& options = BatchOptions());
+
+struct DisconnectOptions {
+  // Calls kept in flight at once, 0 issues every call immediately
+  size_t max_in_flight{0};
+  int timeout_seconds{10};
+  // Send every Disconnect with NO_REPLY_EXPECTED and return after a single
+  // flush. Results then only tell that the call went out, not that BlueZ
+  // completed it. Meant for fast shutdown.
+  bool no_reply{false};
+};
+
+struct DeviceResult {
+  std::string mac_address;
+  Result result;
+  std::string adapter{};
+};
+
+// success and error_code describe the GetManagedObjects pass, per-device
+// outcomes are in devices
+struct DisconnectAllResult {
+  std::vector<DeviceResult> devices;  // one entry per device that was connected
+  bool success{false};
+  int error_code{0};
+  std::string error_message{""};
+  std::chrono::milliseconds operation_time{0};
+
+  // Convenience methods
+  bool hasError() const { return !success || error_code != 0; }
+};
+
+// Disconnects every listed device with concurrent D-Bus calls. Connection state
+// is read from a single GetManagedObjects pass, devices that are not connected
+// succeed without a call. results[i] belongs to mac_addresses[i].
+std::vector<Result> DisconnectDevices(std::span<const std::string> mac_addresses,
+                                      const DisconnectOptions& options = DisconnectOptions());
+
+std::vector<Result> DisconnectDevices(Session& session, std::span<const std::string> mac_addresses,
+                                      const DisconnectOptions& options = DisconnectOptions());
+
+std::vector<Result> DisconnectDevices(std::span<const DeviceAddress> devices,
+                                      const DisconnectOptions& options = DisconnectOptions());
+
+std::vector<Result> DisconnectDevices(Session& session, std::span<const DeviceAddress> devices,
+                                      const DisconnectOptions& options = DisconnectOptions());
+
+// Disconnects every connected device on every adapter, paired or not, found in
+// a single GetManagedObjects pass
+DisconnectAllResult DisconnectAll(const DisconnectOptions& options = DisconnectOptions());
+
+DisconnectAllResult DisconnectAll(Session& session, const DisconnectOptions& options = DisconnectOptions());
+
+}  // namespace ble
@@ -0,0 +1,76 @@
+// MIT License
+// Copyright (c) 2025 pezy
+
+#pragma once
+
+#include <bluetooth/device_discovery.hpp>
+#include <bluetooth/session.hpp>
+#include <chrono>
+#include <cstdint>
+#include <memory>
+#include <optional>
+#include <string>
+#include <vector>
+
+namespace ble {
+
+struct KeeperOptions {
+  // Wait after the n-th failed reconnect attempt, jittered as in RetryPolicy;
+  // the first attempt after a drop starts at once
+  std::chrono::milliseconds initial_backoff{100};
+  std::chrono::milliseconds max_backoff{10000};
+  double multiplier{2.0};
+  int timeout_seconds{30};  // per attempt
+};
+
+struct KeptDeviceStats {
+  std::string mac_address;
+  std::string adapter;
+  bool connected{false};
+  uint64_t drops{0};                // Connected went false while the device was kept
+  uint64_t reconnects{0};           // drops recovered from
+  uint64_t reconnect_attempts{0};   // Connect calls, including the one made by Add
+  std::chrono::milliseconds last_reconnect_latency{0};  // from the drop signal to connected again
+  std::chrono::milliseconds max_reconnect_latency{0};
+  std::chrono::milliseconds time_disconnected{0};  // summed over drops, including an ongoing one
+};
+
+// Keeps a set of devices connected
+//
+// Watches Device1.Connected through PropertiesChanged, so a drop is noticed
+// as soon as bluetoothd reports it, without polling. The device or its
+// adapter going away and bluetoothd exiting count as drops too, as does the
+// bus connection closing, after which the keeper subscribes again. Each drop
+// starts a Connect right away; failed attempts are repeated with jittered
+// exponential backoff until the device is connected again or removed, and at
+// once when its object reappears. Attempts bypass the session's RetryPolicy.
+// Add connects a device that is not connected yet.
+//
+// All methods are thread-safe. Signals and attempts are handled on the
+// session's internal thread. Subscribing again after the connection closed
+// happens on a thread of the keeper's own, retried with the backoff above
+// while the bus is unreachable. Destruction waits for attempts in flight.
+class ConnectionKeeper {
+ public:
+  class Impl;
+
+  explicit ConnectionKeeper(Session& session = Session::Default(), const KeeperOptions& options = KeeperOptions());
+  ~ConnectionKeeper();
+
+  ConnectionKeeper(const ConnectionKeeper&) = delete;
+  ConnectionKeeper& operator=(const ConnectionKeeper&) = delete;
+
+  // Fails only for an invalid address or when the bus cannot be reached; adding a kept device again is a no-op
+  Result Add(const DeviceAddress& device);
+
+  // Stops keeping the device without disconnecting it; false when it was not kept
+  bool Remove(const DeviceAddress& device);
+
+  std::optional<KeptDeviceStats> Stats(const DeviceAddress& device) const;
+  std::vector<KeptDeviceStats> Stats() const;
+
+ private:
+  std::unique_ptr<Impl> impl_;
+};
+
+}  // namespace ble
@@ -0,0 +1,113 @@
+// MIT License
+// Copyright (c) 2025 pezy
+
+#pragma once
+
+#include <bluetooth/batch.hpp>
+#include <bluetooth/device_discovery.hpp>
+#include <bluetooth/session.hpp>
+#include <chrono>
+#include <cstddef>
+#include <cstdint>
+#include <functional>
+#include <future>
+#include <memory>
+#include <span>
+#include <string>
+#include <vector>
+
+namespace ble {
+
+struct SchedulerOptions {
+  // Adapters to spread connections over, empty uses every powered adapter
+  std::vector<std::string> adapters;
+  // Connections a controller can hold at once; attempts beyond it are not made
+  size_t max_connections_per_adapter{7};
+  // Connect calls in flight per adapter. BlueZ carries out one attempt at a
+  // time per controller, so more mostly adds queueing inside bluetoothd.
+  size_t max_attempts_per_adapter{1};
+  int timeout_seconds{30};
+  // Requests waiting for a slot; further ones are rejected. 0 means unlimited.
+  size_t max_queued{0};
+};
+
+// Per-request scheduling
+struct RequestOptions {
+  // Higher runs first; equal priorities run earliest deadline first, then in submission order
+  int priority{0};
+  // Point by which the operation has to complete, none by default. The request
+  // fails fast once it can no longer make it: when it is still queued at the
+  // deadline minus the average attempt time of its fastest adapter. A started
+  // attempt gets the remaining time as its D-Bus timeout.
+  std::chrono::steady_clock::time_point deadline{};
+};
+
+// Load of one adapter as the scheduler sees it
+struct AdapterLoad {
+  std::string adapter;
+  size_t connected{0};
+  size_t in_flight{0};
+  uint64_t attempts{0};                        // Connect and Pair calls completed through this adapter
+  std::chrono::milliseconds average_attempt{0};  // moving average of their duration
+};
+
+// Completion callback, run on the session's internal thread; DeviceResult::adapter names the adapter used
+using ScheduledCallback = std::function<void(const DeviceResult&)>;
+
+// Schedules Connect and Pair calls over several adapters
+//
+// A device can only be connected through an adapter that has its object,
+// i.e. one that paired with or discovered it. Each request goes to the least
+// loaded such adapter (connections plus attempts in flight) that still has a
+// free attempt slot and is below its connection limit; a Pair takes an attempt
+// slot like a Connect. Requests that cannot start yet wait in priority order
+// (see RequestOptions) without blocking those that can start on another
+// adapter, so attempts on different adapters run in parallel. Operations on
+// the same device never overlap.
+//
+// The adapters and the devices they know are read with one GetManagedObjects
+// call at construction (a failed read leaves the scheduler empty until a
+// Refresh succeeds); Refresh reads them again. Connections made or released
+// through the scheduler are tracked from there on. Destroying the scheduler
+// fails queued requests and waits for attempts in flight. Must not be
+// constructed or destroyed from a completion callback.
+class ConnectionScheduler {
+ public:
+  class Impl;
+
+  explicit ConnectionScheduler(Session& session = Session::Default(), const SchedulerOptions& options = {});
+  ~ConnectionScheduler();
+
+  ConnectionScheduler(const ConnectionScheduler&) = delete;
+  ConnectionScheduler& operator=(const ConnectionScheduler&) = delete;
+
+  // Queues a connect; never blocks. Fails without an attempt with DeviceNotFound
+  // when no scheduled adapter knows the device, with ConnectionFailed when all
+  // that do are at max_connections_per_adapter or the queue is full, and with
+  // ConnectionTimeout when the deadline can no longer be met.
+  void Connect(const std::string& mac_address, ScheduledCallback callback,
+               const RequestOptions& request = RequestOptions());
+  std::future<DeviceResult> Connect(const std::string& mac_address, const RequestOptions& request = RequestOptions());
+
+  // Queues a pair, failing early as Connect does with PairingFailed and PairingTimeout
+  void Pair(const std::string& mac_address, ScheduledCallback callback,
+            const RequestOptions& request = RequestOptions());
+  std::future<DeviceResult> Pair(const std::string& mac_address, const RequestOptions& request = RequestOptions());
+
+  // Connects every device and blocks until all have completed; results[i] belongs to mac_addresses[i]
+  std::vector<DeviceResult> ConnectAll(std::span<const std::string> mac_addresses,
+                                       const RequestOptions& request = RequestOptions());
+
+  // Disconnects the device through the adapter it is connected on, freeing its slot
+  Result Disconnect(const std::string& mac_address, int timeout_seconds = 10);
+
+  // Re-reads adapters, known devices and connection state from BlueZ
+  Result Refresh();
+
+  std::vector<AdapterLoad> Load() const;
+
+ private:
+  std::unique_ptr<Impl> impl_;
+};
+
+}  // namespace ble
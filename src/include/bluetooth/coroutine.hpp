@@ -0,0 +1,260 @@
+// MIT License
+// Copyright (c) 2025 pezy
+
+#pragma once
+
+#include <bluetooth/device_discovery.hpp>
+#include <bluetooth/session.hpp>
+#include <coroutine>
+#include <exception>
+#include <functional>
+#include <future>
+#include <memory>
+#include <optional>
+#include <string>
+#include <type_traits>
+#include <utility>
+
+// C++20 coroutine front end for the asynchronous operations
+//
+// Coroutines run on an Executor, which is the GLib thread of a Session: they
+// start there and every co_await on a BlueZ operation resumes there when the
+// reply arrives, so thousands of concurrent sequences share one thread.
+//
+//   ble::Task<ble::Result> Provision(std::string mac) {
+//     if (auto r = co_await ble::Pair(mac); r.error_code != 0) co_return r;
+//     if (auto r = co_await ble::Trust(mac); r.hasError()) co_return r;
+//     co_return co_await ble::Connect(mac);
+//   }
+//   auto done = ble::Executor().Spawn(Provision("AA:BB:CC:DD:EE:FF"));
+//
+// Coroutine bodies must not block: never wait on a std::future inside one.
+
+namespace ble {
+
+// Awaitable for one asynchronous operation completing with a value of type T
+template <typename T>
+class OperationAwaitable {
+ public:
+  using Starter = std::function<void(std::function<void(const T&)>)>;
+
+  explicit OperationAwaitable(Starter start) : start_(std::move(start)) {}
+
+  bool await_ready() const noexcept { return false; }
+
+  // Completions are always posted to the loop thread, never run inside start_
+  void await_suspend(std::coroutine_handle<> handle) {
+    start_([this, handle](const T& value) {
+      value_ = value;
+      handle.resume();
+    });
+  }
+
+  T await_resume() { return std::move(*value_); }
+
+ private:
+  Starter start_;
+  std::optional<T> value_;
+};
+
+namespace detail {
+
+template <typename T>
+class TaskPromiseBase {
+ public:
+  void return_value(T value) { value_ = std::move(value); }
+  T take() {
+    if (exception_) std::rethrow_exception(exception_);
+    return std::move(*value_);
+  }
+
+ protected:
+  std::optional<T> value_;
+  std::exception_ptr exception_;
+};
+
+template <>
+class TaskPromiseBase<void> {
+ public:
+  void return_void() {}
+  void take() {
+    if (exception_) std::rethrow_exception(exception_);
+  }
+
+ protected:
+  std::exception_ptr exception_;
+};
+
+}  // namespace detail
+
+// Lazily started coroutine. co_await it from another Task, or hand it to Executor::Spawn.
+template <typename T = void>
+class [[nodiscard]] Task {
+ public:
+  class promise_type : public detail::TaskPromiseBase<T> {
+   public:
+    Task get_return_object() { return Task(std::coroutine_handle<promise_type>::from_promise(*this)); }
+    std::suspend_always initial_suspend() noexcept { return {}; }
+
+    // Resumes the awaiting coroutine by symmetric transfer, so long chains do not grow the stack
+    auto final_suspend() noexcept {
+      struct FinalAwaiter {
+        bool await_ready() noexcept { return false; }
+        std::coroutine_handle<> await_suspend(std::coroutine_handle<promise_type> handle) noexcept {
+          auto continuation = handle.promise().continuation_;
+          return continuation ? continuation : std::noop_coroutine();
+        }
+        void await_resume() noexcept {}
+      };
+      return FinalAwaiter{};
+    }
+
+    void unhandled_exception() { this->exception_ = std::current_exception(); }
+
+   private:
+    friend class Task;
+    std::coroutine_handle<> continuation_;
+  };
+
+  Task(Task&& other) noexcept : handle_(std::exchange(other.handle_, nullptr)) {}
+  Task& operator=(Task&& other) noexcept {
+    if (this != &other) {
+      if (handle_) handle_.destroy();
+      handle_ = std::exchange(other.handle_, nullptr);
+    }
+    return *this;
+  }
+  Task(const Task&) = delete;
+  Task& operator=(const Task&) = delete;
+  ~Task() {
+    if (handle_) handle_.destroy();
+  }
+
+  bool await_ready() const noexcept { return false; }
+  std::coroutine_handle<> await_suspend(std::coroutine_handle<> continuation) noexcept {
+    handle_.promise().continuation_ = continuation;
+    return handle_;
+  }
+  T await_resume() { return handle_.promise().take(); }
+
+ private:
+  explicit Task(std::coroutine_handle<promise_type> handle) : handle_(handle) {}
+
+  std::coroutine_handle<promise_type> handle_;
+};
+
+namespace detail {
+
+// Eagerly destroyed wrapper that drives a Task to completion and publishes its outcome
+struct DetachedTask {
+  struct promise_type {
+    DetachedTask get_return_object() { return {std::coroutine_handle<promise_type>::from_promise(*this)}; }
+    std::suspend_always initial_suspend() noexcept { return {}; }
+    std::suspend_never final_suspend() noexcept { return {}; }
+    void return_void() {}
+    void unhandled_exception() { std::terminate(); }
+  };
+
+  std::coroutine_handle<promise_type> handle;
+};
+
+template <typename T>
+DetachedTask RunToPromise(Task<T> task, std::shared_ptr<std::promise<T>> promise) {
+  try {
+    if constexpr (std::is_void_v<T>) {
+      co_await std::move(task);
+      promise->set_value();
+    } else {
+      promise->set_value(co_await std::move(task));
+    }
+  } catch (...) {
+    promise->set_exception(std::current_exception());
+  }
+}
+
+}  // namespace detail
+
+// Runs coroutines on a session's GLib thread
+class Executor {
+ public:
+  explicit Executor(Session& session = Session::Default()) : session_(&session) {}
+
+  Session& session() const { return *session_; }
+
+  // Starts task on the loop thread; the future is ready once the task finishes
+  template <typename T>
+  std::future<T> Spawn(Task<T> task) {
+    auto promise = std::make_shared<std::promise<T>>();
+    auto future = promise->get_future();
+    auto handle = detail::RunToPromise(std::move(task), std::move(promise)).handle;
+    session_->Post([handle]() { handle.resume(); });
+    return future;
+  }
+
+  // co_await executor.Schedule() moves the current coroutine onto the loop thread
+  auto Schedule() {
+    struct ScheduleAwaiter {
+      Session* session;
+      bool await_ready() const noexcept { return false; }
+      void await_suspend(std::coroutine_handle<> handle) {
+        session->Post([handle]() { handle.resume(); });
+      }
+      void await_resume() const noexcept {}
+    };
+    return ScheduleAwaiter{session_};
+  }
+
+ private:
+  Session* session_;
+};
+
+// Awaitable operations. The address is copied, so temporaries are safe to pass.
+inline OperationAwaitable<Result> Pair(Session& session, DeviceAddress device, int timeout_seconds = 30) {
+  return OperationAwaitable<Result>([&session, device = std::move(device), timeout_seconds](auto done) {
+    session.PairDeviceAsync(device, std::move(done), timeout_seconds);
+  });
+}
+
+inline OperationAwaitable<Result> Connect(Session& session, DeviceAddress device, int timeout_seconds = 30) {
+  return OperationAwaitable<Result>([&session, device = std::move(device), timeout_seconds](auto done) {
+    session.ConnectDeviceAsync(device, std::move(done), timeout_seconds);
+  });
+}
+
+inline OperationAwaitable<Result> Disconnect(Session& session, DeviceAddress device, int timeout_seconds = 10) {
+  return OperationAwaitable<Result>([&session, device = std::move(device), timeout_seconds](auto done) {
+    session.DisconnectDeviceAsync(device, std::move(done), timeout_seconds);
+  });
+}
+
+inline OperationAwaitable<Result> Trust(Session& session, DeviceAddress device) {
+  return OperationAwaitable<Result>([&session, device = std::move(device)](auto done) {
+    session.TrustDeviceAsync(device, std::move(done));
+  });
+}
+
+inline OperationAwaitable<DeviceQueryResult> PairedDevices(Session& session) {
+  return OperationAwaitable<DeviceQueryResult>(
+      [&session](auto done) { session.GetPairedDevicesAsync(std::move(done)); });
+}
+
+// Same operations on Session::Default()
+inline OperationAwaitable<Result> Pair(DeviceAddress device, int timeout_seconds = 30) {
+  return Pair(Session::Default(), std::move(device), timeout_seconds);
+}
+
+inline OperationAwaitable<Result> Connect(DeviceAddress device, int timeout_seconds = 30) {
+  return Connect(Session::Default(), std::move(device), timeout_seconds);
+}
+
+inline OperationAwaitable<Result> Disconnect(DeviceAddress device, int timeout_seconds = 10) {
+  return Disconnect(Session::Default(), std::move(device), timeout_seconds);
+}
+
+inline OperationAwaitable<Result> Trust(DeviceAddress device) {
+  return Trust(Session::Default(), std::move(device));
+}
+
+inline OperationAwaitable<DeviceQueryResult> PairedDevices() { return PairedDevices(Session::Default()); }
+
+}  // namespace ble
@@ -0,0 +1,85 @@
+// MIT License
+// Copyright (c) 2025 pezy
+
+#pragma once
+
+#include <bluetooth/device_discovery.hpp>
+#include <bluetooth/session.hpp>
+#include <chrono>
+#include <memory>
+#include <string>
+
+namespace ble {
+
+// Unix socket bled serves on: $BLED_SOCKET if set, else
+// $XDG_RUNTIME_DIR/bled.sock, else /tmp/bled.sock
+std::string DaemonSocketPath();
+
+// Serves a session over a Unix domain socket, as the bled daemon does
+//
+// Clients send length-prefixed binary requests (see DaemonClient) and get one
+// response per request, in order. Each client connection is served on its own
+// thread with blocking session calls, so a slow Pair holds up only its own
+// client; up to 64 clients are served at once, and further connections are
+// closed right away. Only processes of the daemon's own user are served. Attach
+// a DeviceCache to the session to answer listings from memory.
+class DaemonServer {
+ public:
+  class Impl;
+
+  explicit DaemonServer(Session& session = Session::Default());
+  ~DaemonServer();
+
+  DaemonServer(const DaemonServer&) = delete;
+  DaemonServer& operator=(const DaemonServer&) = delete;
+
+  // Binds path with mode 0600, replacing a stale socket file; fails when
+  // another daemon still answers there
+  Result Listen(const std::string& path = DaemonSocketPath());
+
+  // Accepts and serves clients until Stop; returns once every client thread
+  // has finished. Listen must have succeeded.
+  void Run();
+
+  // Makes Run return. Async-signal-safe, so it may be called from a SIGTERM handler.
+  void Stop();
+
+ private:
+  std::unique_ptr<Impl> impl_;
+};
+
+// Connection to bled, with the blocking calls of Session
+//
+// Construction only tries to connect; check connected() and fall back to a
+// Session when no daemon runs. A call on a connection the daemon has closed
+// fails with ErrorCode::DaemonUnavailable, one the daemon could not accept
+// with ErrorCode::DaemonRequestRejected. Not thread-safe: one request is in
+// flight at a time.
+class DaemonClient {
+ public:
+  class Impl;
+
+  explicit DaemonClient(const std::string& path = DaemonSocketPath());
+  ~DaemonClient();
+
+  DaemonClient(const DaemonClient&) = delete;
+  DaemonClient& operator=(const DaemonClient&) = delete;
+
+  bool connected() const;
+
+  DeviceQueryResult GetPairedDevices();
+
+  Result PairDevice(const DeviceAddress& device, int timeout_seconds = 30);
+
+  // As ble::ScanAndPair; the deadline travels as the time left
+  Result ScanAndPair(const DeviceAddress& device, std::chrono::steady_clock::time_point deadline);
+
+  Result ConnectDevice(const DeviceAddress& device, int timeout_seconds = 30);
+
+  Result DisconnectDevice(const DeviceAddress& device, int timeout_seconds = 10);
+
+ private:
+  std::unique_ptr<Impl> impl_;
+};
+
+}  // namespace ble
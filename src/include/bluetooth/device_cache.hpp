@@ -0,0 +1,69 @@
+// MIT License
+// Copyright (c) 2025 pezy
+
+#pragma once
+
+#include <bluetooth/device_discovery.hpp>
+#include <bluetooth/session.hpp>
+#include <memory>
+#include <optional>
+#include <string>
+#include <vector>
+
+namespace ble {
+
+// A device that entered, left or changed in the paired listing
+struct DeviceChange {
+  enum class Kind { Added = 0, Removed = 1, Changed = 2 };
+
+  Kind kind{Kind::Changed};
+  BluetoothDevice device{};  // current state; the last one listed when removed
+  std::optional<BluetoothDevice> previous{};  // state at the previous TakeChanges, for Changed
+};
+
+// Opt-in in-memory mirror of the BlueZ device tree
+//
+// Loads the tree with one GetManagedObjects call, then keeps it current from
+// the InterfacesAdded, InterfacesRemoved and PropertiesChanged signals, which
+// the session's internal thread dispatches. While a cache is alive and synced,
+// GetPairedDevices and IsDevicePaired of its session (and the free functions
+// for the default session) are answered from memory without touching the
+// bus. It falls back to the bus while BlueZ is away and reloads when
+// bluetoothd comes back.
+//
+// Construct it after, and destroy it before, its session. Must not be
+// constructed or destroyed from a completion callback.
+class DeviceCache {
+ public:
+  class Impl;
+
+  // Blocks until the initial load has completed or failed
+  explicit DeviceCache(Session& session = Session::Default());
+  ~DeviceCache();
+
+  DeviceCache(const DeviceCache&) = delete;
+  DeviceCache& operator=(const DeviceCache&) = delete;
+
+  // Answered from memory while synced, from the bus otherwise
+  DeviceQueryResult GetPairedDevices();
+
+  // Hash lookup by packed 48-bit MAC while synced, independent of the device count
+  bool IsDevicePaired(const DeviceAddress& device);
+
+  // True once the tree is loaded and as long as the signal stream is intact
+  bool synced() const;
+
+  // Net changes to the paired listing since the previous call, one entry per
+  // device however many signals it got in between; a device whose properties
+  // went back to where they were is left out. The first call after the tree
+  // has loaded starts tracking and returns nothing. Changes made while the
+  // cache is not synced, e.g. across a bluetoothd restart, are reported once
+  // it has reloaded.
+  std::vector<DeviceChange> TakeChanges();
+
+ private:
+  Session& session_;
+  std::unique_ptr<Impl> impl_;
+};
+
+}  // namespace ble
@@ -4,9 +4,12 @@
 #pragma once
 
 #include <chrono>
+#include <functional>
+#include <future>
 #include <optional>
 #include <stdexcept>
 #include <string>
+#include <utility>
 #include <vector>
 
 namespace ble {
@@ -24,7 +27,11 @@ enum class ErrorCode {
   PairingTimeout = 8,
   ConnectionFailed = 9,
   DisconnectFailed = 10,
-  ConnectionTimeout = 11
+  ConnectionTimeout = 11,
+  TrustFailed = 12,
+  DiscoveryFailed = 13,
+  DaemonUnavailable = 14,
+  DaemonRequestRejected = 15
 };
 
 // Exception class
@@ -37,6 +44,19 @@ class BluetoothException : public std::runtime_error {
   const ErrorCode error_code_;
 };
 
+// A device as seen through one adapter. BlueZ keeps a separate object per
+// adapter, so the same MAC known to two controllers is two devices. An empty
+// adapter means the session's default adapter (SessionOptions::default_adapter).
+struct DeviceAddress {
+  DeviceAddress(const std::string& mac) : mac_address(mac) {}  // NOLINT(runtime/explicit)
+  DeviceAddress(const char* mac) : mac_address(mac) {}         // NOLINT(runtime/explicit)
+  DeviceAddress(std::string mac, std::string adapter_name)
+      : mac_address(std::move(mac)), adapter(std::move(adapter_name)) {}
+
+  std::string mac_address;
+  std::string adapter;  // controller name, e.g. "hci1"
+};
+
 // Device information structure
 struct BluetoothDevice {
   std::string mac_address;
@@ -44,6 +64,15 @@ struct BluetoothDevice {
   std::optional<uint32_t> device_class;
   std::optional<int16_t> rssi;
   bool connected;
+  std::string adapter{};  // controller the device belongs to, e.g. "hci0"
+};
+
+// Adapter (controller) information from org.bluez.Adapter1
+struct AdapterInfo {
+  std::string name;  // e.g. "hci0", as used in DeviceAddress::adapter
+  std::string address;
+  bool powered{false};
+  bool discovering{false};
 };
 
 // Query result structure
@@ -59,26 +88,67 @@ struct DeviceQueryResult {
   size_t deviceCount() const { return devices.size(); }
 };
 
+struct AdapterQueryResult {
+  std::vector<AdapterInfo> adapters;  // sorted by name
+  bool success{false};
+  int error_code{0};
+  std::string error_message{""};
+  std::chrono::milliseconds query_time{0};
+
+  // Convenience methods
+  bool hasError() const { return !success || error_code != 0; }
+};
+
 struct Result {
   bool success{false};
   int error_code{0};
   std::string error_message{""};
   std::chrono::milliseconds operation_time{0};
+  // Duration of each attempt when the call ran under a RetryPolicy (see retry.hpp), empty otherwise
+  std::vector<std::chrono::milliseconds> attempt_times{};
 
   // Convenience methods
   bool hasError() const { return !success || error_code != 0; }
+  size_t attempts() const { return attempt_times.empty() ? 1 : attempt_times.size(); }
 };
 
+// Completion callbacks for the asynchronous functions. They run on the
+// library's internal GLib thread and must not block or throw.
+using ResultCallback = std::function<void(const Result&)>;
+using DeviceQueryCallback = std::function<void(const DeviceQueryResult&)>;
+
 // Core interface functions
-DeviceQueryResult GetPairedDevices();
+DeviceQueryResult GetPairedDevices();  // in object path order: by adapter, then address
+
+AdapterQueryResult GetAdapters();
+
+bool IsDevicePaired(const DeviceAddress& device);
+
+Result PairDevice(const DeviceAddress& device, int timeout_seconds = 30);
+
+Result ConnectDevice(const DeviceAddress& device, int timeout_seconds = 30);
+
+Result DisconnectDevice(const DeviceAddress& device, int timeout_seconds = 10);
+
+Result TrustDevice(const DeviceAddress& device, bool trusted = true);
+
+// Asynchronous interface functions. Every in-flight operation shares the one
+// internal GLib thread; none of them blocks the caller. Do not wait on the
+// returned futures from inside a completion callback.
+std::future<DeviceQueryResult> GetPairedDevicesAsync();
+void GetPairedDevicesAsync(DeviceQueryCallback callback);
 
-bool IsDevicePaired(const std::string& mac_address);
+std::future<Result> PairDeviceAsync(const DeviceAddress& device, int timeout_seconds = 30);
+void PairDeviceAsync(const DeviceAddress& device, ResultCallback callback, int timeout_seconds = 30);
 
-Result PairDevice(const std::string& mac_address, int timeout_seconds = 30);
+std::future<Result> ConnectDeviceAsync(const DeviceAddress& device, int timeout_seconds = 30);
+void ConnectDeviceAsync(const DeviceAddress& device, ResultCallback callback, int timeout_seconds = 30);
 
-Result ConnectDevice(const std::string& mac_address, int timeout_seconds = 30);
+std::future<Result> DisconnectDeviceAsync(const DeviceAddress& device, int timeout_seconds = 10);
+void DisconnectDeviceAsync(const DeviceAddress& device, ResultCallback callback, int timeout_seconds = 10);
 
-Result DisconnectDevice(const std::string& mac_address, int timeout_seconds = 10);
+std::future<Result> TrustDeviceAsync(const DeviceAddress& device);
+void TrustDeviceAsync(const DeviceAddress& device, ResultCallback callback);
 
 // Error code utility function
 std::string ErrorCodeToMessage(ErrorCode code);
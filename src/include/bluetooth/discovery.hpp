@@ -0,0 +1,133 @@
+// MIT License
+// Copyright (c) 2025 pezy
+
+#pragma once
+
+#include <bluetooth/device_discovery.hpp>
+#include <bluetooth/session.hpp>
+#include <bluetooth/spsc_ring.hpp>
+#include <chrono>
+#include <cstdint>
+#include <functional>
+#include <memory>
+#include <mutex>
+#include <optional>
+#include <string>
+#include <vector>
+
+namespace ble {
+
+enum class DiscoveryTransport { Auto = 0, LowEnergy = 1, BrEdr = 2 };
+
+// Adapter1.SetDiscoveryFilter. BlueZ drops everything that does not match
+// before it becomes a signal, so a tight filter cuts the PropertiesChanged
+// volume a busy site produces. Unset fields keep BlueZ's defaults.
+struct DiscoveryFilter {
+  std::optional<int16_t> rssi;       // report only devices at or above this RSSI, in dBm
+  std::optional<uint16_t> pathloss;  // or at or below this pathloss, in dB; not both
+  std::vector<std::string> uuids;    // advertising any of these service UUIDs
+  DiscoveryTransport transport{DiscoveryTransport::Auto};
+  bool duplicate_data{true};  // false reports a device again only when its advertising data changed
+  std::string pattern;        // address or name prefix, empty matches all
+};
+
+// Compact advertisement record, fixed size so it can travel through a ring
+struct AdvertisementEvent {
+  // Flags
+  static constexpr uint8_t kDeviceFound = 0x01;      // InterfacesAdded: BlueZ has just created the device
+  static constexpr uint8_t kRssi = 0x02;             // rssi is valid
+  static constexpr uint8_t kAdvertisingData = 0x04;  // ManufacturerData or ServiceData changed
+
+  uint64_t mac;           // 48-bit MAC, first octet most significant
+  int64_t timestamp_ns;   // steady_clock time at signal dispatch
+  int16_t rssi;
+  uint8_t flags;
+};
+
+using AdvertisementRing = SpscRing<AdvertisementEvent>;
+
+// Runs on the session's internal thread for every event; must not block or throw
+using AdvertisementCallback = std::function<void(const AdvertisementEvent&)>;
+
+// Keeps an advertisement stream subscribed; destroying it unsubscribes. Must
+// be destroyed before its session.
+class AdvertisementSubscription {
+ public:
+  class Impl;
+
+  AdvertisementSubscription();
+  explicit AdvertisementSubscription(std::unique_ptr<Impl> impl);
+  AdvertisementSubscription(AdvertisementSubscription&& other) noexcept;
+  AdvertisementSubscription& operator=(AdvertisementSubscription&& other) noexcept;
+  ~AdvertisementSubscription();
+
+  // False when subscribing failed, e.g. without a bus connection
+  explicit operator bool() const { return impl_ != nullptr; }
+
+ private:
+  std::unique_ptr<Impl> impl_;
+};
+
+// Adapter1 discovery (scanning) on one adapter, the session's default unless
+// another is named
+//
+// BlueZ keeps scanning while at least one bus client asked for it, and every
+// user of one Session is the same client, so the session counts the active
+// Discovery objects and ScanAndPair calls per adapter: scanning starts with
+// the first and stops when the last is done. The destructor calls Stop.
+//
+// BlueZ also keeps a single discovery filter per client, so the session
+// shares that too. Active objects with a filter on one adapter must agree on
+// it; one scanning unfiltered, like ScanAndPair, lifts it for all while it
+// scans, as BlueZ does across clients. The filter is cleared when the last
+// object with it stops, so no later scan inherits it.
+class Discovery {
+ public:
+  explicit Discovery(Session& session = Session::Default(), const std::string& adapter = "");
+  ~Discovery();
+
+  Discovery(const Discovery&) = delete;
+  Discovery& operator=(const Discovery&) = delete;
+
+  // Kept here and sent by every Start; while active it applies at once and
+  // fails when another active object of the session filters differently
+  Result SetFilter(const DiscoveryFilter& filter);
+  Result ClearFilter();
+
+  // Starts discovery; succeeds without effect while already active. Fails when
+  // another active object of the session filters the adapter differently.
+  Result Start();
+
+  // Ends this object's share of the scan; the adapter stops once no other user of the session scans
+  Result Stop();
+
+  bool active() const;
+
+  // Streams InterfacesAdded and Device1 RSSI/advertising data changes of
+  // every adapter while the subscription lives, whether or not this object is
+  // scanning. The ring variant pushes from the session's internal thread, its
+  // single producer, and drops records while the ring is full; the
+  // application drains it with PopBatch.
+  AdvertisementSubscription Subscribe(AdvertisementCallback callback);
+  AdvertisementSubscription Subscribe(AdvertisementRing& ring);
+
+ private:
+  Session& session_;
+  const std::string adapter_path_;
+  mutable std::mutex mutex_;  // guards active_ and filter_
+  bool active_{false};
+  std::optional<DiscoveryFilter> filter_;
+};
+
+// Pairs a device that BlueZ may not have seen yet. Scans only when the device
+// object does not exist, ends its share of the scan as soon as its
+// InterfacesAdded signal arrives and pairs right away, so the wait is one
+// advertising interval rather than a fixed scan window. The deadline covers
+// scanning and pairing; missing it while scanning yields DeviceNotFound. Must
+// not be called from a completion callback. Scans and pairs on the adapter the
+// address names.
+Result ScanAndPair(const DeviceAddress& device, std::chrono::steady_clock::time_point deadline);
+
+Result ScanAndPair(Session& session, const DeviceAddress& device, std::chrono::steady_clock::time_point deadline);
+
+}  // namespace ble
@@ -0,0 +1,49 @@
+// MIT License
+// Copyright (c) 2025 pezy
+
+#pragma once
+
+#include <bluetooth/device_discovery.hpp>
+#include <chrono>
+#include <string>
+#include <vector>
+
+namespace ble {
+
+// Retries of Connect and Pair on transient BlueZ errors, set per session in
+// SessionOptions::retry
+//
+// The wait before retry n (n = 1 for the first retry) is drawn uniformly from
+// [b/2, b] with b = min(initial_backoff * multiplier^(n-1), max_backoff). The
+// random half keeps devices that failed together, e.g. after an adapter reset,
+// from retrying in lockstep. No retry starts, and no attempt runs, past the
+// deadline counted from the first attempt.
+struct RetryPolicy {
+  // Attempts including the first; 1 disables retries
+  int max_attempts{1};
+  std::chrono::milliseconds initial_backoff{250};
+  std::chrono::milliseconds max_backoff{4000};
+  double multiplier{2.0};
+  std::chrono::milliseconds deadline{60000};
+  // Whether ConnectionTimeout and PairingTimeout are retried
+  bool retry_timeouts{true};
+  // A failure is retryable when its error message contains one of these: the
+  // BlueZ error name or, for org.bluez.Error.Failed, the reason it carries
+  std::vector<std::string> retryable_errors{
+      "le-connection-abort-by-local",      // LE connection attempt aborted, typically a busy controller
+      "br-connection-page-timeout",        // BR/EDR device did not answer the page
+      "le-connection-create-socket",       // transient socket setup failure
+      "Page Timeout",                      // Pair on BR/EDR, older bluetoothd
+      "Software caused connection abort",  // link dropped while the operation ran
+      "org.bluez.Error.InProgress",        // another operation on the device has not finished
+      "org.bluez.Error.NotReady",          // adapter resetting or powering up
+  };
+};
+
+// Whether the failed result is worth another attempt under policy
+bool IsRetryable(const RetryPolicy& policy, const Result& result);
+
+// Jittered wait before retry number retry (1 for the first retry)
+std::chrono::milliseconds RetryBackoff(const RetryPolicy& policy, int retry);
+
+}  // namespace ble
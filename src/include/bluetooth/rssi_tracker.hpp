@@ -0,0 +1,87 @@
+// MIT License
+// Copyright (c) 2025 pezy
+
+#pragma once
+
+#include <bluetooth/discovery.hpp>
+#include <cstddef>
+#include <cstdint>
+#include <memory>
+#include <optional>
+#include <span>
+#include <string>
+
+namespace ble {
+
+// Samples kept per device; older ones are overwritten
+inline constexpr size_t kRssiHistoryLength = 16;
+
+struct RssiSample {
+  int64_t timestamp_ns;  // steady_clock, microsecond resolution
+  int16_t rssi;
+};
+
+// Running statistics of one device, all updated in O(1) per sample
+struct RssiStats {
+  uint64_t mac;                // 48-bit MAC, first octet most significant
+  uint64_t samples;            // total samples seen, not only those still in the history
+  int64_t last_timestamp_ns;
+  int16_t last;
+  int16_t min;
+  int16_t max;
+  float ema;                   // exponential moving average, dBm
+  float estimate;              // Kalman-filtered RSSI, dBm
+  float estimate_variance;     // uncertainty of estimate, dBm^2
+  float trend;                 // smoothed slope of estimate, dB per second; positive means approaching
+};
+
+struct RssiTrackerOptions {
+  // Devices tracked at once; samples of further devices are counted in untracked()
+  size_t max_devices{4096};
+  // EMA weight of the newest sample
+  float ema_alpha{0.2f};
+  // Kalman model: how fast the true RSSI may wander (dBm^2 per second) and how
+  // noisy a single reading is (dBm^2)
+  float process_noise{4.0f};
+  float measurement_noise{16.0f};
+};
+
+// Per-device RSSI history and statistics fed from the advertisement stream
+//
+// Update must always be called from the same single thread, e.g. straight from
+// a Discovery::Subscribe callback or from the thread draining an
+// AdvertisementRing. Any number of threads may query concurrently; readers
+// never block the writer and retry only when they race an update of the same
+// device. All memory is allocated at construction: about 270 bytes per device
+// slot, so the default 4096 devices take a little over 1 MB.
+class RssiTracker {
+ public:
+  class Impl;
+
+  explicit RssiTracker(const RssiTrackerOptions& options = RssiTrackerOptions());
+  ~RssiTracker();
+
+  RssiTracker(const RssiTracker&) = delete;
+  RssiTracker& operator=(const RssiTracker&) = delete;
+
+  // Writer side; events without an RSSI are ignored
+  void Update(const AdvertisementEvent& event);
+  void Update(std::span<const AdvertisementEvent> events);
+
+  // Reader side; nullopt for devices without samples
+  std::optional<RssiStats> Stats(uint64_t mac) const;
+  std::optional<RssiStats> Stats(const std::string& mac_address) const;
+
+  // Copies up to out.size() of the newest samples into out, oldest first, and returns how many
+  size_t History(uint64_t mac, std::span<RssiSample> out) const;
+
+  size_t size() const;
+
+  // Samples dropped because max_devices was reached
+  uint64_t untracked() const;
+
+ private:
+  std::unique_ptr<Impl> impl_;
+};
+
+}  // namespace ble
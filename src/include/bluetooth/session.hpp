@@ -0,0 +1,103 @@
+// MIT License
+// Copyright (c) 2025 pezy
+
+#pragma once
+
+#include <bluetooth/device_discovery.hpp>
+#include <bluetooth/retry.hpp>
+#include <cstddef>
+#include <memory>
+#include <string>
+
+namespace ble {
+
+// How Connect/Disconnect/Pair reach org.bluez.Device1
+enum class CallMode {
+  // Raw method call on the device object path: one round trip per operation
+  Direct = 0,
+  // Through a cached GDBusProxy: the first call per device also pays a GetAll
+  Proxy = 1
+};
+
+struct SessionOptions {
+  CallMode call_mode{CallMode::Direct};
+  // Number of org.bluez.Device1 proxies kept alive between calls in Proxy mode, 0 disables the cache
+  size_t device_proxy_cache_size{64};
+  // Adapter used for a DeviceAddress without one, and by Discovery unless given another
+  std::string default_adapter{"hci0"};
+  // Applied to ConnectDevice and PairDevice, blocking and asynchronous; disabled by default
+  RetryPolicy retry{};
+};
+
+// Long-lived BlueZ session
+//
+// Owns one system bus connection and the ObjectManager proxy for its whole
+// lifetime, so repeated operations skip bus setup. The connection is opened
+// lazily on first use and re-opened if the bus drops it. It is private to the
+// session rather than the process-wide one g_bus_get returns, so its settings
+// and closing it concern no other GIO user. All methods are thread-safe.
+//
+// One internal thread runs a private GMainContext. It completes the
+// asynchronous operations and dispatches the ObjectManager InterfacesRemoved
+// signal and the bluetoothd name owner change, which evict cached proxies
+// (CallMode::Proxy) for objects that no longer exist.
+//
+// While a DeviceCache is attached (see device_cache.hpp), GetPairedDevices is
+// answered from memory.
+class Session {
+ public:
+  class Impl;
+
+  explicit Session(const SessionOptions& options = SessionOptions());
+  ~Session();
+
+  Session(const Session&) = delete;
+  Session& operator=(const Session&) = delete;
+
+  // Process-wide session backing the free functions in device_discovery.hpp
+  static Session& Default();
+
+  // Paired devices of every adapter; BluetoothDevice::adapter tells them apart
+  DeviceQueryResult GetPairedDevices();
+
+  // Every org.bluez.Adapter1 from a single GetManagedObjects call
+  AdapterQueryResult GetAdapters();
+
+  bool IsDevicePaired(const DeviceAddress& device);
+
+  Result PairDevice(const DeviceAddress& device, int timeout_seconds = 30);
+
+  Result ConnectDevice(const DeviceAddress& device, int timeout_seconds = 30);
+
+  Result DisconnectDevice(const DeviceAddress& device, int timeout_seconds = 10);
+
+  Result TrustDevice(const DeviceAddress& device, bool trusted = true);
+
+  // Asynchronous variants, always issued as direct calls. Operations still in
+  // flight when the session is destroyed complete with an error first.
+  std::future<DeviceQueryResult> GetPairedDevicesAsync();
+  void GetPairedDevicesAsync(DeviceQueryCallback callback);
+
+  std::future<Result> PairDeviceAsync(const DeviceAddress& device, int timeout_seconds = 30);
+  void PairDeviceAsync(const DeviceAddress& device, ResultCallback callback, int timeout_seconds = 30);
+
+  std::future<Result> ConnectDeviceAsync(const DeviceAddress& device, int timeout_seconds = 30);
+  void ConnectDeviceAsync(const DeviceAddress& device, ResultCallback callback, int timeout_seconds = 30);
+
+  std::future<Result> DisconnectDeviceAsync(const DeviceAddress& device, int timeout_seconds = 10);
+  void DisconnectDeviceAsync(const DeviceAddress& device, ResultCallback callback, int timeout_seconds = 10);
+
+  std::future<Result> TrustDeviceAsync(const DeviceAddress& device);
+  void TrustDeviceAsync(const DeviceAddress& device, ResultCallback callback);
+
+  // Runs fn on the session's internal thread, where completion callbacks run
+  void Post(std::function<void()> fn);
+
+  // For libble internals only; Impl is not part of the installed headers
+  Impl& impl() { return *impl_; }
+
+ private:
+  std::unique_ptr<Impl> impl_;
+};
+
+}  // namespace ble
@@ -0,0 +1,86 @@
+// MIT License
+// Copyright (c) 2025 pezy
+
+#pragma once
+
+#include <algorithm>
+#include <atomic>
+#include <bit>
+#include <cstddef>
+#include <cstdint>
+#include <memory>
+#include <span>
+#include <type_traits>
+
+namespace ble {
+
+// Bounded lock-free single-producer single-consumer ring
+//
+// Storage is allocated once at construction; pushing and popping never
+// allocate or lock. TryPush never blocks either: when the ring is full the
+// value is dropped and counted, so a slow consumer cannot stall the producer.
+// Exactly one thread may push and one thread may pop at a time.
+template <typename T>
+class SpscRing {
+  static_assert(std::is_trivially_copyable_v<T>, "SpscRing holds trivially copyable records");
+
+ public:
+  // Capacity is rounded up to a power of two
+  explicit SpscRing(size_t capacity)
+      : capacity_(std::bit_ceil(std::max<size_t>(capacity, 2))),
+        mask_(capacity_ - 1),
+        slots_(std::make_unique<T[]>(capacity_)) {}
+
+  SpscRing(const SpscRing&) = delete;
+  SpscRing& operator=(const SpscRing&) = delete;
+
+  // Producer side
+  bool TryPush(const T& value) noexcept {
+    const size_t head = head_.load(std::memory_order_relaxed);
+    if (head - cached_tail_ == capacity_) {
+      cached_tail_ = tail_.load(std::memory_order_acquire);
+      if (head - cached_tail_ == capacity_) {
+        dropped_.fetch_add(1, std::memory_order_relaxed);
+        return false;
+      }
+    }
+    slots_[head & mask_] = value;
+    head_.store(head + 1, std::memory_order_release);
+    return true;
+  }
+
+  // Consumer side: moves up to out.size() records into out, returns how many
+  size_t PopBatch(std::span<T> out) noexcept {
+    const size_t tail = tail_.load(std::memory_order_relaxed);
+    if (cached_head_ == tail) {
+      cached_head_ = head_.load(std::memory_order_acquire);
+    }
+    const size_t count = std::min(out.size(), cached_head_ - tail);
+    for (size_t i = 0; i < count; ++i) {
+      out[i] = slots_[(tail + i) & mask_];
+    }
+    tail_.store(tail + count, std::memory_order_release);
+    return count;
+  }
+
+  size_t capacity() const noexcept { return capacity_; }
+
+  // Records TryPush had to drop because the ring was full
+  uint64_t dropped() const noexcept { return dropped_.load(std::memory_order_relaxed); }
+
+ private:
+  static constexpr size_t kCacheLineSize = 64;
+
+  const size_t capacity_;
+  const size_t mask_;
+  const std::unique_ptr<T[]> slots_;
+
+  // Producer and consumer indices live on separate cache lines, each next to its private copy of the other
+  alignas(kCacheLineSize) std::atomic<size_t> head_{0};
+  size_t cached_tail_{0};
+  alignas(kCacheLineSize) std::atomic<size_t> tail_{0};
+  size_t cached_head_{0};
+  alignas(kCacheLineSize) std::atomic<uint64_t> dropped_{0};
+};
+
+}  // namespace ble
@@ -0,0 +1,278 @@
+// MIT License
+// Copyright (c) 2025 pezy
+
+#include <bluetooth/batch.hpp>
+
+// std
+#include <algorithm>
+#include <condition_variable>
+#include <functional>
+#include <memory>
+#include <mutex>
+
+#include "session_impl.hpp"
+
+namespace ble {
+
+using internal::GObjectWrapper;
+using internal::MakeErrorResult;
+using internal::ScopedTimer;
+
+namespace {
+
+using StartFunction = std::function<void(const DeviceAddress& device, ResultCallback callback)>;
+
+// Shared by the completion callbacks of one batch
+struct BatchState {
+  std::span<const DeviceAddress> devices;
+  StartFunction start;
+  std::vector<Result> results;
+
+  std::mutex mutex;
+  std::condition_variable finished;
+  size_t next{0};
+  size_t completed{0};
+};
+
+// Starts the next pending call; each completion starts another, keeping the in-flight count constant
+void StartNext(const std::shared_ptr<BatchState>& state) {
+  size_t index;
+  {
+    std::lock_guard<std::mutex> lock(state->mutex);
+    if (state->next == state->devices.size()) {
+      return;
+    }
+    index = state->next++;
+  }
+
+  state->start(state->devices[index], [state, index](const Result& result) {
+    {
+      std::lock_guard<std::mutex> lock(state->mutex);
+      state->results[index] = result;
+      if (++state->completed == state->devices.size()) {
+        state->finished.notify_all();
+      }
+    }
+    StartNext(state);
+  });
+}
+
+std::vector<Result> RunBatch(std::span<const DeviceAddress> devices, size_t max_in_flight, StartFunction start) {
+  auto state = std::make_shared<BatchState>();
+  state->devices = devices;
+  state->start = std::move(start);
+  state->results.resize(devices.size());
+
+  const size_t initial = max_in_flight == 0 ? devices.size() : std::min(max_in_flight, devices.size());
+  for (size_t i = 0; i < initial; ++i) {
+    StartNext(state);
+  }
+
+  std::unique_lock<std::mutex> lock(state->mutex);
+  state->finished.wait(lock, [&state]() { return state->completed == state->devices.size(); });
+  return std::move(state->results);
+}
+
+// A Device1 object that reported Connected in a GetManagedObjects reply
+struct ConnectedDevice {
+  std::string mac_address;  // as reported by BlueZ, upper case
+  std::string device_path;
+  std::string adapter;
+};
+
+// Lists every connected device from a single GetManagedObjects call
+bool ListConnectedDevices(Session& session, std::vector<ConnectedDevice>* devices, DeviceQueryResult* error_result) {
+  GVariant* objects_result = session.impl().GetManagedObjects(error_result);
+  if (!objects_result) {
+    return false;
+  }
+
+  // RAII wrapper for objects result
+  auto objects_result_wrapper = GObjectWrapper::make_variant(objects_result);
+
+  internal::ForEachDevice(objects_result_wrapper.get(), [devices](const char* object_path, GVariant* properties) {
+    if (!internal::ExtractConnected(properties)) {
+      return;
+    }
+    std::string mac_address = internal::ExtractMacAddress(properties);
+    if (mac_address.empty()) {
+      return;
+    }
+    devices->push_back(
+        {internal::NormalizeMacAddress(mac_address), object_path, internal::AdapterFromObjectPath(object_path)});
+  });
+  return true;
+}
+
+// Writes every Disconnect to the socket without waiting for replies, then flushes once
+std::vector<Result> SendDisconnectsNoReply(Session& session, const std::vector<ConnectedDevice>& devices) {
+  const auto& method = internal::kDisconnectMethod;
+  std::vector<Result> results(devices.size());
+  const auto start = std::chrono::steady_clock::now();
+
+  GError* error = nullptr;
+  GDBusConnection* connection = session.impl().AcquireConnection(&error);
+  if (!connection) {
+    const Result failed =
+        MakeErrorResult(ErrorCode::DBusConnectionFailed, error ? error->message : "Failed to connect to D-Bus");
+    if (error) g_error_free(error);
+    std::fill(results.begin(), results.end(), failed);
+    return results;
+  }
+
+  // RAII wrapper for connection
+  auto connection_wrapper = GObjectWrapper::make_dbus_connection(connection);
+
+  for (size_t i = 0; i < devices.size(); ++i) {
+    GDBusMessage* message =
+        g_dbus_message_new_method_call("org.bluez", devices[i].device_path.c_str(), method.interface_name, method.name);
+    g_dbus_message_set_flags(message, G_DBUS_MESSAGE_FLAGS_NO_REPLY_EXPECTED);
+    if (g_dbus_connection_send_message(connection, message, G_DBUS_SEND_MESSAGE_FLAGS_NONE, nullptr, &error)) {
+      results[i].success = true;
+    } else {
+      results[i] = MakeErrorResult(method.failure_code, error->message);
+      g_clear_error(&error);
+    }
+    g_object_unref(message);
+  }
+
+  // Messages are only queued above; make sure they reached the bus before returning
+  if (!g_dbus_connection_flush_sync(connection, nullptr, &error)) {
+    for (auto& result : results) {
+      if (result.success) {
+        result = MakeErrorResult(method.failure_code, error->message);
+      }
+    }
+    g_error_free(error);
+  }
+
+  const auto elapsed = std::chrono::duration_cast<std::chrono::milliseconds>(std::chrono::steady_clock::now() - start);
+  for (auto& result : results) {
+    result.operation_time = elapsed;
+  }
+  return results;
+}
+
+std::vector<Result> DisconnectConnected(Session& session, const std::vector<ConnectedDevice>& devices,
+                                        const DisconnectOptions& options) {
+  if (options.no_reply) {
+    return SendDisconnectsNoReply(session, devices);
+  }
+
+  std::vector<DeviceAddress> addresses;
+  addresses.reserve(devices.size());
+  for (const auto& device : devices) {
+    addresses.emplace_back(device.mac_address, device.adapter);
+  }
+  return RunBatch(addresses, options.max_in_flight,
+                  [&session, timeout = options.timeout_seconds](const DeviceAddress& device, ResultCallback callback) {
+                    session.DisconnectDeviceAsync(device, std::move(callback), timeout);
+                  });
+}
+
+std::vector<DeviceAddress> ToDeviceAddresses(std::span<const std::string> mac_addresses) {
+  return std::vector<DeviceAddress>(mac_addresses.begin(), mac_addresses.end());
+}
+
+}  // anonymous namespace
+
+std::vector<Result> ConnectDevices(std::span<const std::string> mac_addresses, const BatchOptions& options) {
+  return ConnectDevices(Session::Default(), mac_addresses, options);
+}
+
+std::vector<Result> ConnectDevices(Session& session, std::span<const std::string> mac_addresses,
+                                   const BatchOptions& options) {
+  return ConnectDevices(session, std::span<const DeviceAddress>(ToDeviceAddresses(mac_addresses)), options);
+}
+
+std::vector<Result> ConnectDevices(std::span<const DeviceAddress> devices, const BatchOptions& options) {
+  return ConnectDevices(Session::Default(), devices, options);
+}
+
+std::vector<Result> ConnectDevices(Session& session, std::span<const DeviceAddress> devices,
+                                   const BatchOptions& options) {
+  return RunBatch(devices, options.max_in_flight,
+                  [&session, timeout = options.timeout_seconds](const DeviceAddress& device, ResultCallback callback) {
+                    session.ConnectDeviceAsync(device, std::move(callback), timeout);
+                  });
+}
+
+std::vector<Result> DisconnectDevices(std::span<const std::string> mac_addresses, const DisconnectOptions& options) {
+  return DisconnectDevices(Session::Default(), mac_addresses, options);
+}
+
+std::vector<Result> DisconnectDevices(Session& session, std::span<const std::string> mac_addresses,
+                                      const DisconnectOptions& options) {
+  return DisconnectDevices(session, std::span<const DeviceAddress>(ToDeviceAddresses(mac_addresses)), options);
+}
+
+std::vector<Result> DisconnectDevices(std::span<const DeviceAddress> devices, const DisconnectOptions& options) {
+  return DisconnectDevices(Session::Default(), devices, options);
+}
+
+std::vector<Result> DisconnectDevices(Session& session, std::span<const DeviceAddress> devices,
+                                      const DisconnectOptions& options) {
+  std::vector<Result> results(devices.size());
+
+  std::vector<ConnectedDevice> connected;
+  DeviceQueryResult query;
+  if (!ListConnectedDevices(session, &connected, &query)) {
+    std::fill(results.begin(), results.end(),
+              MakeErrorResult(static_cast<ErrorCode>(query.error_code), query.error_message));
+    return results;
+  }
+
+  // Only connected devices cost a call, the others are already where the caller wants them
+  std::vector<ConnectedDevice> targets;
+  std::vector<size_t> target_indices;
+  for (size_t i = 0; i < devices.size(); ++i) {
+    if (const char* invalid = session.impl().CheckDeviceAddress(devices[i])) {
+      results[i] = MakeErrorResult(ErrorCode::DeviceNotFound, invalid);
+      continue;
+    }
+    const std::string mac_address = internal::NormalizeMacAddress(devices[i].mac_address);
+    const std::string& adapter = session.impl().ResolveAdapter(devices[i]);
+    auto it = std::find_if(connected.begin(), connected.end(), [&](const ConnectedDevice& device) {
+      return device.mac_address == mac_address && device.adapter == adapter;
+    });
+    if (it == connected.end()) {
+      results[i].success = true;
+      continue;
+    }
+    targets.push_back(*it);
+    target_indices.push_back(i);
+  }
+
+  std::vector<Result> target_results = DisconnectConnected(session, targets, options);
+  for (size_t i = 0; i < target_indices.size(); ++i) {
+    results[target_indices[i]] = std::move(target_results[i]);
+  }
+  return results;
+}
+
+DisconnectAllResult DisconnectAll(const DisconnectOptions& options) {
+  return DisconnectAll(Session::Default(), options);
+}
+
+DisconnectAllResult DisconnectAll(Session& session, const DisconnectOptions& options) {
+  DisconnectAllResult result;
+  ScopedTimer timer(result.operation_time);
+
+  std::vector<ConnectedDevice> connected;
+  DeviceQueryResult query;
+  if (!ListConnectedDevices(session, &connected, &query)) {
+    result.error_code = query.error_code;
+    result.error_message = query.error_message;
+    return result;
+  }
+
+  std::vector<Result> device_results = DisconnectConnected(session, connected, options);
+  result.devices.reserve(connected.size());
+  for (size_t i = 0; i < connected.size(); ++i) {
+    result.devices.push_back({connected[i].mac_address, std::move(device_results[i]), connected[i].adapter});
+  }
+  result.success = true;
+  return result;
+}
+
+}  // namespace ble
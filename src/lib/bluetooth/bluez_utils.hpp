@@ -0,0 +1,383 @@
+// MIT License
+// Copyright (c) 2025 pezy
+
+#pragma once
+
+#include <bluetooth/device_discovery.hpp>
+
+// std
+#include <algorithm>
+#include <cctype>
+#include <chrono>
+#include <cstddef>
+#include <cstring>
+#include <functional>
+#include <memory>
+#include <optional>
+#include <string>
+#include <utility>
+#include <vector>
+
+// sys
+#include <gio/gio.h>
+#include <glib.h>
+
+// Internal helpers shared by the libble translation units. Not installed.
+namespace ble::internal {
+
+// RAII wrappers for GLib objects
+class GObjectWrapper {
+ public:
+  // GDBusConnection wrapper
+  using DBusConnection = std::unique_ptr<GDBusConnection, std::function<void(GDBusConnection*)>>;
+  static DBusConnection make_dbus_connection(GDBusConnection* conn) {
+    return DBusConnection(conn, [](GDBusConnection* c) {
+      if (c) g_object_unref(c);
+    });
+  }
+
+  // GDBusProxy wrapper
+  using DBusProxy = std::unique_ptr<GDBusProxy, std::function<void(GDBusProxy*)>>;
+  static DBusProxy make_dbus_proxy(GDBusProxy* proxy) {
+    return DBusProxy(proxy, [](GDBusProxy* p) {
+      if (p) g_object_unref(p);
+    });
+  }
+
+  // GVariant wrapper
+  using Variant = std::unique_ptr<GVariant, std::function<void(GVariant*)>>;
+  static Variant make_variant(GVariant* variant) {
+    return Variant(variant, [](GVariant* v) {
+      if (v) g_variant_unref(v);
+    });
+  }
+
+  // GVariantIter wrapper
+  using VariantIter = std::unique_ptr<GVariantIter, std::function<void(GVariantIter*)>>;
+  static VariantIter make_variant_iter(GVariantIter* iter) {
+    return VariantIter(iter, [](GVariantIter* i) {
+      if (i) g_variant_iter_free(i);
+    });
+  }
+
+  // GError wrapper
+  using Error = std::unique_ptr<GError, std::function<void(GError*)>>;
+  static Error make_error(GError* error) {
+    return Error(error, [](GError* e) {
+      if (e) g_error_free(e);
+    });
+  }
+};
+
+// Helper function to convert GVariant to MAC address string
+inline std::string ExtractMacAddress(GVariant* device_dict) {
+  auto address_variant =
+      GObjectWrapper::make_variant(g_variant_lookup_value(device_dict, "Address", G_VARIANT_TYPE_STRING));
+  if (!address_variant) {
+    return "";
+  }
+
+  const char* address = g_variant_get_string(address_variant.get(), nullptr);
+  return std::string(address ? address : "");
+}
+
+// Helper function to extract device name
+inline std::optional<std::string> ExtractDeviceName(GVariant* device_dict) {
+  auto name_variant = GObjectWrapper::make_variant(g_variant_lookup_value(device_dict, "Name", G_VARIANT_TYPE_STRING));
+  if (!name_variant) {
+    return std::nullopt;
+  }
+
+  const char* name = g_variant_get_string(name_variant.get(), nullptr);
+  return std::string(name ? name : "");
+}
+
+// Helper function to extract device class
+inline std::optional<uint32_t> ExtractDeviceClass(GVariant* device_dict) {
+  auto class_variant =
+      GObjectWrapper::make_variant(g_variant_lookup_value(device_dict, "Class", G_VARIANT_TYPE_UINT32));
+  if (!class_variant) {
+    return std::nullopt;
+  }
+
+  return g_variant_get_uint32(class_variant.get());
+}
+
+// Helper function to extract RSSI
+inline std::optional<int16_t> ExtractRssi(GVariant* device_dict) {
+  auto rssi_variant = GObjectWrapper::make_variant(g_variant_lookup_value(device_dict, "RSSI", G_VARIANT_TYPE_INT16));
+  if (!rssi_variant) {
+    return std::nullopt;
+  }
+
+  return g_variant_get_int16(rssi_variant.get());
+}
+
+// Helper function to check if device is connected
+inline bool ExtractConnected(GVariant* device_dict) {
+  auto connected_variant =
+      GObjectWrapper::make_variant(g_variant_lookup_value(device_dict, "Connected", G_VARIANT_TYPE_BOOLEAN));
+  if (!connected_variant) {
+    return false;
+  }
+
+  return static_cast<bool>(g_variant_get_boolean(connected_variant.get()));
+}
+
+inline bool ExtractPaired(GVariant* device_dict) {
+  auto paired_variant =
+      GObjectWrapper::make_variant(g_variant_lookup_value(device_dict, "Paired", G_VARIANT_TYPE_BOOLEAN));
+  if (!paired_variant) {
+    return false;
+  }
+
+  return static_cast<bool>(g_variant_get_boolean(paired_variant.get()));
+}
+
+// Calls fn(object_path, properties) for every object of a GetManagedObjects
+// reply, (a{oa{sa{sv}}}), that implements interface
+template <typename Fn>
+void ForEachInterface(GVariant* objects_result, const char* interface, Fn&& fn) {
+  GVariantIter* objects_iter;
+  g_variant_get(objects_result, "(a{oa{sa{sv}}})", &objects_iter);
+
+  // RAII wrapper for objects iterator
+  auto objects_iter_wrapper = GObjectWrapper::make_variant_iter(objects_iter);
+
+  const char* object_path;
+  GVariant* interfaces_variant;  // automatically unreferenced by g_variant_iter_loop
+
+  while (g_variant_iter_loop(objects_iter_wrapper.get(), "{&o@a{sa{sv}}}", &object_path, &interfaces_variant)) {
+    GVariantIter interfaces_iter;
+    g_variant_iter_init(&interfaces_iter, interfaces_variant);
+
+    const char* interface_name;
+    GVariant* properties_variant;  // automatically unreferenced by g_variant_iter_loop
+
+    while (g_variant_iter_loop(&interfaces_iter, "{&s@a{sv}}", &interface_name, &properties_variant)) {
+      if (g_strcmp0(interface_name, interface) == 0) {
+        fn(object_path, properties_variant);
+      }
+    }
+  }
+}
+
+// Calls fn(object_path, properties) for every org.bluez.Device1 object
+template <typename Fn>
+void ForEachDevice(GVariant* objects_result, Fn&& fn) {
+  ForEachInterface(objects_result, "org.bluez.Device1", std::forward<Fn>(fn));
+}
+
+inline constexpr char kBluezPathPrefix[] = "/org/bluez/";
+
+// Adapter name of an adapter or device object path, "/org/bluez/hci1/dev_..." gives "hci1"
+inline std::string AdapterFromObjectPath(const char* object_path) {
+  const size_t prefix_length = sizeof(kBluezPathPrefix) - 1;
+  if (std::strncmp(object_path, kBluezPathPrefix, prefix_length) != 0) {
+    return std::string();
+  }
+  const char* name = object_path + prefix_length;
+  const char* end = std::strchr(name, '/');
+  return end ? std::string(name, end) : std::string(name);
+}
+
+// Object path order, by adapter and then address, so a listing reads the same from the bus and from a DeviceCache
+inline void SortByObjectPath(std::vector<BluetoothDevice>::iterator first,
+                             std::vector<BluetoothDevice>::iterator last) {
+  std::sort(first, last, [](const BluetoothDevice& a, const BluetoothDevice& b) {
+    return a.adapter != b.adapter ? a.adapter < b.adapter : a.mac_address < b.mac_address;
+  });
+}
+
+// Parses a GetManagedObjects reply and appends every paired device, in object path order
+inline void AppendPairedDevices(GVariant* objects_result, std::vector<BluetoothDevice>* devices) {
+  const auto appended_from = static_cast<std::ptrdiff_t>(devices->size());
+  ForEachDevice(objects_result, [devices](const char* object_path, GVariant* properties_variant) {
+    bool is_paired = ExtractPaired(properties_variant);
+    if (!is_paired) {
+      return;
+    }
+
+    // Extract MAC address and create device entry
+    std::string mac_address = ExtractMacAddress(properties_variant);
+    if (mac_address.empty()) {
+      return;
+    }
+
+    BluetoothDevice device;
+    device.mac_address = mac_address;
+    device.device_name = ExtractDeviceName(properties_variant);
+    device.device_class = ExtractDeviceClass(properties_variant);
+    device.rssi = ExtractRssi(properties_variant);
+    device.connected = ExtractConnected(properties_variant);
+    device.adapter = AdapterFromObjectPath(object_path);
+    devices->push_back(device);
+  });
+  SortByObjectPath(devices->begin() + appended_from, devices->end());
+}
+
+// Parses a GetManagedObjects reply and appends every adapter, hci2 before hci10
+inline void AppendAdapters(GVariant* objects_result, std::vector<AdapterInfo>* adapters) {
+  ForEachInterface(objects_result, "org.bluez.Adapter1", [adapters](const char* object_path, GVariant* properties) {
+    AdapterInfo adapter;
+    adapter.name = AdapterFromObjectPath(object_path);
+    adapter.address = ExtractMacAddress(properties);
+    gboolean value = FALSE;
+    if (g_variant_lookup(properties, "Powered", "b", &value)) {
+      adapter.powered = value;
+    }
+    if (g_variant_lookup(properties, "Discovering", "b", &value)) {
+      adapter.discovering = value;
+    }
+    adapters->push_back(std::move(adapter));
+  });
+  std::sort(adapters->begin(), adapters->end(), [](const AdapterInfo& a, const AdapterInfo& b) {
+    return a.name.size() != b.name.size() ? a.name.size() < b.name.size() : a.name < b.name;
+  });
+}
+
+// Helper function to create error result
+inline DeviceQueryResult CreateErrorResult(ErrorCode error_code, const std::string& error_message) {
+  DeviceQueryResult result;
+  result.devices.clear();
+  result.success = false;
+  result.error_code = static_cast<int>(error_code);
+  result.error_message = error_message;
+  result.query_time = std::chrono::milliseconds(0);
+  return result;
+}
+
+// Helper function to create pair error result
+inline Result MakeErrorResult(ErrorCode error_code, const std::string& error_message) {
+  Result result;
+  result.success = false;
+  result.error_code = static_cast<int>(error_code);
+  result.error_message = error_message;
+  result.operation_time = std::chrono::milliseconds(0);
+  return result;
+}
+
+// Upper-cases a MAC address, the form BlueZ reports in Device1.Address
+inline std::string NormalizeMacAddress(const std::string& mac_address) {
+  std::string normalized = mac_address;
+  for (char& c : normalized) {
+    c = static_cast<char>(std::toupper(static_cast<unsigned char>(c)));
+  }
+  return normalized;
+}
+
+// Adapter names become an object path element, so only [A-Za-z0-9_] is allowed
+inline bool IsValidAdapterName(const std::string& adapter) {
+  if (adapter.empty()) {
+    return false;
+  }
+  for (char c : adapter) {
+    if (!std::isalnum(static_cast<unsigned char>(c)) && c != '_') {
+      return false;
+    }
+  }
+  return true;
+}
+
+inline std::string AdapterObjectPath(const std::string& adapter) { return kBluezPathPrefix + adapter; }
+
+// Helper function to convert MAC address to D-Bus object path below the adapter
+inline std::string DeviceObjectPath(const std::string& adapter, const std::string& mac_address) {
+  std::string path = AdapterObjectPath(adapter) + "/dev_";
+  for (char c : mac_address) {
+    if (c == ':') {
+      path += '_';
+    } else {
+      path += std::toupper(c);
+    }
+  }
+  return path;
+}
+
+inline bool IsValidMacAddress(const std::string& mac_address) {
+  if (mac_address.empty()) {
+    return false;
+  }
+
+  // MAC address format: XX:XX:XX:XX:XX:XX (6 octets, 5 colons)
+  if (mac_address.length() != 17) {
+    return false;
+  }
+
+  // Check for colons at correct positions
+  if (mac_address[2] != ':' || mac_address[5] != ':' || mac_address[8] != ':' || mac_address[11] != ':' ||
+      mac_address[14] != ':') {
+    return false;
+  }
+
+  // Check each octet is valid hexadecimal
+  for (int i = 0; i < 17; ++i) {
+    if (i == 2 || i == 5 || i == 8 || i == 11 || i == 14) {
+      continue;  // Skip colons
+    }
+    char c = mac_address[i];
+    if (!((c >= '0' && c <= '9') || (c >= 'A' && c <= 'F') || (c >= 'a' && c <= 'f'))) {
+      return false;
+    }
+  }
+
+  return true;
+}
+
+inline uint64_t HexDigitValue(char c) {
+  if (c >= '0' && c <= '9') return static_cast<uint64_t>(c - '0');
+  if (c >= 'a' && c <= 'f') return static_cast<uint64_t>(c - 'a' + 10);
+  return static_cast<uint64_t>(c - 'A' + 10);
+}
+
+// Packs 17 characters "XX?XX?XX?XX?XX?XX", whatever the separator; callers validate
+inline uint64_t PackMacOctets(const char* text) {
+  uint64_t packed = 0;
+  for (size_t i = 0; i < 17; i += 3) {
+    packed = (packed << 8) | (HexDigitValue(text[i]) << 4) | HexDigitValue(text[i + 1]);
+  }
+  return packed;
+}
+
+// Packs a MAC address into the low 48 bits of an integer, case-insensitively;
+// nullopt when the format is invalid
+inline std::optional<uint64_t> PackMacAddress(const std::string& mac_address) {
+  if (!IsValidMacAddress(mac_address)) {
+    return std::nullopt;
+  }
+  return PackMacOctets(mac_address.c_str());
+}
+
+// Packs the MAC encoded in a device object path, .../dev_AA_BB_CC_DD_EE_FF, without allocating
+inline std::optional<uint64_t> PackMacFromDevicePath(const char* object_path) {
+  const char* device = std::strrchr(object_path, '/');
+  if (!device || std::strncmp(device, "/dev_", 5) != 0 || std::strlen(device + 5) != 17) {
+    return std::nullopt;
+  }
+
+  const char* text = device + 5;
+  for (size_t i = 0; i < 17; ++i) {
+    const bool valid = i % 3 == 2 ? text[i] == '_' : std::isxdigit(static_cast<unsigned char>(text[i])) != 0;
+    if (!valid) {
+      return std::nullopt;
+    }
+  }
+  return PackMacOctets(text);
+}
+
+class ScopedTimer {
+ public:
+  explicit ScopedTimer(std::chrono::milliseconds& duration)
+      : start_time_(std::chrono::steady_clock::now()), duration_ref_(duration) {}
+
+  ~ScopedTimer() {
+    const auto end_time = std::chrono::steady_clock::now();
+    duration_ref_ = std::chrono::duration_cast<std::chrono::milliseconds>(end_time - start_time_);
+  }
+
+ private:
+  const std::chrono::steady_clock::time_point start_time_;
+  std::chrono::milliseconds& duration_ref_;
+};
+
+}  // namespace ble::internal
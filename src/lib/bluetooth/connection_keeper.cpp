@@ -0,0 +1,529 @@
+// MIT License
+// Copyright (c) 2025 pezy
+
+#include <bluetooth/connection_keeper.hpp>
+#include <bluetooth/retry.hpp>
+
+// std
+#include <algorithm>
+#include <condition_variable>
+#include <mutex>
+#include <thread>
+#include <unordered_map>
+#include <vector>
+
+#include "session_impl.hpp"
+
+namespace ble {
+
+using internal::GObjectWrapper;
+using internal::MakeErrorResult;
+using Clock = std::chrono::steady_clock;
+
+namespace {
+
+std::chrono::milliseconds MillisecondsSince(Clock::time_point start) {
+  return std::chrono::duration_cast<std::chrono::milliseconds>(Clock::now() - start);
+}
+
+// Only the backoff fields matter to RetryBackoff
+RetryPolicy BackoffPolicy(const KeeperOptions& options) {
+  RetryPolicy policy;
+  policy.initial_backoff = options.initial_backoff;
+  policy.max_backoff = options.max_backoff;
+  policy.multiplier = options.multiplier;
+  return policy;
+}
+
+}  // anonymous namespace
+
+class ConnectionKeeper::Impl {
+ public:
+  Impl(Session& session, const KeeperOptions& options)
+      : session_(session), options_(options), backoff_(BackoffPolicy(options)) {}
+
+  ~Impl() {
+    {
+      std::lock_guard<std::mutex> lock(mutex_);
+      stopping_ = true;
+    }
+    resubscribe_wanted_.notify_all();
+    if (resubscriber_.joinable()) {
+      resubscriber_.join();
+    }
+    {
+      std::lock_guard<std::mutex> lock(subscribe_mutex_);
+      if (connection_) {
+        session_.impl().RunOnLoop([this]() { Unsubscribe(); });
+      }
+    }
+
+    // Attempts in flight still call back; the timers are ours to remove
+    std::unique_lock<std::mutex> lock(mutex_);
+    idle_.wait(lock, [this]() { return outstanding_ == 0; });
+    auto entries = std::move(entries_);
+    lock.unlock();
+    session_.impl().RunOnLoop([&entries]() {
+      for (auto& [path, entry] : entries) {
+        DestroyTimer(entry.get());
+      }
+    });
+  }
+
+  Result Add(const DeviceAddress& device) {
+    Session::Impl& session = session_.impl();
+    if (const char* invalid = session.CheckDeviceAddress(device)) {
+      return MakeErrorResult(ErrorCode::DeviceNotFound, invalid);
+    }
+    if (Result subscribed = Subscribe(); subscribed.hasError()) {
+      return subscribed;
+    }
+
+    auto entry = std::make_shared<Entry>(
+        DeviceAddress(internal::NormalizeMacAddress(device.mac_address), session.ResolveAdapter(device)));
+    entry->path = session.DevicePath(entry->device);
+    entry->stats.mac_address = entry->device.mac_address;
+    entry->stats.adapter = entry->device.adapter;
+
+    Attempts attempts;
+    {
+      std::lock_guard<std::mutex> lock(mutex_);
+      if (entries_.emplace(entry->path, entry).second) {
+        // Connect answers at once for a device that already is, with AlreadyConnected for BR/EDR
+        StartAttemptLocked(entry, &attempts);
+      }
+    }
+    Start(attempts);
+    Result result;
+    result.success = true;
+    return result;
+  }
+
+  bool Remove(const DeviceAddress& device) {
+    std::shared_ptr<Entry> entry;
+    {
+      std::lock_guard<std::mutex> lock(mutex_);
+      auto it = entries_.find(session_.impl().DevicePath(device));
+      if (it == entries_.end()) {
+        return false;
+      }
+      entry = std::move(it->second);
+      entries_.erase(it);
+      entry->removed = true;
+    }
+    session_.impl().RunOnLoop([&entry]() { DestroyTimer(entry.get()); });
+    return true;
+  }
+
+  std::optional<KeptDeviceStats> Stats(const DeviceAddress& device) const {
+    std::lock_guard<std::mutex> lock(mutex_);
+    auto it = entries_.find(session_.impl().DevicePath(device));
+    if (it == entries_.end()) {
+      return std::nullopt;
+    }
+    return SnapshotLocked(*it->second);
+  }
+
+  std::vector<KeptDeviceStats> Stats() const {
+    std::lock_guard<std::mutex> lock(mutex_);
+    std::vector<KeptDeviceStats> stats;
+    stats.reserve(entries_.size());
+    for (const auto& [path, entry] : entries_) {
+      stats.push_back(SnapshotLocked(*entry));
+    }
+    std::sort(stats.begin(), stats.end(), [](const KeptDeviceStats& a, const KeptDeviceStats& b) {
+      return a.adapter != b.adapter ? a.adapter < b.adapter : a.mac_address < b.mac_address;
+    });
+    return stats;
+  }
+
+ private:
+  struct Entry {
+    explicit Entry(DeviceAddress address) : device(std::move(address)) {}
+
+    DeviceAddress device;
+    std::string path;
+    KeptDeviceStats stats;
+    Clock::time_point dropped_at{};
+    bool dropped{false};     // disconnected after a drop, as opposed to not connected yet
+    bool connecting{false};  // attempt in flight
+    bool removed{false};
+    int failures{0};  // consecutive failed attempts
+    GSource* timer{nullptr};  // pending backoff, loop thread only
+  };
+
+  // Attempts claimed under mutex_, issued by Start once it is released
+  using Attempts = std::vector<std::shared_ptr<Entry>>;
+
+  // Subscribes on first use, so a keeper that is never given a device never
+  // touches the bus. Subscribes again once the connection the signals came on
+  // has closed; what happened meanwhile is unknown, so kept devices that were
+  // connected count as dropped.
+  Result Subscribe() {
+    std::lock_guard<std::mutex> lock(subscribe_mutex_);
+    return SubscribeLocked();
+  }
+
+  Result SubscribeLocked() {
+    if (connection_ && !g_dbus_connection_is_closed(connection_.get())) {
+      return Result{true};
+    }
+    {
+      std::lock_guard<std::mutex> lock(mutex_);
+      if (stopping_) {
+        return Result{true};
+      }
+    }
+    const bool resubscribing = static_cast<bool>(connection_);
+    if (resubscribing) {
+      session_.impl().RunOnLoop([this]() { Unsubscribe(); });
+    }
+
+    GError* error = nullptr;
+    GDBusConnection* connection = session_.impl().AcquireConnection(&error);
+    if (!connection) {
+      Result result =
+          MakeErrorResult(ErrorCode::DBusConnectionFailed, error ? error->message : "Failed to connect to D-Bus");
+      if (error) g_error_free(error);
+      return result;
+    }
+    connection_ = GObjectWrapper::make_dbus_connection(connection);
+
+    // Subscribed from the loop thread so the signals are dispatched there; the
+    // session builds its connection there too, which is where closed is emitted
+    session_.impl().RunOnLoop([this]() {
+      GDBusConnection* bus = connection_.get();
+      subscription_ids_ = {
+          g_dbus_connection_signal_subscribe(bus, "org.bluez", "org.freedesktop.DBus.Properties", "PropertiesChanged",
+                                             nullptr, "org.bluez.Device1", G_DBUS_SIGNAL_FLAGS_NONE,
+                                             &Impl::OnPropertiesChanged, this, nullptr),
+          g_dbus_connection_signal_subscribe(bus, "org.bluez", "org.freedesktop.DBus.ObjectManager",
+                                             "InterfacesAdded", nullptr, nullptr, G_DBUS_SIGNAL_FLAGS_NONE,
+                                             &Impl::OnInterfacesAdded, this, nullptr),
+          g_dbus_connection_signal_subscribe(bus, "org.bluez", "org.freedesktop.DBus.ObjectManager",
+                                             "InterfacesRemoved", nullptr, nullptr, G_DBUS_SIGNAL_FLAGS_NONE,
+                                             &Impl::OnInterfacesRemoved, this, nullptr),
+          g_dbus_connection_signal_subscribe(bus, "org.freedesktop.DBus", "org.freedesktop.DBus", "NameOwnerChanged",
+                                             "/org/freedesktop/DBus", "org.bluez", G_DBUS_SIGNAL_FLAGS_NONE,
+                                             &Impl::OnNameOwnerChanged, this, nullptr)};
+      closed_handler_ = g_signal_connect(bus, "closed", G_CALLBACK(&Impl::OnClosed), this);
+      // Closed before the handler was connected: its emission may have been missed
+      if (g_dbus_connection_is_closed(bus)) {
+        RequestResubscribe();
+      }
+    });
+    if (!resubscriber_.joinable()) {
+      resubscriber_ = std::thread([this]() { Resubscribe(); });
+    }
+
+    if (resubscribing) {
+      Attempts attempts;
+      {
+        std::lock_guard<std::mutex> lock(mutex_);
+        for (auto& [path, entry] : entries_) {
+          MarkDroppedLocked(entry, &attempts);
+        }
+      }
+      Start(attempts);
+    }
+    return Result{true};
+  }
+
+  // Loop thread only
+  void Unsubscribe() {
+    for (const guint id : subscription_ids_) {
+      g_dbus_connection_signal_unsubscribe(connection_.get(), id);
+    }
+    subscription_ids_.clear();
+    if (closed_handler_) {
+      g_signal_handler_disconnect(connection_.get(), closed_handler_);
+      closed_handler_ = 0;
+    }
+  }
+
+  void RequestResubscribe() {
+    std::lock_guard<std::mutex> lock(mutex_);
+    resubscribe_ = true;
+    resubscribe_wanted_.notify_one();
+  }
+
+  // Body of resubscriber_: subscribing again blocks on the bus and waits on
+  // the loop thread, so it cannot happen in the closed handler. While the bus
+  // stays unreachable it is retried with the keeper's backoff.
+  void Resubscribe() {
+    std::unique_lock<std::mutex> lock(mutex_);
+    int failures = 0;
+    while (true) {
+      resubscribe_wanted_.wait(lock, [this]() { return stopping_ || resubscribe_; });
+      if (stopping_) {
+        return;
+      }
+      resubscribe_ = false;
+      lock.unlock();
+      const bool subscribed = !Subscribe().hasError();
+      lock.lock();
+      if (subscribed) {
+        failures = 0;
+        continue;
+      }
+      resubscribe_wanted_.wait_for(lock, RetryBackoff(backoff_, ++failures), [this]() { return stopping_; });
+      resubscribe_ = true;
+    }
+  }
+
+  // The connection is gone along with every subscription on it; the session only reopens it on the next call
+  static void OnClosed(GDBusConnection*, gboolean, GError*, gpointer user_data) {
+    static_cast<Impl*>(user_data)->RequestResubscribe();
+  }
+
+  static void OnPropertiesChanged(GDBusConnection*, const gchar*, const gchar* object_path, const gchar*,
+                                  const gchar*, GVariant* parameters, gpointer user_data) {
+    auto* impl = static_cast<Impl*>(user_data);
+    GVariant* changed = nullptr;
+    g_variant_get(parameters, "(&s@a{sv}@as)", nullptr, &changed, nullptr);
+    auto changed_wrapper = GObjectWrapper::make_variant(changed);
+
+    gboolean connected = FALSE;
+    if (!g_variant_lookup(changed, "Connected", "b", &connected)) {
+      return;
+    }
+
+    Attempts attempts;
+    {
+      std::lock_guard<std::mutex> lock(impl->mutex_);
+      auto it = impl->entries_.find(object_path);
+      if (it == impl->entries_.end()) {
+        return;
+      }
+      if (connected) {
+        impl->MarkConnectedLocked(it->second.get());
+      } else {
+        impl->MarkDroppedLocked(it->second, &attempts);
+      }
+    }
+    impl->Start(attempts);
+  }
+
+  // The device object is back, e.g. after a bluetoothd restart: try at once rather than at the next backoff
+  static void OnInterfacesAdded(GDBusConnection*, const gchar*, const gchar*, const gchar*, const gchar*,
+                                GVariant* parameters, gpointer user_data) {
+    auto* impl = static_cast<Impl*>(user_data);
+    const char* object_path = nullptr;
+    GVariant* interfaces = nullptr;
+    g_variant_get(parameters, "(&o@a{sa{sv}})", &object_path, &interfaces);
+    auto interfaces_wrapper = GObjectWrapper::make_variant(interfaces);
+
+    auto properties =
+        GObjectWrapper::make_variant(g_variant_lookup_value(interfaces, "org.bluez.Device1", G_VARIANT_TYPE_VARDICT));
+    if (!properties) {
+      return;
+    }
+
+    Attempts attempts;
+    {
+      std::lock_guard<std::mutex> lock(impl->mutex_);
+      auto it = impl->entries_.find(object_path);
+      if (it == impl->entries_.end()) {
+        return;
+      }
+      const std::shared_ptr<Entry>& entry = it->second;
+      gboolean connected = FALSE;
+      if (g_variant_lookup(properties.get(), "Connected", "b", &connected) && connected) {
+        impl->MarkConnectedLocked(entry.get());
+      } else if (!entry->stats.connected) {
+        DestroyTimer(entry.get());
+        entry->failures = 0;
+        impl->StartAttemptLocked(entry, &attempts);
+      } else {
+        impl->MarkDroppedLocked(entry, &attempts);
+      }
+    }
+    impl->Start(attempts);
+  }
+
+  // bluetoothd never sends Connected false for the objects it tears down
+  static void OnInterfacesRemoved(GDBusConnection*, const gchar*, const gchar*, const gchar*, const gchar*,
+                                  GVariant* parameters, gpointer user_data) {
+    auto* impl = static_cast<Impl*>(user_data);
+    const char* object_path = nullptr;
+    GVariantIter* interfaces_iter = nullptr;
+    g_variant_get(parameters, "(&oas)", &object_path, &interfaces_iter);
+    auto interfaces_iter_wrapper = GObjectWrapper::make_variant_iter(interfaces_iter);
+
+    const std::string removed_path = object_path;
+    const char* interface_name;
+    Attempts attempts;
+    {
+      std::lock_guard<std::mutex> lock(impl->mutex_);
+      while (g_variant_iter_loop(interfaces_iter_wrapper.get(), "&s", &interface_name)) {
+        if (g_strcmp0(interface_name, "org.bluez.Device1") == 0) {
+          auto it = impl->entries_.find(removed_path);
+          if (it != impl->entries_.end()) {
+            impl->MarkDroppedLocked(it->second, &attempts);
+          }
+        } else if (g_strcmp0(interface_name, "org.bluez.Adapter1") == 0) {
+          const std::string prefix = removed_path + "/";
+          for (auto& [path, entry] : impl->entries_) {
+            if (path.rfind(prefix, 0) == 0) {
+              impl->MarkDroppedLocked(entry, &attempts);
+            }
+          }
+        }
+      }
+    }
+    impl->Start(attempts);
+  }
+
+  // bluetoothd crashed, exited or restarted: no connection survives it
+  static void OnNameOwnerChanged(GDBusConnection*, const gchar*, const gchar*, const gchar*, const gchar*, GVariant*,
+                                 gpointer user_data) {
+    auto* impl = static_cast<Impl*>(user_data);
+    Attempts attempts;
+    {
+      std::lock_guard<std::mutex> lock(impl->mutex_);
+      for (auto& [path, entry] : impl->entries_) {
+        impl->MarkDroppedLocked(entry, &attempts);
+      }
+    }
+    impl->Start(attempts);
+  }
+
+  void MarkConnectedLocked(Entry* entry) {
+    entry->failures = 0;
+    DestroyTimer(entry);
+    if (entry->stats.connected) {
+      return;
+    }
+    entry->stats.connected = true;
+    if (entry->dropped) {
+      const auto latency = MillisecondsSince(entry->dropped_at);
+      entry->dropped = false;
+      entry->stats.reconnects += 1;
+      entry->stats.last_reconnect_latency = latency;
+      entry->stats.max_reconnect_latency = std::max(entry->stats.max_reconnect_latency, latency);
+      entry->stats.time_disconnected += latency;
+    }
+  }
+
+  void MarkDroppedLocked(const std::shared_ptr<Entry>& entry, Attempts* attempts) {
+    if (!entry->stats.connected) {
+      return;
+    }
+    entry->stats.connected = false;
+    entry->stats.drops += 1;
+    entry->dropped = true;
+    entry->dropped_at = Clock::now();
+    StartAttemptLocked(entry, attempts);
+  }
+
+  // Claims the attempt; counted as outstanding already, so destruction waits for it to be issued and answered
+  void StartAttemptLocked(const std::shared_ptr<Entry>& entry, Attempts* attempts) {
+    if (entry->connecting || entry->removed || stopping_) {
+      return;
+    }
+    entry->connecting = true;
+    entry->stats.reconnect_attempts += 1;
+    ++outstanding_;
+    attempts->push_back(entry);
+  }
+
+  // Without mutex_: issuing a call may reopen the session's connection, which waits on the loop thread
+  void Start(const Attempts& attempts) {
+    for (const auto& entry : attempts) {
+      session_.impl().CallDeviceMethodAsync(entry->device, internal::kConnectMethod, options_.timeout_seconds,
+                                            [this, entry](const Result& result) { OnAttempt(entry, result); });
+    }
+  }
+
+  void OnAttempt(const std::shared_ptr<Entry>& entry, const Result& result) {
+    std::lock_guard<std::mutex> lock(mutex_);
+    entry->connecting = false;
+    if (!result.hasError()) {
+      MarkConnectedLocked(entry.get());
+    } else if (!entry->stats.connected && !entry->removed && !stopping_) {
+      ScheduleAttemptLocked(entry, RetryBackoff(backoff_, ++entry->failures));
+    }
+    if (--outstanding_ == 0) {
+      idle_.notify_all();
+    }
+  }
+
+  // Loop thread only
+  void ScheduleAttemptLocked(const std::shared_ptr<Entry>& entry, std::chrono::milliseconds delay) {
+    struct Wakeup {
+      Impl* impl;
+      std::shared_ptr<Entry> entry;
+    };
+    DestroyTimer(entry.get());
+    entry->timer = g_timeout_source_new(static_cast<guint>(delay.count()));
+    g_source_set_callback(
+        entry->timer,
+        [](gpointer data) -> gboolean {
+          auto* wakeup = static_cast<Wakeup*>(data);
+          Attempts attempts;
+          {
+            std::lock_guard<std::mutex> lock(wakeup->impl->mutex_);
+            // The source is done once this returns; drop our reference
+            g_source_unref(wakeup->entry->timer);
+            wakeup->entry->timer = nullptr;
+            wakeup->impl->StartAttemptLocked(wakeup->entry, &attempts);
+          }
+          wakeup->impl->Start(attempts);
+          return G_SOURCE_REMOVE;
+        },
+        new Wakeup{this, entry}, [](gpointer data) { delete static_cast<Wakeup*>(data); });
+    g_source_attach(entry->timer, session_.impl().context());
+  }
+
+  // Loop thread only
+  static void DestroyTimer(Entry* entry) {
+    if (entry->timer) {
+      g_source_destroy(entry->timer);
+      g_source_unref(entry->timer);
+      entry->timer = nullptr;
+    }
+  }
+
+  KeptDeviceStats SnapshotLocked(const Entry& entry) const {
+    KeptDeviceStats stats = entry.stats;
+    if (entry.dropped) {
+      stats.time_disconnected += MillisecondsSince(entry.dropped_at);
+    }
+    return stats;
+  }
+
+  Session& session_;
+  const KeeperOptions options_;
+  const RetryPolicy backoff_;
+
+  std::mutex subscribe_mutex_;  // guards connection_, subscription_ids_ and closed_handler_
+  GObjectWrapper::DBusConnection connection_{GObjectWrapper::make_dbus_connection(nullptr)};
+  std::vector<guint> subscription_ids_;
+  gulong closed_handler_{0};
+  std::thread resubscriber_;  // started by the first subscription
+
+  mutable std::mutex mutex_;  // guards everything below, and the entries themselves
+  std::condition_variable idle_;
+  std::condition_variable resubscribe_wanted_;
+  bool stopping_{false};
+  bool resubscribe_{false};  // the connection closed, for resubscriber_
+  std::unordered_map<std::string, std::shared_ptr<Entry>> entries_;  // by Device1 object path
+  size_t outstanding_{0};  // attempts in flight
+};
+
+ConnectionKeeper::ConnectionKeeper(Session& session, const KeeperOptions& options)
+    : impl_(std::make_unique<Impl>(session, options)) {}
+
+ConnectionKeeper::~ConnectionKeeper() = default;
+
+Result ConnectionKeeper::Add(const DeviceAddress& device) { return impl_->Add(device); }
+
+bool ConnectionKeeper::Remove(const DeviceAddress& device) { return impl_->Remove(device); }
+
+std::optional<KeptDeviceStats> ConnectionKeeper::Stats(const DeviceAddress& device) const {
+  return impl_->Stats(device);
+}
+
+std::vector<KeptDeviceStats> ConnectionKeeper::Stats() const { return impl_->Stats(); }
+
+}  // namespace ble
@@ -0,0 +1,569 @@
+// MIT License
+// Copyright (c) 2025 pezy
+
+#include <bluetooth/connection_scheduler.hpp>
+
+// std
+#include <algorithm>
+#include <condition_variable>
+#include <map>
+#include <mutex>
+#include <tuple>
+#include <unordered_map>
+#include <unordered_set>
+
+#include "session_impl.hpp"
+
+namespace ble {
+
+using internal::GObjectWrapper;
+using internal::MakeErrorResult;
+using internal::ScopedTimer;
+using Clock = std::chrono::steady_clock;
+
+namespace {
+
+constexpr size_t kNoAdapter = static_cast<size_t>(-1);
+
+// Weight of the newest attempt in AdapterLoad::average_attempt
+constexpr double kAttemptAverageWeight = 0.2;
+
+Result SuccessResult() {
+  Result result;
+  result.success = true;
+  return result;
+}
+
+// At least one attempt per adapter, or nothing would ever start
+SchedulerOptions Sanitize(SchedulerOptions options) {
+  options.max_attempts_per_adapter = std::max<size_t>(options.max_attempts_per_adapter, 1);
+  return options;
+}
+
+const internal::DeviceMethod& MethodOf(bool pair) { return pair ? internal::kPairMethod : internal::kConnectMethod; }
+
+// Adapts a promise to a completion callback
+ScheduledCallback FulfillPromise(const std::shared_ptr<std::promise<DeviceResult>>& promise) {
+  return [promise](const DeviceResult& result) { promise->set_value(result); };
+}
+
+}  // anonymous namespace
+
+class ConnectionScheduler::Impl {
+ public:
+  Impl(Session& session, const SchedulerOptions& options) : session_(session), options_(Sanitize(options)) {}
+
+  ~Impl() {
+    std::vector<Step> steps;
+    {
+      std::lock_guard<std::mutex> lock(mutex_);
+      stopping_ = true;
+      for (auto& [key, request] : queue_) {
+        const auto& method = MethodOf(request.pair);
+        steps.push_back(
+            Settle(std::move(request), kNoAdapter, MakeErrorResult(method.failure_code, "Scheduler destroyed")));
+      }
+      queue_.clear();
+    }
+    Run(std::move(steps));
+
+    {
+      std::unique_lock<std::mutex> lock(mutex_);
+      idle_.wait(lock, [this]() { return outstanding_ == 0; });
+    }
+
+    // Nothing re-arms the timer any more, but it may still fire until removed here
+    session_.impl().RunOnLoop([this]() { DestroyTimer(); });
+  }
+
+  void Submit(const std::string& mac_address, bool pair, ScheduledCallback callback, const RequestOptions& options) {
+    Request request{internal::NormalizeMacAddress(mac_address), pair, options.deadline, std::move(callback)};
+    std::vector<Step> steps;
+    {
+      std::lock_guard<std::mutex> lock(mutex_);
+      ++outstanding_;
+      if (options_.max_queued != 0 && queue_.size() >= options_.max_queued) {
+        steps.push_back(
+            Settle(std::move(request), kNoAdapter, MakeErrorResult(MethodOf(pair).failure_code, "Queue is full")));
+      } else {
+        const Clock::time_point order =
+            options.deadline == Clock::time_point() ? Clock::time_point::max() : options.deadline;
+        queue_.emplace(QueueKey{-int64_t{options.priority}, order, next_sequence_++}, std::move(request));
+        DispatchLocked(&steps);
+        ArmTimerLocked();
+      }
+    }
+    Run(std::move(steps));
+  }
+
+  Result Disconnect(const std::string& mac_address, int timeout_seconds) {
+    const std::string mac = internal::NormalizeMacAddress(mac_address);
+    std::string adapter;
+    {
+      std::lock_guard<std::mutex> lock(mutex_);
+      auto it = connected_on_.find(mac);
+      if (it == connected_on_.end()) {
+        return MakeErrorResult(ErrorCode::DisconnectFailed, "Device not connected through any scheduled adapter");
+      }
+      adapter = adapters_[it->second].load.adapter;
+    }
+
+    Result result = session_.DisconnectDevice(DeviceAddress(mac, adapter), timeout_seconds);
+    if (result.hasError()) {
+      return result;
+    }
+
+    std::vector<Step> steps;
+    {
+      std::lock_guard<std::mutex> lock(mutex_);
+      auto it = connected_on_.find(mac);
+      if (it != connected_on_.end()) {
+        --adapters_[it->second].load.connected;
+        connected_on_.erase(it);
+      }
+      DispatchLocked(&steps);
+    }
+    Run(std::move(steps));
+    return result;
+  }
+
+  Result Refresh() {
+    Result result;
+    ScopedTimer timer(result.operation_time);
+
+    DeviceQueryResult error_result;
+    GVariant* objects_result = session_.impl().GetManagedObjects(&error_result);
+    if (!objects_result) {
+      result.error_code = error_result.error_code;
+      result.error_message = error_result.error_message;
+      return result;
+    }
+
+    // RAII wrapper for objects result
+    auto objects_result_wrapper = GObjectWrapper::make_variant(objects_result);
+
+    std::vector<AdapterInfo> adapters;
+    internal::AppendAdapters(objects_result_wrapper.get(), &adapters);
+
+    std::vector<Step> steps;
+    {
+      std::lock_guard<std::mutex> lock(mutex_);
+
+      // Indices stay stable across refreshes because attempts in flight refer to them
+      for (auto& state : adapters_) {
+        state.enabled = false;
+        state.load.connected = 0;
+      }
+      for (const auto& adapter : adapters) {
+        const bool wanted = options_.adapters.empty()
+                                ? adapter.powered
+                                : std::find(options_.adapters.begin(), options_.adapters.end(), adapter.name) !=
+                                      options_.adapters.end();
+        if (wanted) {
+          adapters_[AdapterIndexLocked(adapter.name)].enabled = true;
+        }
+      }
+
+      known_.clear();
+      connected_on_.clear();
+      internal::ForEachDevice(objects_result_wrapper.get(), [this](const char* object_path, GVariant* properties) {
+        const std::string mac = internal::NormalizeMacAddress(internal::ExtractMacAddress(properties));
+        auto it = index_.find(internal::AdapterFromObjectPath(object_path));
+        if (mac.empty() || it == index_.end() || !adapters_[it->second].enabled) {
+          return;
+        }
+        known_[mac].push_back(it->second);
+        if (internal::ExtractConnected(properties)) {
+          ++adapters_[it->second].load.connected;
+          connected_on_[mac] = it->second;
+        }
+      });
+      DispatchLocked(&steps);
+      ArmTimerLocked();
+    }
+    Run(std::move(steps));
+
+    result.success = true;
+    return result;
+  }
+
+  std::vector<AdapterLoad> Load() const {
+    std::lock_guard<std::mutex> lock(mutex_);
+    std::vector<AdapterLoad> load;
+    for (const auto& state : adapters_) {
+      if (state.enabled) {
+        load.push_back(state.load);
+        load.back().average_attempt = std::chrono::milliseconds(static_cast<int64_t>(state.average_attempt_ms));
+      }
+    }
+    return load;
+  }
+
+ private:
+  struct AdapterState {
+    AdapterLoad load;
+    double average_attempt_ms{0};
+    bool enabled{false};  // selected and present in the last Refresh
+  };
+
+  struct Request {
+    std::string mac_address;  // normalized, as BlueZ reports it
+    bool pair;
+    Clock::time_point deadline;  // epoch when there is none
+    ScheduledCallback callback;
+  };
+
+  // Queue order: higher priority (stored negated), then earlier deadline, then submission
+  using QueueKey = std::tuple<int64_t, Clock::time_point, uint64_t>;
+
+  // A request leaving the queue: either an attempt through adapter, or a result to deliver as is
+  struct Step {
+    Request request;
+    bool attempt;
+    size_t index;
+    std::string adapter;
+    Result result;
+  };
+
+  Step Settle(Request request, size_t index, Result result) const {
+    std::string adapter = index != kNoAdapter ? adapters_[index].load.adapter : std::string();
+    return Step{std::move(request), false, index, std::move(adapter), std::move(result)};
+  }
+
+  size_t AdapterIndexLocked(const std::string& name) {
+    auto [it, inserted] = index_.try_emplace(name, adapters_.size());
+    if (inserted) {
+      adapters_.push_back({});
+      adapters_.back().load.adapter = name;
+    }
+    return it->second;
+  }
+
+  // The least loaded adapter that may start an attempt for mac now, or kNoAdapter. *all_full tells whether every
+  // adapter knowing the device is at its connection limit, so waiting is pointless.
+  size_t PickAdapterLocked(const std::vector<size_t>& candidates, bool* all_full) const {
+    size_t best = kNoAdapter;
+    size_t best_load = 0;
+    *all_full = true;
+    for (size_t candidate : candidates) {
+      const AdapterState& state = adapters_[candidate];
+      if (!state.enabled) {
+        continue;
+      }
+      const size_t load = state.load.connected + state.load.in_flight;
+      if (state.load.connected < options_.max_connections_per_adapter) {
+        *all_full = false;
+      }
+      if (!HasFreeSlot(state)) {
+        continue;
+      }
+      if (best == kNoAdapter || load < best_load) {
+        best = candidate;
+        best_load = load;
+      }
+    }
+    return best;
+  }
+
+  // Latest start that can still meet the request's deadline, time_point::max() without one
+  Clock::time_point CutoffLocked(const Request& request) const {
+    if (request.deadline == Clock::time_point()) {
+      return Clock::time_point::max();
+    }
+    double fastest_ms = -1;
+    auto known = known_.find(request.mac_address);
+    if (known != known_.end()) {
+      for (size_t candidate : known->second) {
+        const AdapterState& state = adapters_[candidate];
+        if (state.enabled && (fastest_ms < 0 || state.average_attempt_ms < fastest_ms)) {
+          fastest_ms = state.average_attempt_ms;
+        }
+      }
+    }
+    return request.deadline - std::chrono::duration_cast<Clock::duration>(
+                                  std::chrono::duration<double, std::milli>(std::max(fastest_ms, 0.0)));
+  }
+
+  // Moves every queued request that can be settled now into steps. Requests
+  // that have to wait for a slot stay queued in order, but do not hold back
+  // later ones whose device is reachable through another adapter.
+  void DispatchLocked(std::vector<Step>* steps) {
+    const Clock::time_point now = Clock::now();
+    size_t free_slots = FreeSlotsLocked();
+    for (auto it = queue_.begin(); it != queue_.end();) {
+      // Once every slot is taken nothing can start; the next completion or the timer dispatches again
+      if (free_slots == 0 && !connecting_.empty()) {
+        break;
+      }
+
+      Request& request = it->second;
+      const std::string& mac = request.mac_address;
+      const auto& method = MethodOf(request.pair);
+
+      auto connected = connected_on_.find(mac);
+      auto known = known_.find(mac);
+      if (!request.pair && connected != connected_on_.end()) {
+        steps->push_back(Settle(std::move(request), connected->second, SuccessResult()));
+      } else if (known == known_.end()) {
+        steps->push_back(
+            Settle(std::move(request), kNoAdapter, MakeErrorResult(ErrorCode::DeviceNotFound, "Device not known")));
+      } else if (CutoffLocked(request) <= now) {
+        steps->push_back(Settle(std::move(request), kNoAdapter,
+                                MakeErrorResult(method.timeout_code, "Deadline can no longer be met")));
+      } else if (connecting_.count(mac)) {
+        // A second request for a device in use waits for the first to finish
+        ++it;
+        continue;
+      } else {
+        bool all_full = true;
+        const size_t adapter = PickAdapterLocked(known->second, &all_full);
+        if (adapter != kNoAdapter) {
+          ++adapters_[adapter].load.in_flight;
+          connecting_.insert(mac);
+          if (!HasFreeSlot(adapters_[adapter])) {
+            --free_slots;
+          }
+          steps->push_back(Step{std::move(request), true, adapter, adapters_[adapter].load.adapter, Result()});
+        } else if (all_full) {
+          steps->push_back(Settle(std::move(request), kNoAdapter,
+                                  MakeErrorResult(method.failure_code, "Every adapter of the device is at its limit")));
+        } else {
+          ++it;
+          continue;
+        }
+      }
+      it = queue_.erase(it);
+    }
+  }
+
+  // Adapters that could start one more attempt
+  size_t FreeSlotsLocked() const {
+    return std::count_if(adapters_.begin(), adapters_.end(),
+                         [this](const AdapterState& state) { return state.enabled && HasFreeSlot(state); });
+  }
+
+  bool HasFreeSlot(const AdapterState& state) const {
+    return state.load.in_flight < options_.max_attempts_per_adapter &&
+           state.load.connected + state.load.in_flight < options_.max_connections_per_adapter;
+  }
+
+  // Makes sure the timer fires by the earliest cutoff of a queued request, so
+  // requests waiting for a slot fail on time even when no attempt completes
+  void ArmTimerLocked() {
+    if (stopping_) {
+      return;
+    }
+    Clock::time_point earliest = Clock::time_point::max();
+    for (const auto& [key, request] : queue_) {
+      earliest = std::min(earliest, CutoffLocked(request));
+    }
+    if (earliest == Clock::time_point::max() || earliest >= timer_at_) {
+      return;
+    }
+    timer_at_ = earliest;
+
+    // Counted like a request so destruction waits for it
+    ++outstanding_;
+    session_.Post([this, earliest]() {
+      DestroyTimer();
+      const auto delay = std::chrono::ceil<std::chrono::milliseconds>(earliest - Clock::now());
+      timer_ = g_timeout_source_new(static_cast<guint>(std::max<int64_t>(delay.count(), 0)));
+      g_source_set_callback(
+          timer_,
+          [](gpointer data) -> gboolean {
+            static_cast<Impl*>(data)->OnTimer();
+            return G_SOURCE_REMOVE;
+          },
+          this, nullptr);
+      g_source_attach(timer_, session_.impl().context());
+      Finished();
+    });
+  }
+
+  // Loop thread only
+  void DestroyTimer() {
+    if (timer_) {
+      g_source_destroy(timer_);
+      g_source_unref(timer_);
+      timer_ = nullptr;
+    }
+  }
+
+  void OnTimer() {
+    // The source is done once this returns; drop our reference
+    g_source_unref(timer_);
+    timer_ = nullptr;
+
+    std::vector<Step> steps;
+    {
+      std::lock_guard<std::mutex> lock(mutex_);
+      timer_at_ = Clock::time_point::max();
+      ExpireLocked(&steps);
+      DispatchLocked(&steps);
+      ArmTimerLocked();
+    }
+    Run(std::move(steps));
+  }
+
+  // Fails every queued request past its cutoff, including those DispatchLocked stops before
+  void ExpireLocked(std::vector<Step>* steps) {
+    const Clock::time_point now = Clock::now();
+    for (auto it = queue_.begin(); it != queue_.end();) {
+      if (CutoffLocked(it->second) > now) {
+        ++it;
+        continue;
+      }
+      const auto& method = MethodOf(it->second.pair);
+      steps->push_back(Settle(std::move(it->second), kNoAdapter,
+                              MakeErrorResult(method.timeout_code, "Deadline can no longer be met")));
+      it = queue_.erase(it);
+    }
+  }
+
+  void Run(std::vector<Step> steps) {
+    for (auto& step : steps) {
+      if (!step.attempt) {
+        // Delivered from the loop thread like the completions of attempts
+        session_.Post([this, step = std::move(step)]() {
+          if (step.request.callback) step.request.callback({step.request.mac_address, step.result, step.adapter});
+          Finished();
+        });
+        continue;
+      }
+
+      // An attempt may not outlive the deadline of its request
+      int timeout_seconds = options_.timeout_seconds;
+      const Clock::time_point start = Clock::now();
+      if (step.request.deadline != Clock::time_point()) {
+        const auto remaining = std::chrono::ceil<std::chrono::seconds>(step.request.deadline - start);
+        timeout_seconds = std::clamp<int>(static_cast<int>(remaining.count()), 1, std::max(timeout_seconds, 1));
+      }
+
+      const DeviceAddress device(step.request.mac_address, step.adapter);
+      const auto& method = MethodOf(step.request.pair);
+      session_.impl().CallDeviceMethodAsync(
+          device, method, timeout_seconds,
+          [this, request = std::move(step.request), index = step.index, adapter = step.adapter,
+           start](const Result& result) { OnComplete(request, index, adapter, start, result); });
+    }
+  }
+
+  void OnComplete(const Request& request, size_t index, const std::string& adapter, Clock::time_point start,
+                  const Result& result) {
+    const double elapsed_ms = std::chrono::duration<double, std::milli>(Clock::now() - start).count();
+    std::vector<Step> steps;
+    {
+      std::lock_guard<std::mutex> lock(mutex_);
+      AdapterState& state = adapters_[index];
+      state.average_attempt_ms =
+          state.load.attempts == 0
+              ? elapsed_ms
+              : state.average_attempt_ms + kAttemptAverageWeight * (elapsed_ms - state.average_attempt_ms);
+      --state.load.in_flight;
+      ++state.load.attempts;
+      connecting_.erase(request.mac_address);
+      if (!request.pair && !result.hasError() && connected_on_.emplace(request.mac_address, index).second) {
+        ++state.load.connected;
+      }
+      if (!stopping_) {
+        DispatchLocked(&steps);
+      }
+    }
+    Run(std::move(steps));
+
+    if (request.callback) request.callback({request.mac_address, result, adapter});
+    Finished();
+  }
+
+  void Finished() {
+    std::lock_guard<std::mutex> lock(mutex_);
+    if (--outstanding_ == 0) {
+      idle_.notify_all();
+    }
+  }
+
+  Session& session_;
+  const SchedulerOptions options_;
+  GSource* timer_{nullptr};  // deadline timer, loop thread only
+
+  mutable std::mutex mutex_;  // guards everything below
+  std::condition_variable idle_;
+  bool stopping_{false};
+  std::vector<AdapterState> adapters_;
+  std::unordered_map<std::string, size_t> index_;               // adapter name -> position in adapters_
+  std::unordered_map<std::string, std::vector<size_t>> known_;  // MAC -> adapters that have its object
+  std::unordered_map<std::string, size_t> connected_on_;        // MAC -> adapter it is connected through
+  std::unordered_set<std::string> connecting_;                  // MACs with an attempt in flight
+  std::map<QueueKey, Request> queue_;
+  uint64_t next_sequence_{0};
+  Clock::time_point timer_at_{Clock::time_point::max()};  // when the armed timer fires
+  size_t outstanding_{0};  // requests and timer posts whose callback has not returned yet
+};
+
+ConnectionScheduler::ConnectionScheduler(Session& session, const SchedulerOptions& options)
+    : impl_(std::make_unique<Impl>(session, options)) {
+  impl_->Refresh();
+}
+
+ConnectionScheduler::~ConnectionScheduler() = default;
+
+void ConnectionScheduler::Connect(const std::string& mac_address, ScheduledCallback callback,
+                                  const RequestOptions& request) {
+  impl_->Submit(mac_address, false, std::move(callback), request);
+}
+
+std::future<DeviceResult> ConnectionScheduler::Connect(const std::string& mac_address, const RequestOptions& request) {
+  auto promise = std::make_shared<std::promise<DeviceResult>>();
+  auto future = promise->get_future();
+  impl_->Submit(mac_address, false, FulfillPromise(promise), request);
+  return future;
+}
+
+void ConnectionScheduler::Pair(const std::string& mac_address, ScheduledCallback callback,
+                               const RequestOptions& request) {
+  impl_->Submit(mac_address, true, std::move(callback), request);
+}
+
+std::future<DeviceResult> ConnectionScheduler::Pair(const std::string& mac_address, const RequestOptions& request) {
+  auto promise = std::make_shared<std::promise<DeviceResult>>();
+  auto future = promise->get_future();
+  impl_->Submit(mac_address, true, FulfillPromise(promise), request);
+  return future;
+}
+
+std::vector<DeviceResult> ConnectionScheduler::ConnectAll(std::span<const std::string> mac_addresses,
+                                                          const RequestOptions& request) {
+  struct State {
+    std::mutex mutex;
+    std::condition_variable finished;
+    std::vector<DeviceResult> results;
+    size_t completed{0};
+  };
+  auto state = std::make_shared<State>();
+  state->results.resize(mac_addresses.size());
+
+  for (size_t i = 0; i < mac_addresses.size(); ++i) {
+    auto callback = [state, i](const DeviceResult& result) {
+      std::lock_guard<std::mutex> lock(state->mutex);
+      state->results[i] = result;
+      if (++state->completed == state->results.size()) {
+        state->finished.notify_all();
+      }
+    };
+    impl_->Submit(mac_addresses[i], false, std::move(callback), request);
+  }
+
+  std::unique_lock<std::mutex> lock(state->mutex);
+  state->finished.wait(lock, [&state]() { return state->completed == state->results.size(); });
+  return std::move(state->results);
+}
+
+Result ConnectionScheduler::Disconnect(const std::string& mac_address, int timeout_seconds) {
+  return impl_->Disconnect(mac_address, timeout_seconds);
+}
+
+Result ConnectionScheduler::Refresh() { return impl_->Refresh(); }
+
+std::vector<AdapterLoad> ConnectionScheduler::Load() const { return impl_->Load(); }
+
+}  // namespace ble
@@ -0,0 +1,596 @@
+// MIT License
+// Copyright (c) 2025 pezy
+
+#include <bluetooth/daemon.hpp>
+#include <bluetooth/discovery.hpp>
+
+// std
+#include <algorithm>
+#include <atomic>
+#include <cerrno>
+#include <cstdint>
+#include <cstdlib>
+#include <cstring>
+#include <thread>
+#include <utility>
+#include <vector>
+
+// sys
+#include <fcntl.h>
+#include <poll.h>
+#include <sys/socket.h>
+#include <sys/stat.h>
+#include <sys/un.h>
+#include <unistd.h>
+
+#include "bluez_utils.hpp"
+
+namespace ble {
+
+using internal::MakeErrorResult;
+
+namespace {
+
+// Wire format
+//
+// Every message is a frame: a uint32 payload length, then the payload.
+// Integers travel in host byte order, as both ends share the host; strings as
+// a uint32 length and the bytes. A request payload is the protocol version,
+// the operation, and for the device operations the MAC address, the adapter
+// and an int64 argument: the timeout in seconds, or the milliseconds left
+// before the ScanAndPair deadline. A response payload is the status (success,
+// error code, error message, time in milliseconds), then a uint32 count of
+// attempt times for a Result or of devices for a listing. Errors in the
+// request itself, including an argument outside 1 to 600 s or 0 to 10 min,
+// are answered with DaemonRequestRejected and a count of 0, which reads as
+// either. A request never needs more than a few hundred bytes; a response
+// carries a whole listing.
+constexpr uint8_t kProtocolVersion = 1;
+constexpr uint32_t kMaxRequestSize = 4u << 10;
+constexpr uint32_t kMaxResponseSize = 64u << 20;
+
+// Clients served at once, one thread each; connections beyond are closed at once
+constexpr size_t kMaxClients = 64;
+
+// Bounds on the request argument: method timeouts in seconds, ScanAndPair deadlines in milliseconds from now
+constexpr int64_t kMinTimeoutSeconds = 1;
+constexpr int64_t kMaxTimeoutSeconds = 600;
+constexpr int64_t kMaxDeadlineMs = 600 * 1000;
+
+enum class Operation : uint8_t {
+  GetPairedDevices = 1,
+  PairDevice = 2,
+  ScanAndPair = 3,
+  ConnectDevice = 4,
+  DisconnectDevice = 5,
+};
+
+// BluetoothDevice flags
+constexpr uint8_t kConnected = 1 << 0;
+constexpr uint8_t kHasName = 1 << 1;
+constexpr uint8_t kHasClass = 1 << 2;
+constexpr uint8_t kHasRssi = 1 << 3;
+
+class FrameWriter {
+ public:
+  FrameWriter() : buffer_(sizeof(uint32_t), '\0') {}
+
+  template <typename T>
+  void Put(T value) {
+    buffer_.append(reinterpret_cast<const char*>(&value), sizeof(value));
+  }
+
+  void PutString(const std::string& value) {
+    Put(static_cast<uint32_t>(value.size()));
+    buffer_.append(value);
+  }
+
+  // Fills in the length prefix
+  const std::string& Finish() {
+    const auto length = static_cast<uint32_t>(buffer_.size() - sizeof(uint32_t));
+    std::memcpy(buffer_.data(), &length, sizeof(length));
+    return buffer_;
+  }
+
+ private:
+  std::string buffer_;
+};
+
+class FrameReader {
+ public:
+  explicit FrameReader(const std::string& payload) : next_(payload.data()), end_(payload.data() + payload.size()) {}
+
+  template <typename T>
+  bool Get(T* value) {
+    if (left() < sizeof(T)) {
+      return false;
+    }
+    std::memcpy(value, next_, sizeof(T));
+    next_ += sizeof(T);
+    return true;
+  }
+
+  bool GetString(std::string* value) {
+    uint32_t length = 0;
+    if (!Get(&length) || left() < length) {
+      return false;
+    }
+    value->assign(next_, length);
+    next_ += length;
+    return true;
+  }
+
+ private:
+  size_t left() const { return static_cast<size_t>(end_ - next_); }
+
+  const char* next_;
+  const char* end_;
+};
+
+void PutStatus(FrameWriter& writer, bool success, int error_code, const std::string& error_message,
+               std::chrono::milliseconds time) {
+  writer.Put<uint8_t>(success ? 1 : 0);
+  writer.Put<int32_t>(error_code);
+  writer.PutString(error_message);
+  writer.Put<int64_t>(time.count());
+}
+
+template <typename T>
+bool GetStatus(FrameReader& reader, T* result, std::chrono::milliseconds* time) {
+  uint8_t success = 0;
+  int32_t error_code = 0;
+  int64_t milliseconds = 0;
+  if (!reader.Get(&success) || !reader.Get(&error_code) || !reader.GetString(&result->error_message) ||
+      !reader.Get(&milliseconds)) {
+    return false;
+  }
+  result->success = success != 0;
+  result->error_code = error_code;
+  *time = std::chrono::milliseconds(milliseconds);
+  return true;
+}
+
+void PutResult(FrameWriter& writer, const Result& result) {
+  PutStatus(writer, result.success, result.error_code, result.error_message, result.operation_time);
+  writer.Put(static_cast<uint32_t>(result.attempt_times.size()));
+  for (const auto& time : result.attempt_times) {
+    writer.Put<int64_t>(time.count());
+  }
+}
+
+bool GetResult(FrameReader& reader, Result* result) {
+  uint32_t count = 0;
+  if (!GetStatus(reader, result, &result->operation_time) || !reader.Get(&count)) {
+    return false;
+  }
+  for (uint32_t i = 0; i < count; ++i) {
+    int64_t milliseconds = 0;
+    if (!reader.Get(&milliseconds)) {
+      return false;
+    }
+    result->attempt_times.emplace_back(milliseconds);
+  }
+  return true;
+}
+
+void PutDevices(FrameWriter& writer, const DeviceQueryResult& result) {
+  PutStatus(writer, result.success, result.error_code, result.error_message, result.query_time);
+  writer.Put(static_cast<uint32_t>(result.devices.size()));
+  for (const auto& device : result.devices) {
+    writer.PutString(device.mac_address);
+    writer.PutString(device.adapter);
+    writer.Put<uint8_t>((device.connected ? kConnected : 0) | (device.device_name ? kHasName : 0) |
+                        (device.device_class ? kHasClass : 0) | (device.rssi ? kHasRssi : 0));
+    if (device.device_name) writer.PutString(*device.device_name);
+    if (device.device_class) writer.Put<uint32_t>(*device.device_class);
+    if (device.rssi) writer.Put<int16_t>(*device.rssi);
+  }
+}
+
+bool GetDevices(FrameReader& reader, DeviceQueryResult* result) {
+  uint32_t count = 0;
+  if (!GetStatus(reader, result, &result->query_time) || !reader.Get(&count)) {
+    return false;
+  }
+  result->devices.reserve(count);
+  for (uint32_t i = 0; i < count; ++i) {
+    BluetoothDevice device{};
+    uint8_t flags = 0;
+    if (!reader.GetString(&device.mac_address) || !reader.GetString(&device.adapter) || !reader.Get(&flags)) {
+      return false;
+    }
+    device.connected = (flags & kConnected) != 0;
+    if (flags & kHasName) {
+      if (!reader.GetString(&device.device_name.emplace())) return false;
+    }
+    if (flags & kHasClass) {
+      if (!reader.Get(&device.device_class.emplace())) return false;
+    }
+    if (flags & kHasRssi) {
+      if (!reader.Get(&device.rssi.emplace())) return false;
+    }
+    result->devices.push_back(std::move(device));
+  }
+  return true;
+}
+
+bool SendAll(int fd, const std::string& data) {
+  size_t sent = 0;
+  while (sent < data.size()) {
+    const ssize_t n = send(fd, data.data() + sent, data.size() - sent, MSG_NOSIGNAL);
+    if (n < 0) {
+      if (errno == EINTR) continue;
+      return false;
+    }
+    sent += static_cast<size_t>(n);
+  }
+  return true;
+}
+
+bool ReceiveAll(int fd, char* data, size_t size) {
+  size_t received = 0;
+  while (received < size) {
+    const ssize_t n = recv(fd, data + received, size - received, 0);
+    if (n < 0 && errno == EINTR) continue;
+    if (n <= 0) {
+      return false;
+    }
+    received += static_cast<size_t>(n);
+  }
+  return true;
+}
+
+bool ReceiveFrame(int fd, std::string* payload, uint32_t max_size) {
+  uint32_t length = 0;
+  if (!ReceiveAll(fd, reinterpret_cast<char*>(&length), sizeof(length)) || length > max_size) {
+    return false;
+  }
+  payload->resize(length);
+  return ReceiveAll(fd, payload->data(), length);
+}
+
+bool MakeAddress(const std::string& path, sockaddr_un* address) {
+  std::memset(address, 0, sizeof(*address));
+  address->sun_family = AF_UNIX;
+  if (path.empty() || path.size() >= sizeof(address->sun_path)) {
+    return false;
+  }
+  std::memcpy(address->sun_path, path.c_str(), path.size());
+  return true;
+}
+
+// -1 when nothing listens on path
+int ConnectSocket(const std::string& path) {
+  sockaddr_un address;
+  if (!MakeAddress(path, &address)) {
+    return -1;
+  }
+  const int fd = socket(AF_UNIX, SOCK_STREAM | SOCK_CLOEXEC, 0);
+  if (fd < 0) {
+    return -1;
+  }
+  if (connect(fd, reinterpret_cast<const sockaddr*>(&address), sizeof(address)) != 0) {
+    close(fd);
+    return -1;
+  }
+  return fd;
+}
+
+Result SocketError(const std::string& what, const std::string& path) {
+  return MakeErrorResult(ErrorCode::DaemonUnavailable, what + " " + path + ": " + std::strerror(errno));
+}
+
+}  // anonymous namespace
+
+std::string DaemonSocketPath() {
+  if (const char* path = std::getenv("BLED_SOCKET"); path && *path) {
+    return path;
+  }
+  if (const char* runtime_dir = std::getenv("XDG_RUNTIME_DIR"); runtime_dir && *runtime_dir) {
+    return std::string(runtime_dir) + "/bled.sock";
+  }
+  return "/tmp/bled.sock";
+}
+
+class DaemonServer::Impl {
+ public:
+  explicit Impl(Session& session) : session_(session) {}
+
+  ~Impl() {
+    if (listen_fd_ >= 0) {
+      close(listen_fd_);
+      unlink(path_.c_str());
+    }
+    for (int fd : wake_) {
+      if (fd >= 0) close(fd);
+    }
+  }
+
+  Result Listen(const std::string& path) {
+    sockaddr_un address;
+    if (!MakeAddress(path, &address)) {
+      return MakeErrorResult(ErrorCode::DaemonUnavailable, "Invalid socket path: " + path);
+    }
+    if (listen_fd_ >= 0) {
+      return MakeErrorResult(ErrorCode::DaemonUnavailable, "Already listening on " + path_);
+    }
+
+    // A daemon that still answers owns the socket; a file nobody answers on is left over from a crash
+    if (const int probe = ConnectSocket(path); probe >= 0) {
+      close(probe);
+      return MakeErrorResult(ErrorCode::DaemonUnavailable, "Another daemon is listening on " + path);
+    }
+    unlink(path.c_str());
+
+    if (wake_[0] < 0 && pipe2(wake_, O_CLOEXEC | O_NONBLOCK) != 0) {
+      return SocketError("Failed to create the wake pipe for", path);
+    }
+    const int fd = socket(AF_UNIX, SOCK_STREAM | SOCK_CLOEXEC, 0);
+    if (fd < 0) {
+      return SocketError("Failed to create socket for", path);
+    }
+    // Linux creates the socket file with the mode of the unbound socket, so it is never open to others
+    if (fchmod(fd, S_IRUSR | S_IWUSR) != 0 ||
+        bind(fd, reinterpret_cast<const sockaddr*>(&address), sizeof(address)) != 0 || listen(fd, SOMAXCONN) != 0) {
+      Result result = SocketError("Failed to listen on", path);
+      close(fd);
+      return result;
+    }
+    listen_fd_ = fd;
+    path_ = path;
+
+    Result result;
+    result.success = true;
+    return result;
+  }
+
+  void Run() {
+    while (listen_fd_ >= 0) {
+      pollfd fds[] = {{listen_fd_, POLLIN, 0}, {wake_[0], POLLIN, 0}};
+      if (poll(fds, 2, -1) < 0) {
+        if (errno == EINTR) continue;
+        break;
+      }
+      if (fds[1].revents != 0) {
+        char drained[16];
+        while (read(wake_[0], drained, sizeof(drained)) > 0) {
+        }
+        break;
+      }
+      Reap(false);
+      if (fds[0].revents & POLLIN) {
+        if (const int fd = accept4(listen_fd_, nullptr, nullptr, SOCK_CLOEXEC); fd >= 0) {
+          if (clients_.size() >= kMaxClients || !SameUser(fd)) {
+            close(fd);
+            continue;
+          }
+          auto client = std::make_unique<Client>();
+          client->fd = fd;
+          client->thread = std::thread([this, raw = client.get()]() {
+            Serve(raw->fd);
+            raw->done = true;
+          });
+          clients_.push_back(std::move(client));
+        }
+      }
+    }
+
+    // Wakes the threads waiting for a request; one busy with a request answers it first
+    for (const auto& client : clients_) {
+      shutdown(client->fd, SHUT_RDWR);
+    }
+    Reap(true);
+  }
+
+  void Stop() {
+    if (wake_[1] >= 0) {
+      const char byte = 0;
+      [[maybe_unused]] const ssize_t written = write(wake_[1], &byte, 1);
+    }
+  }
+
+ private:
+  struct Client {
+    int fd{-1};
+    std::thread thread;
+    std::atomic<bool> done{false};
+  };
+
+  // Backs up the socket mode, which a later chmod of the socket file could widen
+  static bool SameUser(int fd) {
+    ucred credentials{};
+    socklen_t size = sizeof(credentials);
+    return getsockopt(fd, SOL_SOCKET, SO_PEERCRED, &credentials, &size) == 0 && credentials.uid == geteuid();
+  }
+
+  // Joins finished client threads, or all of them. The fd is closed only after
+  // the join so that Run never shuts down a number the kernel has reused.
+  void Reap(bool all) {
+    for (auto it = clients_.begin(); it != clients_.end();) {
+      if (!all && !(*it)->done) {
+        ++it;
+        continue;
+      }
+      (*it)->thread.join();
+      close((*it)->fd);
+      it = clients_.erase(it);
+    }
+  }
+
+  void Serve(int fd) {
+    std::string request;
+    while (ReceiveFrame(fd, &request, kMaxRequestSize)) {
+      FrameWriter response;
+      Handle(request, response);
+      if (!SendAll(fd, response.Finish())) {
+        break;
+      }
+    }
+  }
+
+  void Handle(const std::string& payload, FrameWriter& response) {
+    FrameReader reader(payload);
+    uint8_t version = 0;
+    uint8_t operation = 0;
+    if (!reader.Get(&version) || version != kProtocolVersion || !reader.Get(&operation)) {
+      PutResult(response, MakeErrorResult(ErrorCode::DaemonRequestRejected, "Unsupported bled protocol version"));
+      return;
+    }
+    if (static_cast<Operation>(operation) == Operation::GetPairedDevices) {
+      PutDevices(response, session_.GetPairedDevices());
+      return;
+    }
+
+    std::string mac_address;
+    std::string adapter;
+    int64_t argument = 0;
+    if (!reader.GetString(&mac_address) || !reader.GetString(&adapter) || !reader.Get(&argument)) {
+      PutResult(response, MakeErrorResult(ErrorCode::DaemonRequestRejected, "Malformed bled request"));
+      return;
+    }
+    // Checked before any arithmetic, so a hostile value can neither truncate nor overflow
+    const bool deadline = static_cast<Operation>(operation) == Operation::ScanAndPair;
+    if (deadline ? argument < 0 || argument > kMaxDeadlineMs
+                 : argument < kMinTimeoutSeconds || argument > kMaxTimeoutSeconds) {
+      PutResult(response, MakeErrorResult(ErrorCode::DaemonRequestRejected,
+                                          deadline ? "Deadline out of range in bled request"
+                                                   : "Timeout out of range in bled request"));
+      return;
+    }
+    const DeviceAddress device(std::move(mac_address), std::move(adapter));
+    const int timeout_seconds = static_cast<int>(argument);
+    switch (static_cast<Operation>(operation)) {
+      case Operation::PairDevice:
+        PutResult(response, session_.PairDevice(device, timeout_seconds));
+        break;
+      case Operation::ScanAndPair:
+        PutResult(response, ScanAndPair(session_, device,
+                                        std::chrono::steady_clock::now() + std::chrono::milliseconds(argument)));
+        break;
+      case Operation::ConnectDevice:
+        PutResult(response, session_.ConnectDevice(device, timeout_seconds));
+        break;
+      case Operation::DisconnectDevice:
+        PutResult(response, session_.DisconnectDevice(device, timeout_seconds));
+        break;
+      default:
+        PutResult(response, MakeErrorResult(ErrorCode::DaemonRequestRejected, "Unknown bled operation"));
+        break;
+    }
+  }
+
+  Session& session_;
+  std::string path_;
+  int listen_fd_{-1};
+  int wake_[2]{-1, -1};
+  std::vector<std::unique_ptr<Client>> clients_;  // Run's thread only
+};
+
+DaemonServer::DaemonServer(Session& session) : impl_(std::make_unique<Impl>(session)) {}
+
+DaemonServer::~DaemonServer() = default;
+
+Result DaemonServer::Listen(const std::string& path) { return impl_->Listen(path); }
+
+void DaemonServer::Run() { impl_->Run(); }
+
+void DaemonServer::Stop() { impl_->Stop(); }
+
+class DaemonClient::Impl {
+ public:
+  explicit Impl(const std::string& path) : fd_(ConnectSocket(path)) {}
+
+  ~Impl() {
+    if (fd_ >= 0) close(fd_);
+  }
+
+  bool connected() const { return fd_ >= 0; }
+
+  DeviceQueryResult GetPairedDevices() {
+    FrameWriter request;
+    request.Put(kProtocolVersion);
+    request.Put(Operation::GetPairedDevices);
+
+    std::string response;
+    DeviceQueryResult result;
+    if (!Call(request, &response)) {
+      return ErrorDevices("Lost connection to bled");
+    }
+    FrameReader reader(response);
+    if (!GetDevices(reader, &result)) {
+      return ErrorDevices("Malformed response from bled");
+    }
+    return result;
+  }
+
+  Result DeviceCall(Operation operation, const DeviceAddress& device, int64_t argument) {
+    FrameWriter request;
+    request.Put(kProtocolVersion);
+    request.Put(operation);
+    request.PutString(device.mac_address);
+    request.PutString(device.adapter);
+    request.Put(argument);
+
+    std::string response;
+    Result result;
+    if (!Call(request, &response)) {
+      return MakeErrorResult(ErrorCode::DaemonUnavailable, "Lost connection to bled");
+    }
+    FrameReader reader(response);
+    if (!GetResult(reader, &result)) {
+      return MakeErrorResult(ErrorCode::DaemonUnavailable, "Malformed response from bled");
+    }
+    return result;
+  }
+
+ private:
+  bool Call(FrameWriter& request, std::string* response) {
+    if (fd_ < 0) {
+      return false;
+    }
+    if (!SendAll(fd_, request.Finish()) || !ReceiveFrame(fd_, response, kMaxResponseSize)) {
+      close(fd_);
+      fd_ = -1;
+      return false;
+    }
+    return true;
+  }
+
+  static DeviceQueryResult ErrorDevices(const std::string& message) {
+    DeviceQueryResult result;
+    result.error_code = static_cast<int>(ErrorCode::DaemonUnavailable);
+    result.error_message = message;
+    return result;
+  }
+
+  int fd_;
+};
+
+DaemonClient::DaemonClient(const std::string& path) : impl_(std::make_unique<Impl>(path)) {}
+
+DaemonClient::~DaemonClient() = default;
+
+bool DaemonClient::connected() const { return impl_->connected(); }
+
+DeviceQueryResult DaemonClient::GetPairedDevices() { return impl_->GetPairedDevices(); }
+
+Result DaemonClient::PairDevice(const DeviceAddress& device, int timeout_seconds) {
+  return impl_->DeviceCall(Operation::PairDevice, device, timeout_seconds);
+}
+
+Result DaemonClient::ScanAndPair(const DeviceAddress& device, std::chrono::steady_clock::time_point deadline) {
+  const auto left =
+      std::chrono::duration_cast<std::chrono::milliseconds>(deadline - std::chrono::steady_clock::now());
+  // A deadline already passed still gets its one pairing attempt, as with ble::ScanAndPair
+  return impl_->DeviceCall(Operation::ScanAndPair, device, std::max<int64_t>(0, left.count()));
+}
+
+Result DaemonClient::ConnectDevice(const DeviceAddress& device, int timeout_seconds) {
+  return impl_->DeviceCall(Operation::ConnectDevice, device, timeout_seconds);
+}
+
+Result DaemonClient::DisconnectDevice(const DeviceAddress& device, int timeout_seconds) {
+  return impl_->DeviceCall(Operation::DisconnectDevice, device, timeout_seconds);
+}
+
+}  // namespace ble
@@ -0,0 +1,396 @@
+// MIT License
+// Copyright (c) 2025 pezy
+
+#include "device_cache_impl.hpp"
+
+// std
+#include <iterator>
+#include <memory>
+#include <utility>
+
+#include "session_impl.hpp"
+
+namespace ble {
+
+using internal::CachedDevice;
+using internal::GObjectWrapper;
+using internal::ScopedTimer;
+
+namespace {
+
+// Whether GetPairedDevices reports the device
+bool Listed(const CachedDevice& cached) { return cached.paired && !cached.device.mac_address.empty(); }
+
+bool SameDevice(const BluetoothDevice& a, const BluetoothDevice& b) {
+  return a.mac_address == b.mac_address && a.device_name == b.device_name && a.device_class == b.device_class &&
+         a.rssi == b.rssi && a.connected == b.connected && a.adapter == b.adapter;
+}
+
+}  // anonymous namespace
+
+DeviceCache::Impl::Impl(Session::Impl& session) : session_(session) {
+  GError* error = nullptr;
+  GDBusConnection* connection = session_.AcquireConnection(&error);
+  if (!connection) {
+    // Stays unsynced, queries keep going to the bus
+    if (error) g_error_free(error);
+    return;
+  }
+  connection_ = GObjectWrapper::make_dbus_connection(connection);
+
+  // Subscribing first means no delta between the snapshot and the first signal is lost
+  session_.RunOnLoop([this]() {
+    Subscribe();
+    Load();
+  });
+
+  std::unique_lock<std::mutex> lock(loads_mutex_);
+  loads_done_.wait(lock, [this]() { return pending_loads_ == 0; });
+}
+
+DeviceCache::Impl::~Impl() {
+  if (connection_) {
+    session_.RunOnLoop([this]() { Unsubscribe(); });
+  }
+
+  // A cancelled load still completes on the loop thread; wait for its callback
+  g_cancellable_cancel(cancellable_);
+  {
+    std::unique_lock<std::mutex> lock(loads_mutex_);
+    loads_done_.wait(lock, [this]() { return pending_loads_ == 0; });
+  }
+  g_object_unref(cancellable_);
+}
+
+bool DeviceCache::Impl::GetPairedDevices(DeviceQueryResult* result) {
+  // The session re-opens a dropped connection, but our subscriptions died with the old one
+  if (!connection_ || g_dbus_connection_is_closed(connection_.get())) {
+    return false;
+  }
+
+  std::lock_guard<std::mutex> lock(mutex_);
+  if (!synced_) {
+    return false;
+  }
+  result->devices.clear();
+  for (const auto& [path, cached] : devices_) {
+    if (Listed(cached)) {
+      result->devices.push_back(cached.device);
+    }
+  }
+  // devices_ is unordered; the bus answers in object path order
+  internal::SortByObjectPath(result->devices.begin(), result->devices.end());
+  result->success = true;
+  result->error_code = static_cast<int>(ErrorCode::Success);
+  result->error_message.clear();
+  return true;
+}
+
+bool DeviceCache::Impl::IsDevicePaired(const std::string& mac_address, const std::string& adapter, bool* paired) {
+  if (!connection_ || g_dbus_connection_is_closed(connection_.get())) {
+    return false;
+  }
+
+  const auto packed = internal::PackMacAddress(mac_address);
+  std::lock_guard<std::mutex> lock(mutex_);
+  if (!synced_) {
+    return false;
+  }
+  if (!packed) {
+    *paired = false;
+    return true;
+  }
+  // The same MAC appears once per adapter that knows it
+  *paired = false;
+  auto [first, last] = devices_by_mac_.equal_range(*packed);
+  for (auto it = first; it != last; ++it) {
+    if (it->second->device.adapter == adapter) {
+      *paired = it->second->paired;
+      break;
+    }
+  }
+  return true;
+}
+
+bool DeviceCache::Impl::synced() {
+  if (!connection_ || g_dbus_connection_is_closed(connection_.get())) {
+    return false;
+  }
+  std::lock_guard<std::mutex> lock(mutex_);
+  return synced_;
+}
+
+bool DeviceCache::Impl::TakeChanges(std::vector<DeviceChange>* changes) {
+  if (!connection_ || g_dbus_connection_is_closed(connection_.get())) {
+    return false;
+  }
+
+  std::lock_guard<std::mutex> lock(mutex_);
+  if (!synced_) {
+    return false;
+  }
+  tracking_ = true;
+  // Only the devices touched since the last call are looked at, however large the tree
+  for (auto& [path, before] : changed_) {
+    auto it = devices_.find(path);
+    const BluetoothDevice* now = it != devices_.end() && Listed(it->second) ? &it->second.device : nullptr;
+    if (before && !now) {
+      changes->push_back({DeviceChange::Kind::Removed, std::move(*before), std::nullopt});
+    } else if (!before && now) {
+      changes->push_back({DeviceChange::Kind::Added, *now, std::nullopt});
+    } else if (before && now && !SameDevice(*before, *now)) {
+      changes->push_back({DeviceChange::Kind::Changed, *now, std::move(before)});
+    }
+  }
+  changed_.clear();
+  return true;
+}
+
+void DeviceCache::Impl::Subscribe() {
+  GDBusConnection* connection = connection_.get();
+  interfaces_added_id_ = g_dbus_connection_signal_subscribe(
+      connection, "org.bluez", "org.freedesktop.DBus.ObjectManager", "InterfacesAdded", nullptr, nullptr,
+      G_DBUS_SIGNAL_FLAGS_NONE, &Impl::OnInterfacesAdded, this, nullptr);
+  interfaces_removed_id_ = g_dbus_connection_signal_subscribe(
+      connection, "org.bluez", "org.freedesktop.DBus.ObjectManager", "InterfacesRemoved", nullptr, nullptr,
+      G_DBUS_SIGNAL_FLAGS_NONE, &Impl::OnInterfacesRemoved, this, nullptr);
+  properties_changed_id_ = g_dbus_connection_signal_subscribe(
+      connection, "org.bluez", "org.freedesktop.DBus.Properties", "PropertiesChanged", nullptr, "org.bluez.Device1",
+      G_DBUS_SIGNAL_FLAGS_NONE, &Impl::OnPropertiesChanged, this, nullptr);
+  name_owner_changed_id_ = g_dbus_connection_signal_subscribe(
+      connection, "org.freedesktop.DBus", "org.freedesktop.DBus", "NameOwnerChanged", "/org/freedesktop/DBus",
+      "org.bluez", G_DBUS_SIGNAL_FLAGS_NONE, &Impl::OnNameOwnerChanged, this, nullptr);
+}
+
+void DeviceCache::Impl::Unsubscribe() {
+  GDBusConnection* connection = connection_.get();
+  g_dbus_connection_signal_unsubscribe(connection, interfaces_added_id_);
+  g_dbus_connection_signal_unsubscribe(connection, interfaces_removed_id_);
+  g_dbus_connection_signal_unsubscribe(connection, properties_changed_id_);
+  g_dbus_connection_signal_unsubscribe(connection, name_owner_changed_id_);
+}
+
+void DeviceCache::Impl::Load() {
+  {
+    std::lock_guard<std::mutex> lock(loads_mutex_);
+    ++pending_loads_;
+  }
+  g_dbus_connection_call(connection_.get(), "org.bluez", "/", "org.freedesktop.DBus.ObjectManager",
+                         "GetManagedObjects", nullptr, G_VARIANT_TYPE("(a{oa{sa{sv}}})"), G_DBUS_CALL_FLAGS_NONE,
+                         -1,  // Default timeout
+                         cancellable_, &Impl::OnObjectsReply, this);
+}
+
+void DeviceCache::Impl::Invalidate() {
+  std::lock_guard<std::mutex> lock(mutex_);
+  for (const auto& [path, cached] : devices_) {
+    MarkChangedLocked(path);
+  }
+  synced_ = false;
+  devices_by_mac_.clear();
+  devices_.clear();
+}
+
+void DeviceCache::Impl::IndexLocked(CachedDevice* cached) {
+  if (auto packed = internal::PackMacAddress(cached->device.mac_address)) {
+    devices_by_mac_.emplace(*packed, cached);
+  }
+}
+
+void DeviceCache::Impl::MarkChangedLocked(const std::string& path) {
+  if (!tracking_ || changed_.count(path) != 0) {
+    return;
+  }
+  auto it = devices_.find(path);
+  changed_.emplace(path, it != devices_.end() && Listed(it->second) ? std::optional(it->second.device) : std::nullopt);
+}
+
+void DeviceCache::Impl::EraseLocked(std::unordered_map<std::string, CachedDevice>::iterator it) {
+  if (auto packed = internal::PackMacAddress(it->second.device.mac_address)) {
+    auto [first, last] = devices_by_mac_.equal_range(*packed);
+    for (auto indexed = first; indexed != last; ++indexed) {
+      if (indexed->second == &it->second) {
+        devices_by_mac_.erase(indexed);
+        break;
+      }
+    }
+  }
+  devices_.erase(it);
+}
+
+// Signals dispatched before the reply are already reflected in it, so the snapshot simply replaces the map
+void DeviceCache::Impl::OnObjectsReply(GObject* source, GAsyncResult* res, gpointer user_data) {
+  auto* impl = static_cast<Impl*>(user_data);
+  GError* error = nullptr;
+  GVariant* objects_result = g_dbus_connection_call_finish(G_DBUS_CONNECTION(source), res, &error);
+
+  if (objects_result) {
+    auto objects_result_wrapper = GObjectWrapper::make_variant(objects_result);
+    std::unordered_map<std::string, CachedDevice> devices;
+    internal::ForEachDevice(objects_result_wrapper.get(), [&devices](const char* object_path, GVariant* properties) {
+      CachedDevice& cached = devices[object_path];
+      cached.device.adapter = internal::AdapterFromObjectPath(object_path);
+      internal::ApplyDeviceProperties(properties, &cached);
+    });
+
+    std::lock_guard<std::mutex> lock(impl->mutex_);
+    // The old map is empty after Invalidate, which marked its devices already
+    for (const auto& [path, cached] : impl->devices_) {
+      impl->MarkChangedLocked(path);
+    }
+    for (const auto& [path, cached] : devices) {
+      impl->MarkChangedLocked(path);
+    }
+    impl->devices_ = std::move(devices);
+    impl->devices_by_mac_.clear();
+    for (auto& [path, cached] : impl->devices_) {
+      impl->IndexLocked(&cached);
+    }
+    impl->synced_ = true;
+  }
+  if (error) g_error_free(error);
+
+  std::lock_guard<std::mutex> lock(impl->loads_mutex_);
+  if (--impl->pending_loads_ == 0) {
+    impl->loads_done_.notify_all();
+  }
+}
+
+void DeviceCache::Impl::OnInterfacesAdded(GDBusConnection*, const gchar*, const gchar*, const gchar*, const gchar*,
+                                          GVariant* parameters, gpointer user_data) {
+  auto* impl = static_cast<Impl*>(user_data);
+  const char* object_path = nullptr;
+  GVariant* interfaces = nullptr;
+  g_variant_get(parameters, "(&o@a{sa{sv}})", &object_path, &interfaces);
+  auto interfaces_wrapper = GObjectWrapper::make_variant(interfaces);
+
+  auto properties =
+      GObjectWrapper::make_variant(g_variant_lookup_value(interfaces, "org.bluez.Device1", G_VARIANT_TYPE_VARDICT));
+  if (!properties) {
+    return;
+  }
+
+  CachedDevice cached;
+  cached.device.adapter = internal::AdapterFromObjectPath(object_path);
+  internal::ApplyDeviceProperties(properties.get(), &cached);
+
+  std::lock_guard<std::mutex> lock(impl->mutex_);
+  if (!impl->synced_) {
+    return;
+  }
+  impl->MarkChangedLocked(object_path);
+  auto existing = impl->devices_.find(object_path);
+  if (existing != impl->devices_.end()) {
+    impl->EraseLocked(existing);
+  }
+  auto [it, inserted] = impl->devices_.emplace(object_path, std::move(cached));
+  impl->IndexLocked(&it->second);
+}
+
+void DeviceCache::Impl::OnInterfacesRemoved(GDBusConnection*, const gchar*, const gchar*, const gchar*, const gchar*,
+                                            GVariant* parameters, gpointer user_data) {
+  auto* impl = static_cast<Impl*>(user_data);
+  const char* object_path = nullptr;
+  GVariantIter* interfaces_iter = nullptr;
+  g_variant_get(parameters, "(&oas)", &object_path, &interfaces_iter);
+  auto interfaces_iter_wrapper = GObjectWrapper::make_variant_iter(interfaces_iter);
+
+  const std::string removed_path = object_path;
+  const char* interface_name;
+  std::lock_guard<std::mutex> lock(impl->mutex_);
+  while (g_variant_iter_loop(interfaces_iter_wrapper.get(), "&s", &interface_name)) {
+    if (g_strcmp0(interface_name, "org.bluez.Device1") == 0) {
+      auto it = impl->devices_.find(removed_path);
+      if (it != impl->devices_.end()) {
+        impl->MarkChangedLocked(removed_path);
+        impl->EraseLocked(it);
+      }
+    } else if (g_strcmp0(interface_name, "org.bluez.Adapter1") == 0) {
+      const std::string prefix = removed_path + "/";
+      for (auto it = impl->devices_.begin(); it != impl->devices_.end();) {
+        auto next = std::next(it);
+        if (it->first.rfind(prefix, 0) == 0) {
+          impl->MarkChangedLocked(it->first);
+          impl->EraseLocked(it);
+        }
+        it = next;
+      }
+    }
+  }
+}
+
+void DeviceCache::Impl::OnPropertiesChanged(GDBusConnection*, const gchar*, const gchar* object_path, const gchar*,
+                                            const gchar*, GVariant* parameters, gpointer user_data) {
+  auto* impl = static_cast<Impl*>(user_data);
+  GVariant* changed = nullptr;
+  GVariantIter* invalidated_iter = nullptr;
+  g_variant_get(parameters, "(&s@a{sv}as)", nullptr, &changed, &invalidated_iter);
+  auto changed_wrapper = GObjectWrapper::make_variant(changed);
+  auto invalidated_iter_wrapper = GObjectWrapper::make_variant_iter(invalidated_iter);
+
+  std::lock_guard<std::mutex> lock(impl->mutex_);
+  auto it = impl->devices_.find(object_path);
+  if (!impl->synced_ || it == impl->devices_.end()) {
+    return;
+  }
+  impl->MarkChangedLocked(it->first);
+  internal::ApplyDeviceProperties(changed, &it->second);
+
+  // BlueZ invalidates the optional properties when they go away, e.g. RSSI once a scan ends
+  const char* property_name;
+  while (g_variant_iter_loop(invalidated_iter_wrapper.get(), "&s", &property_name)) {
+    if (g_strcmp0(property_name, "Name") == 0) {
+      it->second.device.device_name.reset();
+    } else if (g_strcmp0(property_name, "Class") == 0) {
+      it->second.device.device_class.reset();
+    } else if (g_strcmp0(property_name, "RSSI") == 0) {
+      it->second.device.rssi.reset();
+    }
+  }
+}
+
+// bluetoothd restarted or exited: drop the mirror, and reload it once the name has a new owner
+void DeviceCache::Impl::OnNameOwnerChanged(GDBusConnection*, const gchar*, const gchar*, const gchar*, const gchar*,
+                                           GVariant* parameters, gpointer user_data) {
+  auto* impl = static_cast<Impl*>(user_data);
+  const char* new_owner = nullptr;
+  g_variant_get(parameters, "(&s&s&s)", nullptr, nullptr, &new_owner);
+
+  impl->Invalidate();
+  if (new_owner && *new_owner) {
+    impl->Load();
+  }
+}
+
+DeviceCache::DeviceCache(Session& session) : session_(session), impl_(std::make_unique<Impl>(session.impl())) {
+  session_.impl().AttachDeviceCache(impl_.get());
+}
+
+DeviceCache::~DeviceCache() { session_.impl().DetachDeviceCache(impl_.get()); }
+
+DeviceQueryResult DeviceCache::GetPairedDevices() {
+  DeviceQueryResult result;
+  ScopedTimer timer(result.query_time);
+  if (impl_->GetPairedDevices(&result)) {
+    return result;
+  }
+  return session_.GetPairedDevices();
+}
+
+bool DeviceCache::IsDevicePaired(const DeviceAddress& device) {
+  bool paired = false;
+  if (impl_->IsDevicePaired(device.mac_address, session_.impl().ResolveAdapter(device), &paired)) {
+    return paired;
+  }
+  return session_.IsDevicePaired(device);
+}
+
+bool DeviceCache::synced() const { return impl_->synced(); }
+
+std::vector<DeviceChange> DeviceCache::TakeChanges() {
+  std::vector<DeviceChange> changes;
+  impl_->TakeChanges(&changes);
+  return changes;
+}
+
+}  // namespace ble
@@ -0,0 +1,123 @@
+// MIT License
+// Copyright (c) 2025 pezy
+
+#pragma once
+
+#include <bluetooth/device_cache.hpp>
+
+// std
+#include <condition_variable>
+#include <cstdint>
+#include <mutex>
+#include <optional>
+#include <string>
+#include <unordered_map>
+#include <vector>
+
+#include "bluez_utils.hpp"
+
+namespace ble {
+
+namespace internal {
+
+// Device1 state mirrored from BlueZ
+struct CachedDevice {
+  BluetoothDevice device{};
+  bool paired{false};
+};
+
+// Applies the Device1 properties present in an a{sv} dictionary, leaving the others untouched
+inline void ApplyDeviceProperties(GVariant* properties, CachedDevice* cached) {
+  std::string mac_address = ExtractMacAddress(properties);
+  if (!mac_address.empty()) {
+    cached->device.mac_address = mac_address;
+  }
+  if (auto name = ExtractDeviceName(properties)) {
+    cached->device.device_name = name;
+  }
+  if (auto device_class = ExtractDeviceClass(properties)) {
+    cached->device.device_class = device_class;
+  }
+  if (auto rssi = ExtractRssi(properties)) {
+    cached->device.rssi = rssi;
+  }
+  auto connected =
+      GObjectWrapper::make_variant(g_variant_lookup_value(properties, "Connected", G_VARIANT_TYPE_BOOLEAN));
+  if (connected) {
+    cached->device.connected = g_variant_get_boolean(connected.get());
+  }
+  auto paired = GObjectWrapper::make_variant(g_variant_lookup_value(properties, "Paired", G_VARIANT_TYPE_BOOLEAN));
+  if (paired) {
+    cached->paired = g_variant_get_boolean(paired.get());
+  }
+}
+
+}  // namespace internal
+
+class DeviceCache::Impl {
+ public:
+  explicit Impl(Session::Impl& session);
+  ~Impl();
+
+  // Fills result from memory; returns false while the cache is not synced
+  bool GetPairedDevices(DeviceQueryResult* result);
+
+  // Looks the device up by packed MAC and adapter; returns false while the cache is not synced
+  bool IsDevicePaired(const std::string& mac_address, const std::string& adapter, bool* paired);
+
+  bool synced();
+
+  // Fills changes with the net changes since the previous call; returns false while the cache is not synced
+  bool TakeChanges(std::vector<DeviceChange>* changes);
+
+ private:
+  // Loop thread only
+  void Subscribe();
+  void Unsubscribe();
+  void Load();
+  void Invalidate();
+
+  // mutex_ held
+  void IndexLocked(internal::CachedDevice* cached);
+  void EraseLocked(std::unordered_map<std::string, internal::CachedDevice>::iterator it);
+  // Remembers how the device at path was listed before its first change since the last TakeChanges
+  void MarkChangedLocked(const std::string& path);
+
+  static void OnObjectsReply(GObject* source, GAsyncResult* res, gpointer user_data);
+  static void OnInterfacesAdded(GDBusConnection* connection, const gchar* sender_name, const gchar* object_path,
+                                const gchar* interface_name, const gchar* signal_name, GVariant* parameters,
+                                gpointer user_data);
+  static void OnInterfacesRemoved(GDBusConnection* connection, const gchar* sender_name, const gchar* object_path,
+                                  const gchar* interface_name, const gchar* signal_name, GVariant* parameters,
+                                  gpointer user_data);
+  static void OnPropertiesChanged(GDBusConnection* connection, const gchar* sender_name, const gchar* object_path,
+                                  const gchar* interface_name, const gchar* signal_name, GVariant* parameters,
+                                  gpointer user_data);
+  static void OnNameOwnerChanged(GDBusConnection* connection, const gchar* sender_name, const gchar* object_path,
+                                 const gchar* interface_name, const gchar* signal_name, GVariant* parameters,
+                                 gpointer user_data);
+
+  Session::Impl& session_;
+  internal::GObjectWrapper::DBusConnection connection_{internal::GObjectWrapper::make_dbus_connection(nullptr)};
+  GCancellable* cancellable_{g_cancellable_new()};
+
+  std::mutex mutex_;  // guards devices_, devices_by_mac_, synced_, tracking_ and changed_
+  std::unordered_map<std::string, internal::CachedDevice> devices_;  // by object path
+  std::unordered_multimap<uint64_t, internal::CachedDevice*> devices_by_mac_;  // by packed MAC, into devices_
+  bool synced_{false};
+  bool tracking_{false};  // set by the first TakeChanges
+  // Devices changed since the last TakeChanges, by object path, with how they were listed then (nullopt: not listed)
+  std::unordered_map<std::string, std::optional<BluetoothDevice>> changed_;
+
+  std::mutex loads_mutex_;  // guards pending_loads_
+  std::condition_variable loads_done_;
+  size_t pending_loads_{0};
+
+  // Only touched on the loop thread
+  guint interfaces_added_id_{0};
+  guint interfaces_removed_id_{0};
+  guint properties_changed_id_{0};
+  guint name_owner_changed_id_{0};
+};
+
+}  // namespace ble
@@ -0,0 +1,342 @@
+// MIT License
+// Copyright (c) 2025 pezy
+
+#include <bluetooth/discovery.hpp>
+
+// std
+#include <algorithm>
+#include <future>
+#include <memory>
+#include <utility>
+
+#include "session_impl.hpp"
+
+namespace ble {
+
+using internal::GObjectWrapper;
+using internal::kAdapterTimeoutSeconds;
+using internal::MakeErrorResult;
+using internal::ScopedTimer;
+
+namespace {
+
+// Waits for InterfacesAdded of one object path; only touched on the loop thread
+struct ObjectWatch {
+  std::string object_path;
+  std::promise<void> added;
+  bool fired{false};
+};
+
+void OnInterfacesAdded(GDBusConnection*, const gchar*, const gchar*, const gchar*, const gchar*, GVariant* parameters,
+                       gpointer user_data) {
+  auto* watch = static_cast<ObjectWatch*>(user_data);
+  const char* object_path = nullptr;
+  GVariant* interfaces = nullptr;
+  g_variant_get(parameters, "(&o@a{sa{sv}})", &object_path, &interfaces);
+  auto interfaces_wrapper = GObjectWrapper::make_variant(interfaces);
+
+  if (watch->fired || watch->object_path != object_path) {
+    return;
+  }
+  auto properties =
+      GObjectWrapper::make_variant(g_variant_lookup_value(interfaces, "org.bluez.Device1", G_VARIANT_TYPE_VARDICT));
+  if (properties) {
+    watch->fired = true;
+    watch->added.set_value();
+  }
+}
+
+bool ObjectExists(GDBusConnection* connection, const std::string& object_path) {
+  GError* error = nullptr;
+  GVariant* reply = g_dbus_connection_call_sync(
+      connection, "org.bluez", object_path.c_str(), "org.freedesktop.DBus.Properties", "Get",
+      g_variant_new("(ss)", "org.bluez.Device1", "Address"), G_VARIANT_TYPE("(v)"), G_DBUS_CALL_FLAGS_NONE,
+      kAdapterTimeoutSeconds * 1000, nullptr, &error);
+  if (!reply) {
+    if (error) g_error_free(error);
+    return false;
+  }
+  g_variant_unref(reply);
+  return true;
+}
+
+const char* TransportName(DiscoveryTransport transport) {
+  switch (transport) {
+    case DiscoveryTransport::LowEnergy:
+      return "le";
+    case DiscoveryTransport::BrEdr:
+      return "bredr";
+    default:
+      return "auto";
+  }
+}
+
+// Returns floating (a{sv}) parameters for SetDiscoveryFilter
+GVariant* FilterParameters(const DiscoveryFilter& filter) {
+  GVariantBuilder builder;
+  g_variant_builder_init(&builder, G_VARIANT_TYPE_VARDICT);
+  if (filter.rssi) {
+    g_variant_builder_add(&builder, "{sv}", "RSSI", g_variant_new_int16(*filter.rssi));
+  }
+  if (filter.pathloss) {
+    g_variant_builder_add(&builder, "{sv}", "Pathloss", g_variant_new_uint16(*filter.pathloss));
+  }
+  if (!filter.uuids.empty()) {
+    GVariantBuilder uuids;
+    g_variant_builder_init(&uuids, G_VARIANT_TYPE_STRING_ARRAY);
+    for (const auto& uuid : filter.uuids) {
+      g_variant_builder_add(&uuids, "s", uuid.c_str());
+    }
+    g_variant_builder_add(&builder, "{sv}", "UUIDs", g_variant_builder_end(&uuids));
+  }
+  g_variant_builder_add(&builder, "{sv}", "Transport", g_variant_new_string(TransportName(filter.transport)));
+  g_variant_builder_add(&builder, "{sv}", "DuplicateData", g_variant_new_boolean(filter.duplicate_data));
+  if (!filter.pattern.empty()) {
+    g_variant_builder_add(&builder, "{sv}", "Pattern", g_variant_new_string(filter.pattern.c_str()));
+  }
+  return g_variant_new("(a{sv})", &builder);
+}
+
+int64_t SteadyNowNs() {
+  return std::chrono::duration_cast<std::chrono::nanoseconds>(std::chrono::steady_clock::now().time_since_epoch())
+      .count();
+}
+
+}  // anonymous namespace
+
+class AdvertisementSubscription::Impl {
+ public:
+  Impl(Session::Impl& session, GDBusConnection* connection, AdvertisementCallback callback)
+      : session_(session),
+        connection_(GObjectWrapper::make_dbus_connection(connection)),
+        callback_(std::move(callback)) {
+    session_.RunOnLoop([this]() {
+      interfaces_added_id_ = g_dbus_connection_signal_subscribe(
+          connection_.get(), "org.bluez", "org.freedesktop.DBus.ObjectManager", "InterfacesAdded", nullptr, nullptr,
+          G_DBUS_SIGNAL_FLAGS_NONE, &Impl::OnInterfacesAdded, this, nullptr);
+      properties_changed_id_ = g_dbus_connection_signal_subscribe(
+          connection_.get(), "org.bluez", "org.freedesktop.DBus.Properties", "PropertiesChanged", nullptr,
+          "org.bluez.Device1", G_DBUS_SIGNAL_FLAGS_NONE, &Impl::OnPropertiesChanged, this, nullptr);
+    });
+  }
+
+  // Unsubscribing on the dispatching thread guarantees no callback runs afterwards
+  ~Impl() {
+    session_.RunOnLoop([this]() {
+      g_dbus_connection_signal_unsubscribe(connection_.get(), interfaces_added_id_);
+      g_dbus_connection_signal_unsubscribe(connection_.get(), properties_changed_id_);
+    });
+  }
+
+ private:
+  // The MAC comes from the object path, so building an event never allocates
+  static void OnInterfacesAdded(GDBusConnection*, const gchar*, const gchar*, const gchar*, const gchar*,
+                                GVariant* parameters, gpointer user_data) {
+    auto* impl = static_cast<Impl*>(user_data);
+    const char* object_path = nullptr;
+    GVariant* interfaces = nullptr;
+    g_variant_get(parameters, "(&o@a{sa{sv}})", &object_path, &interfaces);
+    auto interfaces_wrapper = GObjectWrapper::make_variant(interfaces);
+
+    const auto mac = internal::PackMacFromDevicePath(object_path);
+    auto properties =
+        GObjectWrapper::make_variant(g_variant_lookup_value(interfaces, "org.bluez.Device1", G_VARIANT_TYPE_VARDICT));
+    if (!mac || !properties) {
+      return;
+    }
+
+    AdvertisementEvent event{*mac, SteadyNowNs(), 0, AdvertisementEvent::kDeviceFound};
+    if (g_variant_lookup(properties.get(), "RSSI", "n", &event.rssi)) {
+      event.flags |= AdvertisementEvent::kRssi;
+    }
+    impl->callback_(event);
+  }
+
+  static void OnPropertiesChanged(GDBusConnection*, const gchar*, const gchar* object_path, const gchar*,
+                                  const gchar*, GVariant* parameters, gpointer user_data) {
+    auto* impl = static_cast<Impl*>(user_data);
+    const auto mac = internal::PackMacFromDevicePath(object_path);
+    if (!mac) {
+      return;
+    }
+
+    GVariant* changed = g_variant_get_child_value(parameters, 1);
+    auto changed_wrapper = GObjectWrapper::make_variant(changed);
+
+    AdvertisementEvent event{*mac, 0, 0, 0};
+    if (g_variant_lookup(changed, "RSSI", "n", &event.rssi)) {
+      event.flags |= AdvertisementEvent::kRssi;
+    }
+    GVariantIter iter;
+    g_variant_iter_init(&iter, changed);
+    const char* property_name;
+    while (g_variant_iter_next(&iter, "{&sv}", &property_name, nullptr)) {
+      if (g_strcmp0(property_name, "ManufacturerData") == 0 || g_strcmp0(property_name, "ServiceData") == 0) {
+        event.flags |= AdvertisementEvent::kAdvertisingData;
+      }
+    }
+    if (event.flags == 0) {
+      return;
+    }
+    event.timestamp_ns = SteadyNowNs();
+    impl->callback_(event);
+  }
+
+  Session::Impl& session_;
+  GObjectWrapper::DBusConnection connection_;
+  AdvertisementCallback callback_;
+
+  // Only touched on the loop thread
+  guint interfaces_added_id_{0};
+  guint properties_changed_id_{0};
+};
+
+AdvertisementSubscription::AdvertisementSubscription() = default;
+
+AdvertisementSubscription::AdvertisementSubscription(std::unique_ptr<Impl> impl) : impl_(std::move(impl)) {}
+
+AdvertisementSubscription::AdvertisementSubscription(AdvertisementSubscription&& other) noexcept = default;
+
+AdvertisementSubscription& AdvertisementSubscription::operator=(AdvertisementSubscription&& other) noexcept = default;
+
+AdvertisementSubscription::~AdvertisementSubscription() = default;
+
+Discovery::Discovery(Session& session, const std::string& adapter)
+    : session_(session),
+      adapter_path_(internal::AdapterObjectPath(adapter.empty() ? session.impl().default_adapter() : adapter)) {}
+
+Discovery::~Discovery() { Stop(); }
+
+Result Discovery::SetFilter(const DiscoveryFilter& filter) {
+  if (filter.rssi && filter.pathloss) {
+    return MakeErrorResult(ErrorCode::DiscoveryFailed, "RSSI and Pathloss filters are mutually exclusive");
+  }
+
+  std::lock_guard<std::mutex> lock(mutex_);
+  Result result{true, 0, "", std::chrono::milliseconds(0)};
+  if (active_) {
+    result = session_.impl().ChangeDiscoveryFilter(adapter_path_, filter_.has_value(), FilterParameters(filter));
+  }
+  if (!result.hasError()) {
+    filter_ = filter;
+  }
+  return result;
+}
+
+Result Discovery::ClearFilter() {
+  std::lock_guard<std::mutex> lock(mutex_);
+  Result result{true, 0, "", std::chrono::milliseconds(0)};
+  if (active_ && filter_) {
+    result = session_.impl().ChangeDiscoveryFilter(adapter_path_, true, nullptr);
+  }
+  if (!result.hasError()) {
+    filter_.reset();
+  }
+  return result;
+}
+
+Result Discovery::Start() {
+  std::lock_guard<std::mutex> lock(mutex_);
+  if (active_) {
+    return Result{true, 0, "", std::chrono::milliseconds(0)};
+  }
+
+  Result result = session_.impl().AcquireDiscovery(adapter_path_, filter_ ? FilterParameters(*filter_) : nullptr);
+  active_ = !result.hasError();
+  return result;
+}
+
+Result Discovery::Stop() {
+  std::lock_guard<std::mutex> lock(mutex_);
+  if (!active_) {
+    return Result{true, 0, "", std::chrono::milliseconds(0)};
+  }
+
+  active_ = false;
+  return session_.impl().ReleaseDiscovery(adapter_path_, filter_.has_value());
+}
+
+bool Discovery::active() const {
+  std::lock_guard<std::mutex> lock(mutex_);
+  return active_;
+}
+
+AdvertisementSubscription Discovery::Subscribe(AdvertisementCallback callback) {
+  GError* error = nullptr;
+  GDBusConnection* connection = session_.impl().AcquireConnection(&error);
+  if (!connection) {
+    if (error) g_error_free(error);
+    return AdvertisementSubscription();
+  }
+  return AdvertisementSubscription(
+      std::make_unique<AdvertisementSubscription::Impl>(session_.impl(), connection, std::move(callback)));
+}
+
+AdvertisementSubscription Discovery::Subscribe(AdvertisementRing& ring) {
+  return Subscribe([&ring](const AdvertisementEvent& event) { ring.TryPush(event); });
+}
+
+Result ScanAndPair(const DeviceAddress& device, std::chrono::steady_clock::time_point deadline) {
+  return ScanAndPair(Session::Default(), device, deadline);
+}
+
+Result ScanAndPair(Session& session, const DeviceAddress& device, std::chrono::steady_clock::time_point deadline) {
+  Result result;
+  ScopedTimer timer(result.operation_time);
+
+  Session::Impl& impl = session.impl();
+  if (const char* invalid = impl.CheckDeviceAddress(device)) {
+    result = MakeErrorResult(ErrorCode::DeviceNotFound, invalid);
+    return result;
+  }
+
+  GError* error = nullptr;
+  GDBusConnection* connection = impl.AcquireConnection(&error);
+  if (!connection) {
+    result = MakeErrorResult(ErrorCode::DBusConnectionFailed, error ? error->message : "Failed to connect to D-Bus");
+    if (error) g_error_free(error);
+    return result;
+  }
+
+  // RAII wrapper for connection
+  auto connection_wrapper = GObjectWrapper::make_dbus_connection(connection);
+
+  // Watch before looking, so a device found in between is not missed
+  ObjectWatch watch;
+  watch.object_path = impl.DevicePath(device);
+  const std::string adapter_path = internal::AdapterObjectPath(impl.ResolveAdapter(device));
+  auto added = watch.added.get_future();
+  guint subscription_id = 0;
+  impl.RunOnLoop([&]() {
+    subscription_id = g_dbus_connection_signal_subscribe(
+        connection, "org.bluez", "org.freedesktop.DBus.ObjectManager", "InterfacesAdded", nullptr, nullptr,
+        G_DBUS_SIGNAL_FLAGS_NONE, &OnInterfacesAdded, &watch, nullptr);
+  });
+
+  bool found = ObjectExists(connection, watch.object_path);
+  if (!found) {
+    result = impl.AcquireDiscovery(adapter_path);
+    if (!result.hasError()) {
+      found = added.wait_until(deadline) == std::future_status::ready;
+      // Not waiting for the reply lets Pair go out right behind it
+      impl.ReleaseDiscovery(adapter_path, false, false);
+      if (!found) {
+        result = MakeErrorResult(ErrorCode::DeviceNotFound, "Device not found before the deadline");
+      }
+    }
+  }
+
+  impl.RunOnLoop(
+      [connection, subscription_id]() { g_dbus_connection_signal_unsubscribe(connection, subscription_id); });
+  if (!found) {
+    return result;
+  }
+
+  // Whole seconds left for Pair, at least one even when the scan used up the deadline
+  const auto remaining = std::chrono::ceil<std::chrono::seconds>(deadline - std::chrono::steady_clock::now());
+  const int timeout_seconds = std::max(1, static_cast<int>(remaining.count()));
+  result = session.PairDevice(device, timeout_seconds);
+  return result;
+}
+
+}  // namespace ble
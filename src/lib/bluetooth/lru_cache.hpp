@@ -0,0 +1,88 @@
+// MIT License
+// Copyright (c) 2025 pezy
+
+#pragma once
+
+#include <cstddef>
+#include <list>
+#include <unordered_map>
+#include <utility>
+
+namespace ble::internal {
+
+// Fixed-capacity least-recently-used map. Not thread-safe; callers lock.
+template <typename Key, typename Value>
+class LruCache {
+ public:
+  explicit LruCache(size_t capacity) : capacity_(capacity) {}
+
+  // Returns the cached value and marks it most recently used, or nullptr
+  Value* Get(const Key& key) {
+    auto it = index_.find(key);
+    if (it == index_.end()) {
+      return nullptr;
+    }
+    entries_.splice(entries_.begin(), entries_, it->second);
+    return &it->second->second;
+  }
+
+  // Inserts or replaces a value, evicting the least recently used entry when full
+  void Put(const Key& key, Value value) {
+    if (capacity_ == 0) {
+      return;
+    }
+
+    auto it = index_.find(key);
+    if (it != index_.end()) {
+      it->second->second = std::move(value);
+      entries_.splice(entries_.begin(), entries_, it->second);
+      return;
+    }
+
+    entries_.emplace_front(key, std::move(value));
+    index_[key] = entries_.begin();
+    if (entries_.size() > capacity_) {
+      index_.erase(entries_.back().first);
+      entries_.pop_back();
+    }
+  }
+
+  bool Erase(const Key& key) {
+    auto it = index_.find(key);
+    if (it == index_.end()) {
+      return false;
+    }
+    entries_.erase(it->second);
+    index_.erase(it);
+    return true;
+  }
+
+  // Erases every entry whose key satisfies pred
+  template <typename Predicate>
+  void EraseIf(Predicate pred) {
+    for (auto it = entries_.begin(); it != entries_.end();) {
+      if (pred(it->first)) {
+        index_.erase(it->first);
+        it = entries_.erase(it);
+      } else {
+        ++it;
+      }
+    }
+  }
+
+  void Clear() {
+    index_.clear();
+    entries_.clear();
+  }
+
+  size_t size() const { return entries_.size(); }
+
+ private:
+  using Entry = std::pair<Key, Value>;
+
+  const size_t capacity_;
+  std::list<Entry> entries_;
+  std::unordered_map<Key, typename std::list<Entry>::iterator> index_;
+};
+
+}  // namespace ble::internal
@@ -0,0 +1,47 @@
+// MIT License
+// Copyright (c) 2025 pezy
+
+#include <bluetooth/retry.hpp>
+
+// std
+#include <algorithm>
+#include <cmath>
+#include <random>
+
+namespace ble {
+
+namespace {
+
+// Seeded per thread, so processes and threads started together still draw different waits
+std::minstd_rand& Generator() {
+  thread_local std::minstd_rand generator(std::random_device{}());
+  return generator;
+}
+
+}  // anonymous namespace
+
+bool IsRetryable(const RetryPolicy& policy, const Result& result) {
+  if (!result.hasError()) {
+    return false;
+  }
+  const auto code = static_cast<ErrorCode>(result.error_code);
+  if (code == ErrorCode::ConnectionTimeout || code == ErrorCode::PairingTimeout) {
+    return policy.retry_timeouts;
+  }
+  if (code != ErrorCode::ConnectionFailed && code != ErrorCode::PairingFailed) {
+    return false;
+  }
+  return std::any_of(policy.retryable_errors.begin(), policy.retryable_errors.end(), [&result](const auto& error) {
+    return result.error_message.find(error) != std::string::npos;
+  });
+}
+
+std::chrono::milliseconds RetryBackoff(const RetryPolicy& policy, int retry) {
+  const double initial = static_cast<double>(policy.initial_backoff.count());
+  const double cap = static_cast<double>(policy.max_backoff.count());
+  const double bound = std::min(initial * std::pow(std::max(policy.multiplier, 1.0), std::max(retry - 1, 0)), cap);
+  std::uniform_real_distribution<double> jitter(bound / 2, bound);
+  return std::chrono::milliseconds(static_cast<int64_t>(jitter(Generator())));
+}
+
+}  // namespace ble
@@ -0,0 +1,262 @@
+// MIT License
+// Copyright (c) 2025 pezy
+
+#include <algorithm>
+#include <atomic>
+#include <bit>
+#include <bluetooth/rssi_tracker.hpp>
+#include <cstring>
+#include <thread>
+
+#include "bluez_utils.hpp"
+
+namespace ble {
+
+namespace {
+
+constexpr uint64_t kMacMask = (uint64_t{1} << 48) - 1;
+
+// Index entries carry the slot number above the MAC, so it fits 16 bits
+constexpr size_t kMaxDevices = 0xFFFE;
+
+// The trend is a slope over at least this long, so bursts of advertisements
+// microseconds apart do not turn measurement noise into huge slopes
+constexpr int64_t kTrendIntervalNs = 100'000'000;
+
+constexpr size_t kStatsWords = sizeof(RssiStats) / sizeof(uint64_t);
+static_assert(sizeof(RssiStats) % sizeof(uint64_t) == 0, "RssiStats must be a whole number of words");
+
+// One history sample in one word: microseconds since boot above the RSSI
+uint64_t PackSample(int64_t timestamp_ns, int16_t rssi) {
+  return (static_cast<uint64_t>(timestamp_ns / 1000) << 16) | static_cast<uint16_t>(rssi);
+}
+
+RssiSample UnpackSample(uint64_t word) {
+  return RssiSample{static_cast<int64_t>(word >> 16) * 1000, static_cast<int16_t>(word & 0xFFFF)};
+}
+
+size_t HashMac(uint64_t mac) { return static_cast<size_t>((mac * 0x9E3779B97F4A7C15ull) >> 32); }
+
+// Published state of one device behind a seqlock. Fields are atomic words so
+// a reader racing the writer copies torn data, which it then discards, rather
+// than reading racily.
+struct alignas(64) Slot {
+  std::atomic<uint32_t> sequence{0};  // odd while the writer is updating
+  std::atomic<uint64_t> stats[kStatsWords]{};
+  std::atomic<uint64_t> history[kRssiHistoryLength]{};
+};
+
+// Running state only the writer touches
+struct WriterState {
+  RssiStats stats;
+  float trend_anchor_estimate;
+  int64_t trend_anchor_ns;
+};
+
+}  // anonymous namespace
+
+class RssiTracker::Impl {
+ public:
+  explicit Impl(const RssiTrackerOptions& options)
+      : options_(options),
+        max_devices_(std::clamp<size_t>(options.max_devices, 1, kMaxDevices)),
+        index_mask_(std::bit_ceil(max_devices_ * 2) - 1),
+        index_(std::make_unique<std::atomic<uint64_t>[]>(index_mask_ + 1)),
+        slots_(std::make_unique<Slot[]>(max_devices_)),
+        writer_(std::make_unique<WriterState[]>(max_devices_)) {}
+
+  void Update(const AdvertisementEvent& event) {
+    if (!(event.flags & AdvertisementEvent::kRssi)) {
+      return;
+    }
+
+    const uint64_t mac = event.mac & kMacMask;
+    const size_t position = Probe(mac);
+    const uint64_t key = index_[position].load(std::memory_order_relaxed);
+    const size_t count = size_.load(std::memory_order_relaxed);
+    size_t slot_index;
+    if (key != 0) {
+      slot_index = (key >> 48) - 1;
+    } else if (count < max_devices_) {
+      slot_index = count;
+    } else {
+      untracked_.fetch_add(1, std::memory_order_relaxed);
+      return;
+    }
+
+    WriterState& state = writer_[slot_index];
+    Accumulate(state, mac, event, key == 0);
+    Publish(slots_[slot_index], state.stats);
+
+    // A new device becomes visible to readers only once its slot is published
+    if (key == 0) {
+      index_[position].store((static_cast<uint64_t>(slot_index + 1) << 48) | mac, std::memory_order_release);
+      size_.store(count + 1, std::memory_order_release);
+    }
+  }
+
+  std::optional<RssiStats> Stats(uint64_t mac) const {
+    const Slot* slot = Find(mac & kMacMask);
+    if (!slot) {
+      return std::nullopt;
+    }
+    RssiStats stats;
+    Read(*slot, &stats, nullptr);
+    return stats;
+  }
+
+  size_t History(uint64_t mac, std::span<RssiSample> out) const {
+    const Slot* slot = Find(mac & kMacMask);
+    if (!slot) {
+      return 0;
+    }
+    RssiStats stats;
+    uint64_t history[kRssiHistoryLength];
+    Read(*slot, &stats, history);
+
+    const size_t count = std::min({out.size(), kRssiHistoryLength, static_cast<size_t>(stats.samples)});
+    for (size_t i = 0; i < count; ++i) {
+      out[i] = UnpackSample(history[(stats.samples - count + i) % kRssiHistoryLength]);
+    }
+    return count;
+  }
+
+  size_t size() const { return size_.load(std::memory_order_acquire); }
+
+  uint64_t untracked() const { return untracked_.load(std::memory_order_relaxed); }
+
+ private:
+  // Index position holding mac, or the empty entry ending its probe sequence.
+  // The index is at most half full, so probing always terminates.
+  size_t Probe(uint64_t mac) const {
+    for (size_t position = HashMac(mac) & index_mask_;; position = (position + 1) & index_mask_) {
+      const uint64_t key = index_[position].load(std::memory_order_acquire);
+      if (key == 0 || (key & kMacMask) == mac) {
+        return position;
+      }
+    }
+  }
+
+  const Slot* Find(uint64_t mac) const {
+    const uint64_t key = index_[Probe(mac)].load(std::memory_order_acquire);
+    return key != 0 ? &slots_[(key >> 48) - 1] : nullptr;
+  }
+
+  void Accumulate(WriterState& state, uint64_t mac, const AdvertisementEvent& event, bool first) {
+    RssiStats& stats = state.stats;
+    const float reading = event.rssi;
+    if (first) {
+      stats = RssiStats{};
+      stats.mac = mac;
+      stats.last_timestamp_ns = event.timestamp_ns;
+      stats.last = stats.min = stats.max = event.rssi;
+      stats.ema = stats.estimate = reading;
+      stats.estimate_variance = options_.measurement_noise;
+      state.trend_anchor_estimate = reading;
+      state.trend_anchor_ns = event.timestamp_ns;
+    } else {
+      const float elapsed_seconds = std::max<int64_t>(event.timestamp_ns - stats.last_timestamp_ns, 0) * 1e-9f;
+      stats.ema += options_.ema_alpha * (reading - stats.ema);
+
+      // One-dimensional Kalman filter; uncertainty grows with the time since the last reading
+      const float predicted_variance = stats.estimate_variance + options_.process_noise * elapsed_seconds;
+      const float gain = predicted_variance / (predicted_variance + options_.measurement_noise);
+      stats.estimate += gain * (reading - stats.estimate);
+      stats.estimate_variance = (1.0f - gain) * predicted_variance;
+
+      const int64_t since_anchor = event.timestamp_ns - state.trend_anchor_ns;
+      if (since_anchor >= kTrendIntervalNs) {
+        const float slope = (stats.estimate - state.trend_anchor_estimate) / (since_anchor * 1e-9f);
+        stats.trend += options_.ema_alpha * (slope - stats.trend);
+        state.trend_anchor_estimate = stats.estimate;
+        state.trend_anchor_ns = event.timestamp_ns;
+      }
+
+      stats.last = event.rssi;
+      stats.min = std::min(stats.min, event.rssi);
+      stats.max = std::max(stats.max, event.rssi);
+      stats.last_timestamp_ns = event.timestamp_ns;
+    }
+    stats.samples += 1;
+  }
+
+  static void Publish(Slot& slot, const RssiStats& stats) {
+    uint64_t words[kStatsWords];
+    std::memcpy(words, &stats, sizeof(words));
+
+    const uint32_t sequence = slot.sequence.load(std::memory_order_relaxed);
+    slot.sequence.store(sequence + 1, std::memory_order_relaxed);
+    std::atomic_thread_fence(std::memory_order_release);
+    for (size_t i = 0; i < kStatsWords; ++i) {
+      slot.stats[i].store(words[i], std::memory_order_relaxed);
+    }
+    slot.history[(stats.samples - 1) % kRssiHistoryLength].store(PackSample(stats.last_timestamp_ns, stats.last),
+                                                                  std::memory_order_relaxed);
+    slot.sequence.store(sequence + 2, std::memory_order_release);
+  }
+
+  // Retries until it copies a consistent snapshot; history may be null
+  static void Read(const Slot& slot, RssiStats* stats, uint64_t* history) {
+    uint64_t words[kStatsWords];
+    for (;;) {
+      const uint32_t sequence = slot.sequence.load(std::memory_order_acquire);
+      if (sequence & 1) {
+        std::this_thread::yield();
+        continue;
+      }
+      for (size_t i = 0; i < kStatsWords; ++i) {
+        words[i] = slot.stats[i].load(std::memory_order_relaxed);
+      }
+      if (history) {
+        for (size_t i = 0; i < kRssiHistoryLength; ++i) {
+          history[i] = slot.history[i].load(std::memory_order_relaxed);
+        }
+      }
+      std::atomic_thread_fence(std::memory_order_acquire);
+      if (slot.sequence.load(std::memory_order_relaxed) == sequence) {
+        break;
+      }
+    }
+    std::memcpy(stats, words, sizeof(words));
+  }
+
+  const RssiTrackerOptions options_;
+  const size_t max_devices_;
+  const size_t index_mask_;
+
+  // Open-addressing index, (slot + 1) << 48 | mac, 0 when empty. Only the
+  // writer inserts and nothing is ever removed, so readers probe lock-free.
+  const std::unique_ptr<std::atomic<uint64_t>[]> index_;
+  const std::unique_ptr<Slot[]> slots_;
+  const std::unique_ptr<WriterState[]> writer_;
+
+  std::atomic<size_t> size_{0};
+  std::atomic<uint64_t> untracked_{0};
+};
+
+RssiTracker::RssiTracker(const RssiTrackerOptions& options) : impl_(std::make_unique<Impl>(options)) {}
+
+RssiTracker::~RssiTracker() = default;
+
+void RssiTracker::Update(const AdvertisementEvent& event) { impl_->Update(event); }
+
+void RssiTracker::Update(std::span<const AdvertisementEvent> events) {
+  for (const auto& event : events) {
+    impl_->Update(event);
+  }
+}
+
+std::optional<RssiStats> RssiTracker::Stats(uint64_t mac) const { return impl_->Stats(mac); }
+
+std::optional<RssiStats> RssiTracker::Stats(const std::string& mac_address) const {
+  const auto mac = internal::PackMacAddress(mac_address);
+  return mac ? impl_->Stats(*mac) : std::nullopt;
+}
+
+size_t RssiTracker::History(uint64_t mac, std::span<RssiSample> out) const { return impl_->History(mac, out); }
+
+size_t RssiTracker::size() const { return impl_->size(); }
+
+uint64_t RssiTracker::untracked() const { return impl_->untracked(); }
+
+}  // namespace ble
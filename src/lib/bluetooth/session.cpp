@@ -0,0 +1,1054 @@
+// MIT License
+// Copyright (c) 2025 pezy
+
+#include "session_impl.hpp"
+
+// std
+#include <algorithm>
+#include <future>
+#include <memory>
+#include <thread>
+#include <utility>
+#include <vector>
+
+#include "device_cache_impl.hpp"
+
+namespace ble {
+
+using internal::CreateErrorResult;
+using internal::DeviceMethod;
+using internal::GObjectWrapper;
+using internal::MakeErrorResult;
+using internal::ScopedTimer;
+
+namespace {
+
+// Property reads and writes are local to bluetoothd, it answers without touching the radio
+constexpr int kPropertyTimeoutSeconds = 5;
+
+constexpr const char* kFilterConflictMessage = "Another user of the session scans this adapter with another filter";
+
+// Empty (a{sv}) parameters for SetDiscoveryFilter, which clear the filter
+GVariant* NoDiscoveryFilter() {
+  GVariantBuilder builder;
+  g_variant_builder_init(&builder, G_VARIANT_TYPE_VARDICT);
+  return g_variant_new("(a{sv})", &builder);
+}
+
+std::chrono::milliseconds ElapsedSince(std::chrono::steady_clock::time_point start) {
+  return std::chrono::duration_cast<std::chrono::milliseconds>(std::chrono::steady_clock::now() - start);
+}
+
+bool IsRemoteError(const GError* error, const char* error_name) {
+  if (!error || !g_dbus_error_is_remote_error(error)) {
+    return false;
+  }
+  gchar* remote_error = g_dbus_error_get_remote_error(error);
+  const bool matches = g_strcmp0(remote_error, error_name) == 0;
+  g_free(remote_error);
+  return matches;
+}
+
+// Maps a Device1 method reply to a Result, taking ownership of reply and error
+Result MakeMethodResult(GVariant* reply, GError* error, const DeviceMethod& method) {
+  Result result;
+  if (reply) {
+    g_variant_unref(reply);
+    result.success = true;
+    return result;
+  }
+
+  if (method.already_done_error && IsRemoteError(error, method.already_done_error)) {
+    // The caller's goal is met; the message tells it apart from a fresh success
+    result.success = true;
+    result.error_message = method.already_done_message;
+  } else if (method.timeout_code != ErrorCode::Success && error &&
+             g_error_matches(error, G_DBUS_ERROR, G_DBUS_ERROR_TIMEOUT)) {
+    result = MakeErrorResult(method.timeout_code, method.timeout_message);
+  } else {
+    result = MakeErrorResult(method.failure_code, error ? error->message : method.failure_message);
+  }
+  if (error) g_error_free(error);
+  return result;
+}
+
+// In-flight asynchronous Device1 call, owned by the reply callback
+struct AsyncDeviceCall {
+  Session::Impl* impl;
+  const DeviceMethod* method;
+  ResultCallback callback;
+  std::chrono::steady_clock::time_point start;
+  GDBusConnection* connection;  // owned reference
+  std::string device_path;
+  int timeout_ms;
+  GVariant* parameters;  // owned reference or nullptr
+};
+
+// In-flight asynchronous GetManagedObjects, owned by the reply callback
+struct AsyncObjectsCall {
+  Session::Impl* impl;
+  DeviceQueryCallback callback;
+  std::chrono::steady_clock::time_point start;
+  GDBusConnection* connection;  // owned reference
+};
+
+void OnDeviceMethodReply(GObject* source, GAsyncResult* res, gpointer user_data) {
+  std::unique_ptr<AsyncDeviceCall> call(static_cast<AsyncDeviceCall*>(user_data));
+  GError* error = nullptr;
+  GVariant* reply = g_dbus_connection_call_finish(G_DBUS_CONNECTION(source), res, &error);
+
+  Result result = MakeMethodResult(reply, error, *call->method);
+  result.operation_time = ElapsedSince(call->start);
+  g_object_unref(call->connection);
+  if (call->parameters) g_variant_unref(call->parameters);
+
+  if (call->callback) call->callback(result);
+  call->impl->EndOperation();
+}
+
+void OnManagedObjectsReply(GObject* source, GAsyncResult* res, gpointer user_data) {
+  std::unique_ptr<AsyncObjectsCall> call(static_cast<AsyncObjectsCall*>(user_data));
+  GError* error = nullptr;
+  GVariant* objects_result = g_dbus_connection_call_finish(G_DBUS_CONNECTION(source), res, &error);
+
+  DeviceQueryResult result;
+  if (objects_result) {
+    auto objects_result_wrapper = GObjectWrapper::make_variant(objects_result);
+    internal::AppendPairedDevices(objects_result_wrapper.get(), &result.devices);
+    result.success = true;
+  } else {
+    result = CreateErrorResult(ErrorCode::BluetoothServiceUnavailable,
+                               error ? error->message : "Failed to get managed objects");
+    if (error) g_error_free(error);
+  }
+  result.query_time = ElapsedSince(call->start);
+  g_object_unref(call->connection);
+
+  if (call->callback) call->callback(result);
+  call->impl->EndOperation();
+}
+
+// Adapts a promise to a completion callback
+template <typename T>
+std::function<void(const T&)> FulfillPromise(const std::shared_ptr<std::promise<T>>& promise) {
+  return [promise](const T& value) { promise->set_value(value); };
+}
+
+// Timeout of one attempt: the caller's, cut short by the retry deadline
+int AttemptTimeout(int timeout_seconds, std::chrono::steady_clock::time_point deadline) {
+  const auto remaining = std::chrono::ceil<std::chrono::seconds>(deadline - std::chrono::steady_clock::now());
+  return std::clamp<int>(static_cast<int>(remaining.count()), 1, std::max(timeout_seconds, 1));
+}
+
+// Asynchronous call under the session's RetryPolicy, shared by its attempts and backoff timers
+struct RetryingCall {
+  Session::Impl* impl;
+  DeviceAddress device;
+  const DeviceMethod* method;
+  int timeout_seconds;
+  ResultCallback callback;
+  std::chrono::steady_clock::time_point start;
+  std::chrono::steady_clock::time_point deadline;
+  std::vector<std::chrono::milliseconds> attempt_times;
+};
+
+void OnRetryingAttempt(const std::shared_ptr<RetryingCall>& call, const Result& result);
+
+void StartRetryingAttempt(const std::shared_ptr<RetryingCall>& call) {
+  call->impl->CallDeviceMethodAsync(call->device, *call->method, AttemptTimeout(call->timeout_seconds, call->deadline),
+                                    [call](const Result& result) { OnRetryingAttempt(call, result); });
+}
+
+// Runs on the loop thread after every attempt: waits out the backoff on a timer or completes the call
+void OnRetryingAttempt(const std::shared_ptr<RetryingCall>& call, const Result& result) {
+  const RetryPolicy& policy = call->impl->retry_policy();
+  call->attempt_times.push_back(result.operation_time);
+  const int attempts = static_cast<int>(call->attempt_times.size());
+
+  // A cancelled session finishes the call instead of starting another attempt
+  if (attempts < policy.max_attempts && IsRetryable(policy, result) &&
+      !g_cancellable_is_cancelled(call->impl->cancellable())) {
+    const auto backoff = RetryBackoff(policy, attempts);
+    if (std::chrono::steady_clock::now() + backoff < call->deadline) {
+      GSource* timer = g_timeout_source_new(static_cast<guint>(backoff.count()));
+      g_source_set_callback(
+          timer,
+          [](gpointer data) -> gboolean {
+            StartRetryingAttempt(*static_cast<std::shared_ptr<RetryingCall>*>(data));
+            return G_SOURCE_REMOVE;
+          },
+          new std::shared_ptr<RetryingCall>(call),
+          [](gpointer data) { delete static_cast<std::shared_ptr<RetryingCall>*>(data); });
+      g_source_attach(timer, call->impl->context());
+      g_source_unref(timer);
+      return;
+    }
+  }
+
+  Result final_result = result;
+  final_result.attempt_times = std::move(call->attempt_times);
+  final_result.operation_time = ElapsedSince(call->start);
+  if (call->callback) call->callback(final_result);
+  call->impl->EndOperation();
+}
+
+}  // anonymous namespace
+
+Session::Impl::Impl(const SessionOptions& options)
+    : call_mode_(options.call_mode),
+      default_adapter_(options.default_adapter),
+      retry_(options.retry),
+      device_proxies_(options.device_proxy_cache_size) {
+  // Block until the loop runs, so every later invoke is dispatched on the loop thread
+  std::promise<void> running;
+  auto started = running.get_future();
+  GSource* source = g_idle_source_new();
+  g_source_set_callback(
+      source,
+      [](gpointer data) -> gboolean {
+        static_cast<std::promise<void>*>(data)->set_value();
+        return G_SOURCE_REMOVE;
+      },
+      &running, nullptr);
+  g_source_attach(source, context_);
+  g_source_unref(source);
+
+  loop_thread_ = std::thread([this]() {
+    g_main_context_push_thread_default(context_);
+    g_main_loop_run(loop_);
+    g_main_context_pop_thread_default(context_);
+  });
+  started.wait();
+}
+
+Session::Impl::~Impl() {
+  // Cancelled calls still complete on the loop thread; wait for their callbacks
+  g_cancellable_cancel(cancellable_);
+  {
+    std::unique_lock<std::mutex> lock(operations_mutex_);
+    operations_done_.wait(lock, [this]() { return pending_operations_ == 0; });
+  }
+
+  {
+    std::lock_guard<std::mutex> lock(mutex_);
+    ResetConnectionLocked();
+  }
+  // Queued behind the unsubscription ResetConnectionLocked posted
+  RunOnLoop([this]() { g_main_loop_quit(loop_); });
+  loop_thread_.join();
+  g_object_unref(cancellable_);
+  g_main_loop_unref(loop_);
+  g_main_context_unref(context_);
+}
+
+GDBusConnection* Session::Impl::AcquireConnection(GError** error) {
+  {
+    std::lock_guard<std::mutex> lock(mutex_);
+    if (connection_ && !g_dbus_connection_is_closed(connection_.get())) {
+      return static_cast<GDBusConnection*>(g_object_ref(connection_.get()));
+    }
+  }
+
+  // Opened without mutex_: connecting blocks, and OpenConnection waits on the loop thread
+  GDBusConnection* opened = OpenConnection(error);
+  if (!opened) {
+    return nullptr;
+  }
+
+  std::lock_guard<std::mutex> lock(mutex_);
+  if (connection_ && !g_dbus_connection_is_closed(connection_.get())) {
+    // Another caller reopened it meanwhile
+    g_dbus_connection_close(opened, nullptr, nullptr, nullptr);
+    g_object_unref(opened);
+  } else {
+    ResetConnectionLocked();
+    connection_ = GObjectWrapper::make_dbus_connection(opened);
+    SubscribeLocked();
+  }
+  return static_cast<GDBusConnection*>(g_object_ref(connection_.get()));
+}
+
+GDBusProxy* Session::Impl::AcquireObjectManager(ErrorCode* error_code, GError** error) {
+  GDBusConnection* connection = AcquireConnection(error);
+  if (!connection) {
+    *error_code = ErrorCode::DBusConnectionFailed;
+    return nullptr;
+  }
+  auto connection_wrapper = GObjectWrapper::make_dbus_connection(connection);
+
+  std::lock_guard<std::mutex> lock(mutex_);
+  if (!object_manager_ || g_dbus_proxy_get_connection(object_manager_.get()) != connection) {
+    // The proxy only issues method calls: skip the property preload and do not
+    // subscribe to signals that nobody would dispatch
+    GDBusProxy* proxy = g_dbus_proxy_new_sync(
+        connection,
+        static_cast<GDBusProxyFlags>(G_DBUS_PROXY_FLAGS_DO_NOT_LOAD_PROPERTIES |
+                                     G_DBUS_PROXY_FLAGS_DO_NOT_CONNECT_SIGNALS),
+        nullptr, "org.bluez", "/", "org.freedesktop.DBus.ObjectManager", nullptr, error);
+    if (!proxy) {
+      *error_code = ErrorCode::BluetoothServiceUnavailable;
+      return nullptr;
+    }
+    object_manager_ = GObjectWrapper::make_dbus_proxy(proxy);
+  }
+
+  return static_cast<GDBusProxy*>(g_object_ref(object_manager_.get()));
+}
+
+GDBusProxy* Session::Impl::AcquireDeviceProxy(GDBusConnection* connection, const std::string& device_path,
+                                              GError** error) {
+  {
+    std::lock_guard<std::mutex> lock(cache_mutex_);
+    GObjectWrapper::DBusProxy* cached = device_proxies_.Get(device_path);
+    if (cached && g_dbus_proxy_get_connection(cached->get()) == connection) {
+      return static_cast<GDBusProxy*>(g_object_ref(cached->get()));
+    }
+  }
+
+  // Built outside the lock: construction blocks on a GetAll round trip. Signals stay
+  // unconnected since the calling thread's context is not guaranteed to be iterated.
+  GDBusProxy* device_proxy = g_dbus_proxy_new_sync(connection, G_DBUS_PROXY_FLAGS_DO_NOT_CONNECT_SIGNALS, nullptr,
+                                                   "org.bluez", device_path.c_str(), "org.bluez.Device1", nullptr,
+                                                   error);
+  if (!device_proxy) {
+    return nullptr;
+  }
+
+  std::lock_guard<std::mutex> lock(cache_mutex_);
+  device_proxies_.Put(device_path,
+                      GObjectWrapper::make_dbus_proxy(static_cast<GDBusProxy*>(g_object_ref(device_proxy))));
+  return device_proxy;
+}
+
+GVariant* Session::Impl::GetManagedObjects(DeviceQueryResult* error_result) {
+  GError* error = nullptr;
+  ErrorCode error_code = ErrorCode::UnknownError;
+
+  GDBusProxy* object_manager_proxy = AcquireObjectManager(&error_code, &error);
+  if (!object_manager_proxy) {
+    const char* fallback = error_code == ErrorCode::DBusConnectionFailed ? "Failed to connect to D-Bus"
+                                                                          : "Failed to create BlueZ adapter proxy";
+    *error_result = CreateErrorResult(error_code, error ? error->message : fallback);
+    if (error) g_error_free(error);
+    return nullptr;
+  }
+
+  // RAII wrapper for proxy
+  auto proxy_wrapper = GObjectWrapper::make_dbus_proxy(object_manager_proxy);
+
+  // Get managed objects (devices)
+  GVariant* objects_result =
+      g_dbus_proxy_call_sync(proxy_wrapper.get(), "GetManagedObjects", nullptr, G_DBUS_CALL_FLAGS_NONE,
+                             -1,  // Default timeout
+                             nullptr, &error);
+
+  if (!objects_result) {
+    *error_result = CreateErrorResult(ErrorCode::BluetoothServiceUnavailable,
+                                      error ? error->message : "Failed to get managed objects");
+    if (error) g_error_free(error);
+  }
+  return objects_result;
+}
+
+void Session::Impl::EvictDeviceProxy(const std::string& device_path) {
+  std::lock_guard<std::mutex> lock(cache_mutex_);
+  device_proxies_.Erase(device_path);
+}
+
+const char* Session::Impl::CheckDeviceAddress(const DeviceAddress& device) const {
+  if (!internal::IsValidMacAddress(device.mac_address)) {
+    return "Invalid MAC address format";
+  }
+  if (!internal::IsValidAdapterName(ResolveAdapter(device))) {
+    return "Invalid adapter name";
+  }
+  return nullptr;
+}
+
+Result Session::Impl::CallDeviceMethod(const DeviceAddress& device, const DeviceMethod& method, int timeout_seconds,
+                                       GVariant* parameters) {
+  Result result;
+  ScopedTimer timer(result.operation_time);
+
+  // Take ownership so early returns release floating parameters
+  auto parameters_wrapper = GObjectWrapper::make_variant(parameters ? g_variant_ref_sink(parameters) : nullptr);
+
+  if (const char* invalid = CheckDeviceAddress(device)) {
+    result = MakeErrorResult(ErrorCode::DeviceNotFound, invalid);
+    return result;
+  }
+
+  GError* error = nullptr;
+
+  GDBusConnection* connection = AcquireConnection(&error);
+  if (!connection) {
+    result = MakeErrorResult(ErrorCode::DBusConnectionFailed, error ? error->message : "Failed to connect to D-Bus");
+    if (error) g_error_free(error);
+    return result;
+  }
+
+  // RAII wrapper for connection
+  auto connection_wrapper = GObjectWrapper::make_dbus_connection(connection);
+
+  // Convert MAC address to D-Bus object path
+  std::string device_path = DevicePath(device);
+
+  GVariant* call_result = nullptr;
+  if (call_mode_ == CallMode::Direct || g_strcmp0(method.interface_name, "org.bluez.Device1") != 0) {
+    // Plain method call on the computed path: no proxy, no property preload
+    call_result = g_dbus_connection_call_sync(connection_wrapper.get(), "org.bluez", device_path.c_str(),
+                                              method.interface_name, method.name, parameters_wrapper.get(),
+                                              G_VARIANT_TYPE_UNIT, G_DBUS_CALL_FLAGS_NONE,
+                                              timeout_seconds * 1000,  // Convert to milliseconds
+                                              nullptr, &error);
+  } else {
+    // Proxy for the specific device, reused across calls
+    GDBusProxy* device_proxy = AcquireDeviceProxy(connection_wrapper.get(), device_path, &error);
+
+    if (!device_proxy) {
+      result =
+          MakeErrorResult(ErrorCode::DeviceNotFound, error ? error->message : "Device not found or not accessible");
+      if (error) g_error_free(error);
+      return result;
+    }
+
+    // RAII wrapper for device proxy
+    auto device_proxy_wrapper = GObjectWrapper::make_dbus_proxy(device_proxy);
+
+    call_result =
+        g_dbus_proxy_call_sync(device_proxy_wrapper.get(), method.name, g_variant_new("()"), G_DBUS_CALL_FLAGS_NONE,
+                               timeout_seconds * 1000,  // Convert to milliseconds
+                               nullptr, &error);
+  }
+
+  // The object is gone (device removed or never discovered): do not keep its proxy around
+  if (error && (g_error_matches(error, G_DBUS_ERROR, G_DBUS_ERROR_UNKNOWN_OBJECT) ||
+                g_error_matches(error, G_DBUS_ERROR, G_DBUS_ERROR_UNKNOWN_METHOD))) {
+    EvictDeviceProxy(device_path);
+  }
+
+  result = MakeMethodResult(call_result, error, method);
+  return result;
+}
+
+Result Session::Impl::CallObjectMethod(const std::string& object_path, const DeviceMethod& method,
+                                       int timeout_seconds, GVariant* parameters) {
+  Result result;
+  ScopedTimer timer(result.operation_time);
+
+  // Take ownership so early returns release floating parameters
+  auto parameters_wrapper = GObjectWrapper::make_variant(parameters ? g_variant_ref_sink(parameters) : nullptr);
+
+  // GDBus treats a malformed path as a programming error, e.g. a bad adapter name
+  if (!g_variant_is_object_path(object_path.c_str())) {
+    result = MakeErrorResult(method.failure_code, "Invalid object path");
+    return result;
+  }
+
+  GError* error = nullptr;
+  GDBusConnection* connection = AcquireConnection(&error);
+  if (!connection) {
+    result = MakeErrorResult(ErrorCode::DBusConnectionFailed, error ? error->message : "Failed to connect to D-Bus");
+    if (error) g_error_free(error);
+    return result;
+  }
+
+  // RAII wrapper for connection
+  auto connection_wrapper = GObjectWrapper::make_dbus_connection(connection);
+
+  GVariant* call_result = g_dbus_connection_call_sync(connection, "org.bluez", object_path.c_str(),
+                                                      method.interface_name, method.name, parameters_wrapper.get(),
+                                                      G_VARIANT_TYPE_UNIT, G_DBUS_CALL_FLAGS_NONE,
+                                                      timeout_seconds * 1000,  // Convert to milliseconds
+                                                      nullptr, &error);
+  result = MakeMethodResult(call_result, error, method);
+  return result;
+}
+
+void Session::Impl::CallDeviceMethodAsync(const DeviceAddress& device, const DeviceMethod& method,
+                                          int timeout_seconds, ResultCallback callback, GVariant* parameters) {
+  BeginOperation();
+
+  // Owned by the call from here on, also when it fails before being issued
+  auto parameters_wrapper = GObjectWrapper::make_variant(parameters ? g_variant_ref_sink(parameters) : nullptr);
+
+  // Early failures are still reported from the loop thread, like every other completion
+  auto fail = [this, &callback](ErrorCode error_code, const std::string& error_message) {
+    Post([this, callback = std::move(callback), result = MakeErrorResult(error_code, error_message)]() {
+      if (callback) callback(result);
+      EndOperation();
+    });
+  };
+
+  if (const char* invalid = CheckDeviceAddress(device)) {
+    fail(ErrorCode::DeviceNotFound, invalid);
+    return;
+  }
+
+  GError* error = nullptr;
+  GDBusConnection* connection = AcquireConnection(&error);
+  if (!connection) {
+    fail(ErrorCode::DBusConnectionFailed, error ? error->message : "Failed to connect to D-Bus");
+    if (error) g_error_free(error);
+    return;
+  }
+
+  auto* call = new AsyncDeviceCall{this,
+                                   &method,
+                                   std::move(callback),
+                                   std::chrono::steady_clock::now(),
+                                   connection,
+                                   DevicePath(device),
+                                   timeout_seconds * 1000,
+                                   parameters_wrapper.release()};
+
+  // Issued from the loop thread so the reply is dispatched there
+  Post([call]() {
+    g_dbus_connection_call(call->connection, "org.bluez", call->device_path.c_str(), call->method->interface_name,
+                           call->method->name, call->parameters, G_VARIANT_TYPE_UNIT, G_DBUS_CALL_FLAGS_NONE,
+                           call->timeout_ms, call->impl->cancellable(), &OnDeviceMethodReply, call);
+  });
+}
+
+Result Session::Impl::CallDeviceMethodWithRetry(const DeviceAddress& device, const DeviceMethod& method,
+                                                int timeout_seconds) {
+  if (retry_.max_attempts <= 1) {
+    return CallDeviceMethod(device, method, timeout_seconds);
+  }
+
+  const auto start = std::chrono::steady_clock::now();
+  const auto deadline = start + retry_.deadline;
+  std::vector<std::chrono::milliseconds> attempt_times;
+  Result result;
+  for (int attempt = 1;; ++attempt) {
+    result = CallDeviceMethod(device, method, AttemptTimeout(timeout_seconds, deadline));
+    attempt_times.push_back(result.operation_time);
+    if (attempt >= retry_.max_attempts || !IsRetryable(retry_, result)) {
+      break;
+    }
+    const auto backoff = RetryBackoff(retry_, attempt);
+    if (std::chrono::steady_clock::now() + backoff >= deadline) {
+      break;
+    }
+    std::this_thread::sleep_for(backoff);
+  }
+
+  result.attempt_times = std::move(attempt_times);
+  result.operation_time = ElapsedSince(start);
+  return result;
+}
+
+void Session::Impl::CallDeviceMethodWithRetryAsync(const DeviceAddress& device, const DeviceMethod& method,
+                                                   int timeout_seconds, ResultCallback callback) {
+  if (retry_.max_attempts <= 1) {
+    CallDeviceMethodAsync(device, method, timeout_seconds, std::move(callback));
+    return;
+  }
+
+  // Brackets the whole sequence, so session destruction also waits out a pending backoff
+  BeginOperation();
+  const auto start = std::chrono::steady_clock::now();
+  StartRetryingAttempt(std::make_shared<RetryingCall>(
+      RetryingCall{this, device, &method, timeout_seconds, std::move(callback), start, start + retry_.deadline, {}}));
+}
+
+void Session::Impl::GetPairedDevicesAsync(DeviceQueryCallback callback) {
+  BeginOperation();
+
+  DeviceQueryResult cached;
+  if (QueryDeviceCache(&cached)) {
+    Post([this, callback = std::move(callback), cached = std::move(cached)]() {
+      if (callback) callback(cached);
+      EndOperation();
+    });
+    return;
+  }
+
+  GError* error = nullptr;
+  GDBusConnection* connection = AcquireConnection(&error);
+  if (!connection) {
+    Post([this, callback = std::move(callback),
+          result = CreateErrorResult(ErrorCode::DBusConnectionFailed,
+                                     error ? error->message : "Failed to connect to D-Bus")]() {
+      if (callback) callback(result);
+      EndOperation();
+    });
+    if (error) g_error_free(error);
+    return;
+  }
+
+  auto* call = new AsyncObjectsCall{this, std::move(callback), std::chrono::steady_clock::now(), connection};
+  Post([call]() {
+    g_dbus_connection_call(call->connection, "org.bluez", "/", "org.freedesktop.DBus.ObjectManager",
+                           "GetManagedObjects", nullptr, G_VARIANT_TYPE("(a{oa{sa{sv}}})"), G_DBUS_CALL_FLAGS_NONE,
+                           -1,  // Default timeout
+                           call->impl->cancellable(), &OnManagedObjectsReply, call);
+  });
+}
+
+Result Session::Impl::AcquireDiscovery(const std::string& adapter_path, GVariant* filter) {
+  auto filter_wrapper = GObjectWrapper::make_variant(filter ? g_variant_ref_sink(filter) : nullptr);
+  const bool filtered = static_cast<bool>(filter_wrapper);
+
+  std::lock_guard<std::mutex> lock(discovery_mutex_);
+  DiscoveryState& state = discovery_[adapter_path];
+  if (filtered && state.filtered > 0 && !g_variant_equal(state.filter.get(), filter_wrapper.get())) {
+    return MakeErrorResult(ErrorCode::DiscoveryFailed, kFilterConflictMessage);
+  }
+  ++state.holders;
+  if (filtered && state.filtered++ == 0) {
+    state.filter = std::move(filter_wrapper);
+  }
+
+  // Filter first, so a fresh scan starts out filtered
+  Result result = SyncDiscoveryFilterLocked(adapter_path, &state, true);
+  if (!result.hasError() && state.holders == 1) {
+    // InProgress is a scan this connection started outside the count; it is ours to stop from now on
+    result = CallObjectMethod(adapter_path, internal::kStartDiscoveryMethod, internal::kAdapterTimeoutSeconds);
+  }
+  if (result.hasError()) {
+    --state.holders;
+    if (filtered && --state.filtered == 0) {
+      state.filter.reset();
+    }
+    SyncDiscoveryFilterLocked(adapter_path, &state, true);
+    if (state.holders == 0) {
+      discovery_.erase(adapter_path);
+    }
+  }
+  return result;
+}
+
+Result Session::Impl::ChangeDiscoveryFilter(const std::string& adapter_path, bool filtered, GVariant* filter) {
+  auto filter_wrapper = GObjectWrapper::make_variant(filter ? g_variant_ref_sink(filter) : nullptr);
+
+  std::lock_guard<std::mutex> lock(discovery_mutex_);
+  auto it = discovery_.find(adapter_path);
+  if (it == discovery_.end()) {
+    return Result{true, 0, "", std::chrono::milliseconds(0)};
+  }
+  DiscoveryState& state = it->second;
+  const size_t others = state.filtered - (filtered ? 1 : 0);
+  if (filter_wrapper && others > 0 && !g_variant_equal(state.filter.get(), filter_wrapper.get())) {
+    return MakeErrorResult(ErrorCode::DiscoveryFailed, kFilterConflictMessage);
+  }
+
+  auto previous = std::move(state.filter);
+  const size_t previous_filtered = state.filtered;
+  state.filtered = others + (filter_wrapper ? 1 : 0);
+  if (state.filtered == 0) {
+    state.filter = GObjectWrapper::make_variant(nullptr);
+  } else if (filter_wrapper) {
+    state.filter = std::move(filter_wrapper);
+  } else {
+    state.filter = GObjectWrapper::make_variant(g_variant_ref(previous.get()));
+  }
+
+  Result result = SyncDiscoveryFilterLocked(adapter_path, &state, true);
+  if (result.hasError()) {
+    state.filter = std::move(previous);
+    state.filtered = previous_filtered;
+  }
+  return result;
+}
+
+Result Session::Impl::ReleaseDiscovery(const std::string& adapter_path, bool filtered, bool wait) {
+  std::lock_guard<std::mutex> lock(discovery_mutex_);
+  auto it = discovery_.find(adapter_path);
+  if (it == discovery_.end()) {
+    return Result{true, 0, "", std::chrono::milliseconds(0)};
+  }
+  DiscoveryState& state = it->second;
+  --state.holders;
+  if (filtered && --state.filtered == 0) {
+    state.filter.reset();
+  }
+  if (state.holders > 0) {
+    // E.g. the last unfiltered holder leaving puts the filter back
+    return SyncDiscoveryFilterLocked(adapter_path, &state, wait);
+  }
+
+  Result result = CallAdapterMethod(adapter_path, internal::kStopDiscoveryMethod, nullptr, wait);
+  // BlueZ keeps a client's filter past StopDiscovery for its next StartDiscovery
+  SyncDiscoveryFilterLocked(adapter_path, &state, wait);
+  discovery_.erase(it);
+  return result;
+}
+
+// Sends SetDiscoveryFilter when BlueZ's filter differs from the one the holders want
+Result Session::Impl::SyncDiscoveryFilterLocked(const std::string& adapter_path, DiscoveryState* state, bool wait) {
+  GVariant* wanted = state->filtered > 0 && state->filtered == state->holders ? state->filter.get() : nullptr;
+  GVariant* applied = state->applied.get();
+  if (wanted == applied || (wanted && applied && g_variant_equal(wanted, applied))) {
+    return Result{true, 0, "", std::chrono::milliseconds(0)};
+  }
+
+  Result result = CallAdapterMethod(adapter_path, internal::kSetDiscoveryFilterMethod,
+                                    wanted ? g_variant_ref(wanted) : NoDiscoveryFilter(), wait);
+  if (!result.hasError()) {
+    state->applied = GObjectWrapper::make_variant(wanted ? g_variant_ref(wanted) : nullptr);
+  }
+  return result;
+}
+
+// parameters as for CallObjectMethod; wait false issues the call without waiting for the reply
+Result Session::Impl::CallAdapterMethod(const std::string& adapter_path, const DeviceMethod& method,
+                                        GVariant* parameters, bool wait) {
+  if (wait) {
+    return CallObjectMethod(adapter_path, method, internal::kAdapterTimeoutSeconds, parameters);
+  }
+  auto parameters_wrapper = GObjectWrapper::make_variant(parameters ? g_variant_ref_sink(parameters) : nullptr);
+  GError* error = nullptr;
+  GDBusConnection* connection = AcquireConnection(&error);
+  if (!connection) {
+    Result result =
+        MakeErrorResult(ErrorCode::DBusConnectionFailed, error ? error->message : "Failed to connect to D-Bus");
+    if (error) g_error_free(error);
+    return result;
+  }
+  auto connection_wrapper = GObjectWrapper::make_dbus_connection(connection);
+  g_dbus_connection_call(connection, "org.bluez", adapter_path.c_str(), method.interface_name, method.name,
+                         parameters_wrapper.get(), nullptr, G_DBUS_CALL_FLAGS_NONE, -1, nullptr, nullptr, nullptr);
+  return Result{true, 0, "", std::chrono::milliseconds(0)};
+}
+
+void Session::Impl::AttachDeviceCache(DeviceCache::Impl* cache) {
+  std::lock_guard<std::mutex> lock(device_cache_mutex_);
+  if (!device_cache_) {
+    device_cache_ = cache;
+  }
+}
+
+void Session::Impl::DetachDeviceCache(DeviceCache::Impl* cache) {
+  std::lock_guard<std::mutex> lock(device_cache_mutex_);
+  if (device_cache_ == cache) {
+    device_cache_ = nullptr;
+  }
+}
+
+bool Session::Impl::QueryDeviceCache(DeviceQueryResult* result) {
+  std::lock_guard<std::mutex> lock(device_cache_mutex_);
+  return device_cache_ && device_cache_->GetPairedDevices(result);
+}
+
+bool Session::Impl::QueryDeviceCachePaired(const DeviceAddress& device, bool* paired) {
+  std::lock_guard<std::mutex> lock(device_cache_mutex_);
+  return device_cache_ && device_cache_->IsDevicePaired(device.mac_address, ResolveAdapter(device), paired);
+}
+
+void Session::Impl::RunOnLoop(std::function<void()> fn) {
+  if (g_main_context_is_owner(context_)) {
+    fn();
+    return;
+  }
+
+  struct Call {
+    std::function<void()> fn;
+    std::promise<void> done;
+  } call{std::move(fn), {}};
+  auto done = call.done.get_future();
+  g_main_context_invoke(
+      context_,
+      [](gpointer data) -> gboolean {
+        auto* call = static_cast<Call*>(data);
+        call->fn();
+        call->done.set_value();
+        return G_SOURCE_REMOVE;
+      },
+      &call);
+  done.wait();
+}
+
+void Session::Impl::Post(std::function<void()> fn) {
+  GSource* source = g_idle_source_new();
+  g_source_set_priority(source, G_PRIORITY_DEFAULT);
+  g_source_set_callback(
+      source,
+      [](gpointer data) -> gboolean {
+        (*static_cast<std::function<void()>*>(data))();
+        return G_SOURCE_REMOVE;
+      },
+      new std::function<void()>(std::move(fn)),
+      [](gpointer data) { delete static_cast<std::function<void()>*>(data); });
+  g_source_attach(source, context_);
+  g_source_unref(source);
+}
+
+void Session::Impl::BeginOperation() {
+  std::lock_guard<std::mutex> lock(operations_mutex_);
+  ++pending_operations_;
+}
+
+void Session::Impl::EndOperation() {
+  std::lock_guard<std::mutex> lock(operations_mutex_);
+  if (--pending_operations_ == 0) {
+    operations_done_.notify_all();
+  }
+}
+
+// A private connection rather than the process-wide one g_bus_get_sync
+// returns, so closing it or its exit-on-close setting concerns no other GIO
+// user; exit-on-close defaults to off for it, so a bus restart surfaces as an
+// error on the next call. Constructed on the loop thread, where GDBus then
+// emits its closed signal, and connected on the calling one.
+GDBusConnection* Session::Impl::OpenConnection(GError** error) {
+  gchar* address = g_dbus_address_get_for_bus_sync(G_BUS_TYPE_SYSTEM, nullptr, error);
+  if (!address) {
+    return nullptr;
+  }
+  GDBusConnection* connection = nullptr;
+  RunOnLoop([&connection, address]() {
+    const auto flags = static_cast<GDBusConnectionFlags>(G_DBUS_CONNECTION_FLAGS_AUTHENTICATION_CLIENT |
+                                                         G_DBUS_CONNECTION_FLAGS_MESSAGE_BUS_CONNECTION);
+    connection = G_DBUS_CONNECTION(g_object_new(G_TYPE_DBUS_CONNECTION, "address", address, "flags", flags, nullptr));
+  });
+  g_free(address);
+
+  if (!g_initable_init(G_INITABLE(connection), nullptr, error)) {
+    g_object_unref(connection);
+    return nullptr;
+  }
+  return connection;
+}
+
+// Posted rather than waited for: calls issued from the loop thread, e.g. by
+// completion callbacks, take mutex_ in AcquireConnection, so waiting on the
+// loop while holding it could deadlock. Posts run in order, so an
+// unsubscription always follows the subscription it undoes.
+void Session::Impl::SubscribeLocked() {
+  auto* connection = static_cast<GDBusConnection*>(g_object_ref(connection_.get()));
+  Post([this, connection]() {
+    interfaces_removed_id_ = g_dbus_connection_signal_subscribe(
+        connection, "org.bluez", "org.freedesktop.DBus.ObjectManager", "InterfacesRemoved", nullptr, nullptr,
+        G_DBUS_SIGNAL_FLAGS_NONE, &Impl::OnInterfacesRemoved, this, nullptr);
+    name_owner_changed_id_ = g_dbus_connection_signal_subscribe(
+        connection, "org.freedesktop.DBus", "org.freedesktop.DBus", "NameOwnerChanged", "/org/freedesktop/DBus",
+        "org.bluez", G_DBUS_SIGNAL_FLAGS_NONE, &Impl::OnNameOwnerChanged, this, nullptr);
+    g_object_unref(connection);
+  });
+}
+
+void Session::Impl::ResetConnectionLocked() {
+  if (connection_) {
+    auto* connection = static_cast<GDBusConnection*>(g_object_ref(connection_.get()));
+    Post([this, connection]() {
+      g_dbus_connection_signal_unsubscribe(connection, interfaces_removed_id_);
+      g_dbus_connection_signal_unsubscribe(connection, name_owner_changed_id_);
+      interfaces_removed_id_ = 0;
+      name_owner_changed_id_ = 0;
+      g_object_unref(connection);
+    });
+    // Private, so nobody else would close it
+    if (!g_dbus_connection_is_closed(connection_.get())) {
+      g_dbus_connection_close(connection_.get(), nullptr, nullptr, nullptr);
+    }
+  }
+
+  {
+    std::lock_guard<std::mutex> lock(cache_mutex_);
+    device_proxies_.Clear();
+  }
+  object_manager_.reset();
+  connection_.reset();
+}
+
+// Drops cached proxies for removed devices, or for every device below a removed adapter
+void Session::Impl::OnInterfacesRemoved(GDBusConnection*, const gchar*, const gchar*, const gchar*, const gchar*,
+                                        GVariant* parameters, gpointer user_data) {
+  auto* impl = static_cast<Impl*>(user_data);
+  const char* object_path = nullptr;
+  GVariantIter* interfaces_iter = nullptr;
+  g_variant_get(parameters, "(&oas)", &object_path, &interfaces_iter);
+  auto interfaces_iter_wrapper = GObjectWrapper::make_variant_iter(interfaces_iter);
+
+  const std::string removed_path = object_path;
+  const char* interface_name;
+  while (g_variant_iter_loop(interfaces_iter_wrapper.get(), "&s", &interface_name)) {
+    if (g_strcmp0(interface_name, "org.bluez.Device1") == 0) {
+      impl->EvictDeviceProxy(removed_path);
+    } else if (g_strcmp0(interface_name, "org.bluez.Adapter1") == 0) {
+      const std::string prefix = removed_path + "/";
+      std::lock_guard<std::mutex> lock(impl->cache_mutex_);
+      impl->device_proxies_.EraseIf([&prefix](const std::string& path) { return path.rfind(prefix, 0) == 0; });
+    }
+  }
+}
+
+// bluetoothd restarted or exited: none of the cached objects survive it
+void Session::Impl::OnNameOwnerChanged(GDBusConnection*, const gchar*, const gchar*, const gchar*, const gchar*,
+                                       GVariant*, gpointer user_data) {
+  auto* impl = static_cast<Impl*>(user_data);
+  std::lock_guard<std::mutex> lock(impl->cache_mutex_);
+  impl->device_proxies_.Clear();
+}
+
+Session::Session(const SessionOptions& options) : impl_(std::make_unique<Impl>(options)) {}
+
+Session::~Session() = default;
+
+Session& Session::Default() {
+  static Session session;
+  return session;
+}
+
+DeviceQueryResult Session::GetPairedDevices() {
+  DeviceQueryResult result;
+  ScopedTimer timer(result.query_time);
+
+  if (impl_->QueryDeviceCache(&result)) {
+    return result;
+  }
+
+  GVariant* objects_result = impl_->GetManagedObjects(&result);
+  if (!objects_result) {
+    return result;
+  }
+
+  // RAII wrapper for objects result
+  auto objects_result_wrapper = GObjectWrapper::make_variant(objects_result);
+
+  // Parse the result and extract paired devices
+  internal::AppendPairedDevices(objects_result_wrapper.get(), &result.devices);
+
+  // Set success and timing
+  result.success = true;
+
+  return result;
+}
+
+AdapterQueryResult Session::GetAdapters() {
+  AdapterQueryResult result;
+  ScopedTimer timer(result.query_time);
+
+  DeviceQueryResult error_result;
+  GVariant* objects_result = impl_->GetManagedObjects(&error_result);
+  if (!objects_result) {
+    result.error_code = error_result.error_code;
+    result.error_message = error_result.error_message;
+    return result;
+  }
+
+  // RAII wrapper for objects result
+  auto objects_result_wrapper = GObjectWrapper::make_variant(objects_result);
+
+  internal::AppendAdapters(objects_result_wrapper.get(), &result.adapters);
+  result.success = true;
+  return result;
+}
+
+// Reads Device1.Paired of the one object instead of listing the whole tree
+bool Session::IsDevicePaired(const DeviceAddress& device) {
+  bool paired = false;
+  if (impl_->QueryDeviceCachePaired(device, &paired)) {
+    return paired;
+  }
+
+  if (impl_->CheckDeviceAddress(device)) {
+    return false;
+  }
+
+  GError* error = nullptr;
+  GDBusConnection* connection = impl_->AcquireConnection(&error);
+  if (!connection) {
+    if (error) g_error_free(error);
+    return false;
+  }
+
+  // RAII wrapper for connection
+  auto connection_wrapper = GObjectWrapper::make_dbus_connection(connection);
+
+  // An unknown object simply means BlueZ has never seen the device
+  GVariant* reply = g_dbus_connection_call_sync(
+      connection, "org.bluez", impl_->DevicePath(device).c_str(), "org.freedesktop.DBus.Properties", "Get",
+      g_variant_new("(ss)", "org.bluez.Device1", "Paired"), G_VARIANT_TYPE("(v)"), G_DBUS_CALL_FLAGS_NONE,
+      kPropertyTimeoutSeconds * 1000, nullptr, &error);
+  if (!reply) {
+    if (error) g_error_free(error);
+    return false;
+  }
+
+  // RAII wrapper for reply
+  auto reply_wrapper = GObjectWrapper::make_variant(reply);
+
+  GVariant* value = nullptr;
+  g_variant_get(reply, "(v)", &value);
+  auto value_wrapper = GObjectWrapper::make_variant(value);
+  return g_variant_is_of_type(value, G_VARIANT_TYPE_BOOLEAN) && g_variant_get_boolean(value);
+}
+
+// No pre-check: BlueZ answers AlreadyExists for a paired device, which counts as success
+Result Session::PairDevice(const DeviceAddress& device, int timeout_seconds) {
+  return impl_->CallDeviceMethodWithRetry(device, internal::kPairMethod, timeout_seconds);
+}
+
+Result Session::ConnectDevice(const DeviceAddress& device, int timeout_seconds) {
+  return impl_->CallDeviceMethodWithRetry(device, internal::kConnectMethod, timeout_seconds);
+}
+
+Result Session::DisconnectDevice(const DeviceAddress& device, int timeout_seconds) {
+  return impl_->CallDeviceMethod(device, internal::kDisconnectMethod, timeout_seconds);
+}
+
+Result Session::TrustDevice(const DeviceAddress& device, bool trusted) {
+  return impl_->CallDeviceMethod(device, internal::kTrustMethod, kPropertyTimeoutSeconds,
+                                 internal::TrustParameters(trusted));
+}
+
+std::future<DeviceQueryResult> Session::GetPairedDevicesAsync() {
+  auto promise = std::make_shared<std::promise<DeviceQueryResult>>();
+  auto future = promise->get_future();
+  GetPairedDevicesAsync(FulfillPromise(promise));
+  return future;
+}
+
+void Session::GetPairedDevicesAsync(DeviceQueryCallback callback) { impl_->GetPairedDevicesAsync(std::move(callback)); }
+
+// Pairing an already paired device completes with the same "Device already paired" result as PairDevice
+std::future<Result> Session::PairDeviceAsync(const DeviceAddress& device, int timeout_seconds) {
+  auto promise = std::make_shared<std::promise<Result>>();
+  auto future = promise->get_future();
+  PairDeviceAsync(device, FulfillPromise(promise), timeout_seconds);
+  return future;
+}
+
+void Session::PairDeviceAsync(const DeviceAddress& device, ResultCallback callback, int timeout_seconds) {
+  impl_->CallDeviceMethodWithRetryAsync(device, internal::kPairMethod, timeout_seconds, std::move(callback));
+}
+
+std::future<Result> Session::ConnectDeviceAsync(const DeviceAddress& device, int timeout_seconds) {
+  auto promise = std::make_shared<std::promise<Result>>();
+  auto future = promise->get_future();
+  ConnectDeviceAsync(device, FulfillPromise(promise), timeout_seconds);
+  return future;
+}
+
+void Session::ConnectDeviceAsync(const DeviceAddress& device, ResultCallback callback, int timeout_seconds) {
+  impl_->CallDeviceMethodWithRetryAsync(device, internal::kConnectMethod, timeout_seconds, std::move(callback));
+}
+
+std::future<Result> Session::DisconnectDeviceAsync(const DeviceAddress& device, int timeout_seconds) {
+  auto promise = std::make_shared<std::promise<Result>>();
+  auto future = promise->get_future();
+  DisconnectDeviceAsync(device, FulfillPromise(promise), timeout_seconds);
+  return future;
+}
+
+void Session::DisconnectDeviceAsync(const DeviceAddress& device, ResultCallback callback, int timeout_seconds) {
+  impl_->CallDeviceMethodAsync(device, internal::kDisconnectMethod, timeout_seconds, std::move(callback));
+}
+
+std::future<Result> Session::TrustDeviceAsync(const DeviceAddress& device) {
+  auto promise = std::make_shared<std::promise<Result>>();
+  auto future = promise->get_future();
+  TrustDeviceAsync(device, FulfillPromise(promise));
+  return future;
+}
+
+void Session::TrustDeviceAsync(const DeviceAddress& device, ResultCallback callback) {
+  impl_->CallDeviceMethodAsync(device, internal::kTrustMethod, kPropertyTimeoutSeconds, std::move(callback),
+                               internal::TrustParameters(true));
+}
+
+void Session::Post(std::function<void()> fn) { impl_->Post(std::move(fn)); }
+
+}  // namespace ble
@@ -0,0 +1,249 @@
+// MIT License
+// Copyright (c) 2025 pezy
+
+#pragma once
+
+#include <bluetooth/device_cache.hpp>
+#include <bluetooth/session.hpp>
+
+// std
+#include <condition_variable>
+#include <functional>
+#include <mutex>
+#include <string>
+#include <thread>
+#include <unordered_map>
+
+#include "bluez_utils.hpp"
+#include "lru_cache.hpp"
+
+namespace ble {
+
+namespace internal {
+
+// Error mapping for a single method call on a BlueZ object
+struct DeviceMethod {
+  const char* interface_name;
+  const char* name;
+  ErrorCode failure_code;
+  const char* failure_message;
+  ErrorCode timeout_code;  // Success means timeouts are reported as failures
+  const char* timeout_message;
+  const char* already_done_error;  // BlueZ error meaning the method already took effect, or nullptr
+  const char* already_done_message;
+};
+
+inline constexpr DeviceMethod kPairMethod{"org.bluez.Device1",
+                                          "Pair",
+                                          ErrorCode::PairingFailed,
+                                          "Pairing operation failed",
+                                          ErrorCode::PairingTimeout,
+                                          "Pairing operation timed out",
+                                          "org.bluez.Error.AlreadyExists",
+                                          "Device already paired"};
+inline constexpr DeviceMethod kConnectMethod{"org.bluez.Device1",
+                                             "Connect",
+                                             ErrorCode::ConnectionFailed,
+                                             "Connection operation failed",
+                                             ErrorCode::ConnectionTimeout,
+                                             "Connection operation timed out",
+                                             "org.bluez.Error.AlreadyConnected",
+                                             "Device already connected"};
+inline constexpr DeviceMethod kDisconnectMethod{"org.bluez.Device1",
+                                                "Disconnect",
+                                                ErrorCode::DisconnectFailed,
+                                                "Disconnect operation failed",
+                                                ErrorCode::Success,
+                                                nullptr,
+                                                nullptr,
+                                                nullptr};
+// Properties.Set of Device1.Trusted, parameters built by TrustParameters
+inline constexpr DeviceMethod kTrustMethod{"org.freedesktop.DBus.Properties",
+                                           "Set",
+                                           ErrorCode::TrustFailed,
+                                           "Trust operation failed",
+                                           ErrorCode::Success,
+                                           nullptr,
+                                           nullptr,
+                                           nullptr};
+
+// Adapter calls are answered by bluetoothd itself
+inline constexpr int kAdapterTimeoutSeconds = 5;
+
+// BlueZ tracks discovery per bus client: InProgress means this connection already started it
+inline constexpr DeviceMethod kStartDiscoveryMethod{"org.bluez.Adapter1",
+                                                    "StartDiscovery",
+                                                    ErrorCode::DiscoveryFailed,
+                                                    "Failed to start discovery",
+                                                    ErrorCode::Success,
+                                                    nullptr,
+                                                    "org.bluez.Error.InProgress",
+                                                    "Discovery already in progress"};
+inline constexpr DeviceMethod kStopDiscoveryMethod{"org.bluez.Adapter1",
+                                                   "StopDiscovery",
+                                                   ErrorCode::DiscoveryFailed,
+                                                   "Failed to stop discovery",
+                                                   ErrorCode::Success,
+                                                   nullptr,
+                                                   nullptr,
+                                                   nullptr};
+
+inline constexpr DeviceMethod kSetDiscoveryFilterMethod{"org.bluez.Adapter1",
+                                                        "SetDiscoveryFilter",
+                                                        ErrorCode::DiscoveryFailed,
+                                                        "Failed to set discovery filter",
+                                                        ErrorCode::Success,
+                                                        nullptr,
+                                                        nullptr,
+                                                        nullptr};
+
+// Returns floating (ssv) parameters for kTrustMethod
+inline GVariant* TrustParameters(bool trusted) {
+  return g_variant_new("(ssv)", "org.bluez.Device1", "Trusted", g_variant_new_boolean(trusted));
+}
+
+}  // namespace internal
+
+// Shared by the libble translation units that extend a session
+class Session::Impl {
+ public:
+  explicit Impl(const SessionOptions& options);
+  ~Impl();
+
+  // Returns a new reference to the session's connection, (re)opening it when needed
+  GDBusConnection* AcquireConnection(GError** error);
+
+  // Returns a new reference to the ObjectManager proxy, creating it on first use
+  GDBusProxy* AcquireObjectManager(ErrorCode* error_code, GError** error);
+
+  // Returns a new reference to the Device1 proxy at device_path, served from the cache when possible
+  GDBusProxy* AcquireDeviceProxy(GDBusConnection* connection, const std::string& device_path, GError** error);
+
+  void EvictDeviceProxy(const std::string& device_path);
+
+  // Blocking GetManagedObjects; returns the (a{oa{sa{sv}}}) reply, or nullptr with error_result filled in
+  GVariant* GetManagedObjects(DeviceQueryResult* error_result);
+
+  const std::string& default_adapter() const { return default_adapter_; }
+
+  const RetryPolicy& retry_policy() const { return retry_; }
+
+  // The adapter a DeviceAddress refers to, the session's default when it names none
+  const std::string& ResolveAdapter(const DeviceAddress& device) const {
+    return device.adapter.empty() ? default_adapter_ : device.adapter;
+  }
+
+  // Returns why the address cannot name a BlueZ object, or nullptr when it can
+  const char* CheckDeviceAddress(const DeviceAddress& device) const;
+
+  // Device1 object path of a checked address
+  std::string DevicePath(const DeviceAddress& device) const {
+    return internal::DeviceObjectPath(ResolveAdapter(device), device.mac_address);
+  }
+
+  // parameters may be floating and is consumed; methods outside Device1 are always called directly
+  Result CallDeviceMethod(const DeviceAddress& device, const internal::DeviceMethod& method, int timeout_seconds,
+                          GVariant* parameters = nullptr);
+
+  // Direct call on an arbitrary object, e.g. an adapter; parameters as for CallDeviceMethod
+  Result CallObjectMethod(const std::string& object_path, const internal::DeviceMethod& method, int timeout_seconds,
+                          GVariant* parameters = nullptr);
+
+  // Issues the call from the loop thread; callback runs there once the reply arrives
+  void CallDeviceMethodAsync(const DeviceAddress& device, const internal::DeviceMethod& method, int timeout_seconds,
+                             ResultCallback callback, GVariant* parameters = nullptr);
+
+  // CallDeviceMethod(Async) under the session's RetryPolicy; the result is the
+  // last attempt's, with operation_time covering all of them and the waits
+  Result CallDeviceMethodWithRetry(const DeviceAddress& device, const internal::DeviceMethod& method,
+                                   int timeout_seconds);
+  void CallDeviceMethodWithRetryAsync(const DeviceAddress& device, const internal::DeviceMethod& method,
+                                      int timeout_seconds, ResultCallback callback);
+
+  void GetPairedDevicesAsync(DeviceQueryCallback callback);
+
+  // BlueZ tracks discovery and its filter per bus client, so every user of the
+  // session shares one per adapter: it starts with the first acquire and stops
+  // with the last release. filter is (a{sv}) SetDiscoveryFilter parameters,
+  // floating and consumed, or nullptr to scan unfiltered. Filtered holders
+  // must agree on the filter; an unfiltered one lifts it while it holds on, as
+  // BlueZ does across clients, and it is cleared once no filtered holder is
+  // left. filtered says which kind of holder releases or changes its filter;
+  // wait false sends the calls without waiting for their replies.
+  Result AcquireDiscovery(const std::string& adapter_path, GVariant* filter = nullptr);
+  Result ChangeDiscoveryFilter(const std::string& adapter_path, bool filtered, GVariant* filter);
+  Result ReleaseDiscovery(const std::string& adapter_path, bool filtered = false, bool wait = true);
+
+  // Queries are answered by the attached DeviceCache while it is synced; one cache at a time
+  void AttachDeviceCache(DeviceCache::Impl* cache);
+  void DetachDeviceCache(DeviceCache::Impl* cache);
+  bool QueryDeviceCache(DeviceQueryResult* result);
+  bool QueryDeviceCachePaired(const DeviceAddress& device, bool* paired);
+
+  // Runs fn on the loop thread and waits for it to finish
+  void RunOnLoop(std::function<void()> fn);
+
+  // Queues fn on the loop thread and returns immediately, even when called from the loop thread
+  void Post(std::function<void()> fn);
+
+  // Every asynchronous operation is bracketed by these, so destruction can drain them
+  void BeginOperation();
+  void EndOperation();
+
+  GMainContext* context() const { return context_; }
+  GCancellable* cancellable() const { return cancellable_; }
+
+ private:
+  // Discovery shared by the holders of one adapter
+  struct DiscoveryState {
+    size_t holders{0};
+    size_t filtered{0};  // holders scanning with filter
+    internal::GObjectWrapper::Variant filter{internal::GObjectWrapper::make_variant(nullptr)};
+    internal::GObjectWrapper::Variant applied{internal::GObjectWrapper::make_variant(nullptr)};  // what BlueZ has
+  };
+
+  GDBusConnection* OpenConnection(GError** error);
+  Result SyncDiscoveryFilterLocked(const std::string& adapter_path, DiscoveryState* state, bool wait);
+  Result CallAdapterMethod(const std::string& adapter_path, const internal::DeviceMethod& method, GVariant* parameters,
+                           bool wait);
+  void SubscribeLocked();
+  void ResetConnectionLocked();
+
+  static void OnInterfacesRemoved(GDBusConnection* connection, const gchar* sender_name, const gchar* object_path,
+                                  const gchar* interface_name, const gchar* signal_name, GVariant* parameters,
+                                  gpointer user_data);
+  static void OnNameOwnerChanged(GDBusConnection* connection, const gchar* sender_name, const gchar* object_path,
+                                 const gchar* interface_name, const gchar* signal_name, GVariant* parameters,
+                                 gpointer user_data);
+
+  const CallMode call_mode_;
+  const std::string default_adapter_;
+  const RetryPolicy retry_;
+
+  std::mutex mutex_;  // guards connection_ and object_manager_
+  internal::GObjectWrapper::DBusConnection connection_{internal::GObjectWrapper::make_dbus_connection(nullptr)};
+  internal::GObjectWrapper::DBusProxy object_manager_{internal::GObjectWrapper::make_dbus_proxy(nullptr)};
+
+  std::mutex cache_mutex_;  // guards device_proxies_
+  internal::LruCache<std::string, internal::GObjectWrapper::DBusProxy> device_proxies_;
+
+  std::mutex discovery_mutex_;  // guards discovery_, held across the adapter calls
+  std::unordered_map<std::string, DiscoveryState> discovery_;  // by adapter path, only adapters with holders
+
+  std::mutex device_cache_mutex_;  // guards device_cache_
+  DeviceCache::Impl* device_cache_{nullptr};
+
+  std::mutex operations_mutex_;  // guards pending_operations_
+  std::condition_variable operations_done_;
+  size_t pending_operations_{0};
+
+  // Signal and reply dispatch, only touched on the loop thread
+  GMainContext* context_{g_main_context_new()};
+  GMainLoop* loop_{g_main_loop_new(context_, FALSE)};
+  GCancellable* cancellable_{g_cancellable_new()};
+  std::thread loop_thread_;
+  guint interfaces_removed_id_{0};
+  guint name_owner_changed_id_{0};
+};
+
+}  // namespace ble